@@ -0,0 +1,1030 @@
+#include <alpheratz/bitmap/roaring_bitmap.h>
+#include <alpheratz/compress/zstd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define ALPHERATZ_BITMAP_X86 1
+#endif
+
+namespace alpheratz {
+namespace bitmap {
+
+namespace {
+
+// "ALPRBM01" in native byte order, a bitmap from a host of the other order fails it
+constexpr uint64_t kMagic = 0x31304D4252504C41ull;
+// magic, container count, reserved
+constexpr size_t kHeaderSize = 16;
+// key, type, reserved, cardinality, size, offset
+constexpr size_t kDescriptorSize = 16;
+
+constexpr size_t kWords = 1024;
+constexpr uint32_t kArrayMax = 4096;
+
+template <typename T>
+void Append(std::string *out, T value) {
+    out->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+T Read(const char *p) {
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// ops by number, 0 and, 1 or, 2 xor, 3 and not
+template <int kOp>
+inline uint64_t WordOp(uint64_t a, uint64_t b) {
+    switch (kOp) {
+        case 0:
+            return a & b;
+        case 1:
+            return a | b;
+        case 2:
+            return a ^ b;
+        default:
+            return a & ~b;
+    }
+}
+
+// out = a op b over a whole bitset, out may be null to only count. returns the bits set
+template <int kOp>
+uint32_t BitsetOpScalar(const uint64_t *a, const uint64_t *b, uint64_t *out) {
+    uint32_t count = 0;
+    for (size_t i = 0; i < kWords; ++i) {
+        uint64_t word = WordOp<kOp>(a[i], b[i]);
+        if (out != nullptr) out[i] = word;
+        count += __builtin_popcountll(word);
+    }
+    return count;
+}
+
+uint32_t CountBitsScalar(const uint64_t *words) {
+    uint32_t count = 0;
+    for (size_t i = 0; i < kWords; ++i) {
+        count += __builtin_popcountll(words[i]);
+    }
+    return count;
+}
+
+#ifdef ALPHERATZ_BITMAP_X86
+template <int kOp>
+__attribute__((target("avx2,popcnt"), always_inline)) inline __m256i WordOp256(__m256i a,
+                                                                               __m256i b) {
+    switch (kOp) {
+        case 0:
+            return _mm256_and_si256(a, b);
+        case 1:
+            return _mm256_or_si256(a, b);
+        case 2:
+            return _mm256_xor_si256(a, b);
+        default:
+            return _mm256_andnot_si256(b, a);
+    }
+}
+
+template <int kOp>
+__attribute__((target("avx2,popcnt"))) uint32_t BitsetOpAvx2(const uint64_t *a, const uint64_t *b,
+                                                             uint64_t *out) {
+    uint64_t count = 0;
+    for (size_t i = 0; i < kWords; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+        __m256i word = WordOp256<kOp>(x, y);
+        if (out != nullptr) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), word);
+        }
+        count += _mm_popcnt_u64(_mm256_extract_epi64(word, 0)) +
+                 _mm_popcnt_u64(_mm256_extract_epi64(word, 1)) +
+                 _mm_popcnt_u64(_mm256_extract_epi64(word, 2)) +
+                 _mm_popcnt_u64(_mm256_extract_epi64(word, 3));
+    }
+    return static_cast<uint32_t>(count);
+}
+
+__attribute__((target("popcnt"))) uint32_t CountBitsPopcnt(const uint64_t *words) {
+    uint64_t count = 0;
+    for (size_t i = 0; i < kWords; ++i) {
+        count += _mm_popcnt_u64(words[i]);
+    }
+    return static_cast<uint32_t>(count);
+}
+
+bool HasAvx2() {
+    static const bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    return has;
+}
+
+bool HasPopcnt() {
+    static const bool has = __builtin_cpu_supports("popcnt");
+    return has;
+}
+#endif
+
+template <int kOp>
+uint32_t BitsetOp(const uint64_t *a, const uint64_t *b, uint64_t *out) {
+#ifdef ALPHERATZ_BITMAP_X86
+    if (HasAvx2()) {
+        return BitsetOpAvx2<kOp>(a, b, out);
+    }
+#endif
+    return BitsetOpScalar<kOp>(a, b, out);
+}
+
+uint32_t CountBits(const uint64_t *words) {
+#ifdef ALPHERATZ_BITMAP_X86
+    if (HasPopcnt()) {
+        return CountBitsPopcnt(words);
+    }
+#endif
+    return CountBitsScalar(words);
+}
+
+inline bool TestBit(const uint64_t *words, uint32_t low) {
+    return words[low >> 6] >> (low & 63) & 1;
+}
+
+// bits lo..hi inclusive
+void SetBits(uint64_t *words, uint32_t lo, uint32_t hi) {
+    uint32_t first = lo >> 6, last = hi >> 6;
+    uint64_t head = ~0ull << (lo & 63), tail = ~0ull >> (63 - (hi & 63));
+    if (first == last) {
+        words[first] |= head & tail;
+        return;
+    }
+    words[first] |= head;
+    for (uint32_t i = first + 1; i < last; ++i) words[i] = ~0ull;
+    words[last] |= tail;
+}
+
+// sorted set kernels, out must have room for the result
+
+size_t Intersect(const uint16_t *a, size_t na, const uint16_t *b, size_t nb, uint16_t *out) {
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    size_t n = 0;
+    if (na * 32 < nb) {
+        // far smaller side: binary search the rest of the other from the last hit
+        const uint16_t *from = b, *end = b + nb;
+        for (size_t i = 0; i < na && from != end; ++i) {
+            from = std::lower_bound(from, end, a[i]);
+            if (from != end && *from == a[i]) {
+                if (out != nullptr) out[n] = a[i];
+                ++n;
+            }
+        }
+        return n;
+    }
+    size_t i = 0, j = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (a[i] > b[j]) {
+            ++j;
+        } else {
+            if (out != nullptr) out[n] = a[i];
+            ++n;
+            ++i;
+            ++j;
+        }
+    }
+    return n;
+}
+
+size_t Union(const uint16_t *a, size_t na, const uint16_t *b, size_t nb, uint16_t *out) {
+    return std::set_union(a, a + na, b, b + nb, out) - out;
+}
+
+size_t Difference(const uint16_t *a, size_t na, const uint16_t *b, size_t nb, uint16_t *out) {
+    return std::set_difference(a, a + na, b, b + nb, out) - out;
+}
+
+size_t SymmetricDifference(const uint16_t *a, size_t na, const uint16_t *b, size_t nb,
+                           uint16_t *out) {
+    return std::set_symmetric_difference(a, a + na, b, b + nb, out) - out;
+}
+
+}  // namespace
+
+struct RoaringBitmap::Container {
+    enum Type : uint8_t { kArray = 1, kBitset = 2, kRun = 3 };
+
+    Type type = kArray;
+    uint32_t cardinality = 0;
+    // array: sorted values, run: start and length - 1 of every run
+    std::vector<uint16_t> values;
+    // bitset: kWords words
+    std::vector<uint64_t> words;
+    // set by Map, the data is read from there until the container is first changed
+    const uint16_t *mapped_values = nullptr;
+    const uint64_t *mapped_words = nullptr;
+    size_t mapped_size = 0;
+
+    const uint16_t *Values() const {
+        return mapped_values != nullptr ? mapped_values : values.data();
+    }
+    size_t ValueCount() const { return mapped_values != nullptr ? mapped_size : values.size(); }
+    const uint64_t *Words() const { return mapped_words != nullptr ? mapped_words : words.data(); }
+    size_t Runs() const { return ValueCount() / 2; }
+    bool Full() const { return cardinality == 65536; }
+
+    void Own() {
+        if (mapped_values != nullptr) {
+            values.assign(mapped_values, mapped_values + mapped_size);
+            mapped_values = nullptr;
+        }
+        if (mapped_words != nullptr) {
+            words.assign(mapped_words, mapped_words + kWords);
+            mapped_words = nullptr;
+        }
+    }
+
+    static Container Array(std::vector<uint16_t> values) {
+        Container c;
+        c.cardinality = static_cast<uint32_t>(values.size());
+        c.values = std::move(values);
+        return c;
+    }
+
+    // a bitset or, at kArrayMax values or less, an array
+    static Container Bitset(std::vector<uint64_t> words, uint32_t cardinality) {
+        Container c;
+        c.type = kBitset;
+        c.cardinality = cardinality;
+        c.words = std::move(words);
+        c.Normalize();
+        return c;
+    }
+
+    static Container FullRun() {
+        Container c;
+        c.type = kRun;
+        c.cardinality = 65536;
+        c.values = {0, 65535};
+        return c;
+    }
+
+    template <typename Fn>
+    void ForEach(Fn &&fn) const {
+        if (type == kArray) {
+            const uint16_t *v = Values();
+            for (uint32_t i = 0; i < cardinality; ++i) fn(v[i]);
+        } else if (type == kBitset) {
+            const uint64_t *w = Words();
+            for (uint32_t i = 0; i < kWords; ++i) {
+                for (uint64_t word = w[i]; word != 0; word &= word - 1) {
+                    fn(static_cast<uint16_t>(i * 64 + __builtin_ctzll(word)));
+                }
+            }
+        } else {
+            const uint16_t *v = Values();
+            for (size_t r = 0; r < Runs(); ++r) {
+                uint32_t start = v[2 * r], end = start + v[2 * r + 1];
+                for (uint32_t low = start; low <= end; ++low) fn(static_cast<uint16_t>(low));
+            }
+        }
+    }
+
+    // index of the last run starting at or before low, -1 when there is none
+    long RunBefore(uint16_t low) const {
+        const uint16_t *v = Values();
+        long lo = 0, hi = static_cast<long>(Runs()) - 1, found = -1;
+        while (lo <= hi) {
+            long mid = (lo + hi) / 2;
+            if (v[2 * mid] <= low) {
+                found = mid;
+                lo = mid + 1;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        return found;
+    }
+
+    bool Contains(uint16_t low) const {
+        if (type == kArray) {
+            const uint16_t *v = Values();
+            return std::binary_search(v, v + cardinality, low);
+        }
+        if (type == kBitset) {
+            return TestBit(Words(), low);
+        }
+        long run = RunBefore(low);
+        return run >= 0 && low <= Values()[2 * run] + Values()[2 * run + 1];
+    }
+
+    // the first value not less than low, *pos is its array or run index
+    bool FindFrom(uint32_t low, size_t *pos, uint16_t *found) const {
+        if (type == kArray) {
+            const uint16_t *v = Values();
+            *pos = std::lower_bound(v, v + cardinality, low) - v;
+            if (*pos == cardinality) return false;
+            *found = v[*pos];
+            return true;
+        }
+        if (type == kBitset) {
+            const uint64_t *w = Words();
+            size_t i = low >> 6;
+            uint64_t word = w[i] & (~0ull << (low & 63));
+            while (word == 0) {
+                if (++i == kWords) return false;
+                word = w[i];
+            }
+            *found = static_cast<uint16_t>(i * 64 + __builtin_ctzll(word));
+            return true;
+        }
+        const uint16_t *v = Values();
+        long run = RunBefore(static_cast<uint16_t>(low));
+        if (run >= 0 && low <= static_cast<uint32_t>(v[2 * run] + v[2 * run + 1])) {
+            *pos = run;
+            *found = static_cast<uint16_t>(low);
+            return true;
+        }
+        *pos = run + 1;
+        if (*pos == Runs()) return false;
+        *found = v[2 * *pos];
+        return true;
+    }
+
+    void ToBitset() {
+        std::vector<uint64_t> bits(kWords, 0);
+        ForEach([&bits](uint16_t low) { bits[low >> 6] |= 1ull << (low & 63); });
+        values = std::vector<uint16_t>();
+        mapped_values = nullptr;
+        mapped_words = nullptr;
+        words = std::move(bits);
+        type = kBitset;
+    }
+
+    void ToArray() {
+        std::vector<uint16_t> array;
+        array.reserve(cardinality);
+        ForEach([&array](uint16_t low) { array.push_back(low); });
+        words = std::vector<uint64_t>();
+        mapped_values = nullptr;
+        mapped_words = nullptr;
+        values = std::move(array);
+        type = kArray;
+    }
+
+    // a run container becomes whichever of array and bitset fits its cardinality
+    void Expand() {
+        if (cardinality <= kArrayMax) {
+            ToArray();
+        } else {
+            ToBitset();
+        }
+    }
+
+    void Normalize() {
+        if (type == kBitset && cardinality <= kArrayMax) {
+            ToArray();
+        } else if (type == kArray && cardinality > kArrayMax) {
+            ToBitset();
+        }
+    }
+
+    bool Add(uint16_t low) {
+        if (type == kRun) {
+            if (Contains(low)) return false;
+            Expand();
+        }
+        Own();
+        if (type == kArray) {
+            if (values.empty() || values.back() < low) {
+                values.push_back(low);
+            } else {
+                auto it = std::lower_bound(values.begin(), values.end(), low);
+                if (*it == low) return false;
+                values.insert(it, low);
+            }
+            if (++cardinality > kArrayMax) ToBitset();
+            return true;
+        }
+        uint64_t &word = words[low >> 6];
+        uint64_t bit = 1ull << (low & 63);
+        if (word & bit) return false;
+        word |= bit;
+        ++cardinality;
+        return true;
+    }
+
+    bool Remove(uint16_t low) {
+        if (!Contains(low)) return false;
+        if (type == kRun) Expand();
+        Own();
+        --cardinality;
+        if (type == kArray) {
+            values.erase(std::lower_bound(values.begin(), values.end(), low));
+        } else {
+            words[low >> 6] &= ~(1ull << (low & 63));
+            Normalize();
+        }
+        return true;
+    }
+
+    // lo..hi inclusive
+    void AddRange(uint32_t lo, uint32_t hi) {
+        if (lo == 0 && hi == 65535) {
+            *this = FullRun();
+            return;
+        }
+        if (type != kBitset) ToBitset();
+        Own();
+        SetBits(words.data(), lo, hi);
+        cardinality = CountBits(words.data());
+        Normalize();
+    }
+
+    size_t CountRuns() const {
+        if (type == kRun) return Runs();
+        size_t runs = 0;
+        if (type == kArray) {
+            const uint16_t *v = Values();
+            for (uint32_t i = 0; i < cardinality; ++i) {
+                runs += i == 0 || v[i] != v[i - 1] + 1;
+            }
+            return runs;
+        }
+        const uint64_t *w = Words();
+        uint64_t carry = 0;
+        for (size_t i = 0; i < kWords; ++i) {
+            // bits that start a run: set, with the bit below clear
+            runs += __builtin_popcountll(w[i] & ~(w[i] << 1 | carry));
+            carry = w[i] >> 63;
+        }
+        return runs;
+    }
+
+    size_t Bytes() const {
+        return type == kBitset ? kWords * sizeof(uint64_t) : ValueCount() * sizeof(uint16_t);
+    }
+
+    bool RunOptimize() {
+        if (type == kRun) return false;
+        size_t runs = CountRuns();
+        if (runs * 2 * sizeof(uint16_t) >= Bytes()) return false;
+        std::vector<uint16_t> pairs;
+        pairs.reserve(runs * 2);
+        ForEach([&pairs](uint16_t low) {
+            size_t n = pairs.size();
+            if (n > 0 && pairs[n - 2] + pairs[n - 1] + 1 == low) {
+                ++pairs[n - 1];
+            } else {
+                pairs.push_back(low);
+                pairs.push_back(0);
+            }
+        });
+        words = std::vector<uint64_t>();
+        mapped_values = nullptr;
+        mapped_words = nullptr;
+        values = std::move(pairs);
+        type = kRun;
+        return true;
+    }
+
+    // structure of parsed data: sizes, order and cardinality
+    bool Valid() const {
+        if (type == kArray) {
+            if (cardinality == 0 || cardinality > kArrayMax || ValueCount() != cardinality) {
+                return false;
+            }
+            const uint16_t *v = Values();
+            for (uint32_t i = 1; i < cardinality; ++i) {
+                if (v[i] <= v[i - 1]) return false;
+            }
+            return true;
+        }
+        if (type == kBitset) {
+            return cardinality > 0 && CountBits(Words()) == cardinality;
+        }
+        if (ValueCount() == 0 || ValueCount() % 2 != 0) return false;
+        const uint16_t *v = Values();
+        uint64_t total = 0;
+        long prev_end = -1;
+        for (size_t r = 0; r < Runs(); ++r) {
+            long start = v[2 * r], end = start + v[2 * r + 1];
+            if (start <= prev_end || end > 65535) return false;
+            total += end - start + 1;
+            prev_end = end;
+        }
+        return total == cardinality;
+    }
+
+    // counts first, so a small result is written as an array straight away
+    template <int kOp>
+    static Container BitsetCombine(const uint64_t *a, const uint64_t *b) {
+        uint32_t count = BitsetOp<kOp>(a, b, nullptr);
+        if (count > kArrayMax) {
+            std::vector<uint64_t> out(kWords);
+            BitsetOp<kOp>(a, b, out.data());
+            return Bitset(std::move(out), count);
+        }
+        std::vector<uint16_t> out;
+        out.reserve(count);
+        for (uint32_t i = 0; i < kWords; ++i) {
+            for (uint64_t word = WordOp<kOp>(a[i], b[i]); word != 0; word &= word - 1) {
+                out.push_back(static_cast<uint16_t>(i * 64 + __builtin_ctzll(word)));
+            }
+        }
+        return Array(std::move(out));
+    }
+
+    // run containers take part in binary ops as array or bitset
+    static const Container &Plain(const Container &c, Container *scratch) {
+        if (c.type != kRun) return c;
+        *scratch = c;
+        scratch->Expand();
+        return *scratch;
+    }
+
+    static uint32_t AndCount(const Container &a, const Container &b) {
+        if (a.Full()) return b.cardinality;
+        if (b.Full()) return a.cardinality;
+        Container scratch_a, scratch_b;
+        const Container &x = Plain(a, &scratch_a), &y = Plain(b, &scratch_b);
+        if (x.type == kArray && y.type == kArray) {
+            return static_cast<uint32_t>(
+                Intersect(x.Values(), x.cardinality, y.Values(), y.cardinality, nullptr));
+        }
+        if (x.type == kBitset && y.type == kBitset) {
+            return BitsetOp<0>(x.Words(), y.Words(), nullptr);
+        }
+        const Container &array = x.type == kArray ? x : y;
+        const uint64_t *bits = x.type == kArray ? y.Words() : x.Words();
+        uint32_t count = 0;
+        array.ForEach([&](uint16_t low) { count += TestBit(bits, low); });
+        return count;
+    }
+
+    // a op b, empty when nothing is left
+    static Container Combine(const Container &a, const Container &b, Op op) {
+        if (op == Op::kAnd && (a.Full() || b.Full())) return a.Full() ? b : a;
+        if (op == Op::kOr && (a.Full() || b.Full())) return FullRun();
+        Container scratch_a, scratch_b;
+        const Container &x = Plain(a, &scratch_a), &y = Plain(b, &scratch_b);
+        if (x.type == kArray && y.type == kArray) {
+            std::vector<uint16_t> out(op == Op::kAnd      ? std::min(x.cardinality, y.cardinality)
+                                      : op == Op::kAndNot ? x.cardinality
+                                                          : x.cardinality + y.cardinality);
+            size_t n;
+            switch (op) {
+                case Op::kAnd:
+                    n = Intersect(x.Values(), x.cardinality, y.Values(), y.cardinality,
+                                  out.data());
+                    break;
+                case Op::kOr:
+                    n = Union(x.Values(), x.cardinality, y.Values(), y.cardinality, out.data());
+                    break;
+                case Op::kXor:
+                    n = SymmetricDifference(x.Values(), x.cardinality, y.Values(),
+                                            y.cardinality, out.data());
+                    break;
+                default:
+                    n = Difference(x.Values(), x.cardinality, y.Values(), y.cardinality,
+                                   out.data());
+                    break;
+            }
+            out.resize(n);
+            Container c = Array(std::move(out));
+            c.Normalize();
+            return c;
+        }
+        if (x.type == kBitset && y.type == kBitset) {
+            switch (op) {
+                case Op::kAnd:
+                    return BitsetCombine<0>(x.Words(), y.Words());
+                case Op::kOr:
+                    return BitsetCombine<1>(x.Words(), y.Words());
+                case Op::kXor:
+                    return BitsetCombine<2>(x.Words(), y.Words());
+                default:
+                    return BitsetCombine<3>(x.Words(), y.Words());
+            }
+        }
+        // an array and a bitset
+        const Container &array = x.type == kArray ? x : y;
+        const Container &bitset = x.type == kArray ? y : x;
+        const uint64_t *bits = bitset.Words();
+        if (op == Op::kAnd || (op == Op::kAndNot && x.type == kArray)) {
+            // the array filtered by the bitset
+            bool keep = op == Op::kAnd;
+            std::vector<uint16_t> out;
+            out.reserve(array.cardinality);
+            array.ForEach([&](uint16_t low) {
+                if (TestBit(bits, low) == keep) out.push_back(low);
+            });
+            return Array(std::move(out));
+        }
+        // the bitset with the array's bits set, flipped or cleared
+        std::vector<uint64_t> out(bits, bits + kWords);
+        uint32_t count = bitset.cardinality;
+        array.ForEach([&](uint16_t low) {
+            uint64_t &word = out[low >> 6];
+            uint64_t bit = 1ull << (low & 63);
+            bool set = word & bit;
+            if (op == Op::kOr) {
+                count += !set;
+                word |= bit;
+            } else if (op == Op::kXor) {
+                count = set ? count - 1 : count + 1;
+                word ^= bit;
+            } else {
+                count -= set;
+                word &= ~bit;
+            }
+        });
+        return Bitset(std::move(out), count);
+    }
+};
+
+RoaringBitmap::RoaringBitmap() = default;
+RoaringBitmap::~RoaringBitmap() = default;
+RoaringBitmap::RoaringBitmap(const RoaringBitmap &other) = default;
+RoaringBitmap::RoaringBitmap(RoaringBitmap &&other) noexcept = default;
+RoaringBitmap &RoaringBitmap::operator=(const RoaringBitmap &other) = default;
+RoaringBitmap &RoaringBitmap::operator=(RoaringBitmap &&other) noexcept = default;
+
+RoaringBitmap RoaringBitmap::Of(const std::vector<uint32_t> &values) {
+    RoaringBitmap bitmap;
+    bitmap.AddMany(values.data(), values.size());
+    return bitmap;
+}
+
+size_t RoaringBitmap::LowerBound(uint16_t key) const {
+    return std::lower_bound(keys_.begin(), keys_.end(), key) - keys_.begin();
+}
+
+RoaringBitmap::Container &RoaringBitmap::Get(uint16_t key) {
+    // values mostly arrive in order, so try the last container first
+    if (!keys_.empty() && keys_.back() == key) return containers_.back();
+    size_t index = LowerBound(key);
+    if (index == keys_.size() || keys_[index] != key) {
+        keys_.insert(keys_.begin() + index, key);
+        containers_.insert(containers_.begin() + index, Container());
+    }
+    return containers_[index];
+}
+
+void RoaringBitmap::Erase(size_t index) {
+    keys_.erase(keys_.begin() + index);
+    containers_.erase(containers_.begin() + index);
+}
+
+void RoaringBitmap::Add(uint32_t value) { Get(value >> 16).Add(value & 0xFFFF); }
+
+void RoaringBitmap::AddMany(const uint32_t *values, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        uint16_t key = values[i] >> 16;
+        Container &c = Get(key);
+        for (; i < count && values[i] >> 16 == key; ++i) {
+            c.Add(values[i] & 0xFFFF);
+        }
+    }
+}
+
+void RoaringBitmap::AddRange(uint64_t begin, uint64_t end) {
+    end = std::min<uint64_t>(end, 1ull << 32);
+    if (begin >= end) return;
+    uint32_t first = begin >> 16, last = (end - 1) >> 16;
+    for (uint32_t key = first; key <= last; ++key) {
+        uint32_t lo = key == first ? begin & 0xFFFF : 0;
+        uint32_t hi = key == last ? (end - 1) & 0xFFFF : 0xFFFF;
+        Get(static_cast<uint16_t>(key)).AddRange(lo, hi);
+    }
+}
+
+bool RoaringBitmap::Remove(uint32_t value) {
+    size_t index = LowerBound(value >> 16);
+    if (index == keys_.size() || keys_[index] != value >> 16) return false;
+    if (!containers_[index].Remove(value & 0xFFFF)) return false;
+    if (containers_[index].cardinality == 0) Erase(index);
+    return true;
+}
+
+bool RoaringBitmap::Contains(uint32_t value) const {
+    size_t index = LowerBound(value >> 16);
+    return index < keys_.size() && keys_[index] == value >> 16 &&
+           containers_[index].Contains(value & 0xFFFF);
+}
+
+void RoaringBitmap::Clear() {
+    keys_.clear();
+    containers_.clear();
+}
+
+uint64_t RoaringBitmap::Cardinality() const {
+    uint64_t total = 0;
+    for (const Container &c : containers_) total += c.cardinality;
+    return total;
+}
+
+bool RoaringBitmap::Empty() const { return containers_.empty(); }
+
+bool RoaringBitmap::RunOptimize() {
+    bool changed = false;
+    for (Container &c : containers_) {
+        changed |= c.RunOptimize();
+    }
+    return changed;
+}
+
+size_t RoaringBitmap::BytesUsed() const {
+    size_t bytes = sizeof(*this) + keys_.capacity() * sizeof(uint16_t) +
+                   containers_.capacity() * sizeof(Container);
+    for (const Container &c : containers_) {
+        bytes += c.values.capacity() * sizeof(uint16_t) + c.words.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+template <typename Left>
+RoaringBitmap RoaringBitmap::Apply(Left &&a, const RoaringBitmap &b, Op op) {
+    // keys only in a survive all but and, keys only in b join for or and xor. containers
+    // kept from a are moved when a is an rvalue
+    bool keep_a = op != Op::kAnd;
+    bool take_b = op == Op::kOr || op == Op::kXor;
+    RoaringBitmap result;
+    result.keys_.reserve(keep_a ? a.keys_.size() + (take_b ? b.keys_.size() : 0)
+                                : std::min(a.keys_.size(), b.keys_.size()));
+    result.containers_.reserve(result.keys_.capacity());
+    size_t i = 0, j = 0;
+    while (i < a.keys_.size() || j < b.keys_.size()) {
+        if (j == b.keys_.size() || (i < a.keys_.size() && a.keys_[i] < b.keys_[j])) {
+            if (keep_a) {
+                result.keys_.push_back(a.keys_[i]);
+                if constexpr (std::is_lvalue_reference<Left>::value) {
+                    result.containers_.push_back(a.containers_[i]);
+                } else {
+                    result.containers_.push_back(std::move(a.containers_[i]));
+                }
+            }
+            ++i;
+        } else if (i == a.keys_.size() || b.keys_[j] < a.keys_[i]) {
+            if (take_b) {
+                result.keys_.push_back(b.keys_[j]);
+                result.containers_.push_back(b.containers_[j]);
+            }
+            ++j;
+        } else {
+            Container c = Container::Combine(a.containers_[i], b.containers_[j], op);
+            if (c.cardinality > 0) {
+                result.keys_.push_back(a.keys_[i]);
+                result.containers_.push_back(std::move(c));
+            }
+            ++i;
+            ++j;
+        }
+    }
+    return result;
+}
+
+RoaringBitmap &RoaringBitmap::operator&=(const RoaringBitmap &other) {
+    *this = Apply(std::move(*this), other, Op::kAnd);
+    return *this;
+}
+
+RoaringBitmap &RoaringBitmap::operator|=(const RoaringBitmap &other) {
+    *this = Apply(std::move(*this), other, Op::kOr);
+    return *this;
+}
+
+RoaringBitmap &RoaringBitmap::operator^=(const RoaringBitmap &other) {
+    *this = Apply(std::move(*this), other, Op::kXor);
+    return *this;
+}
+
+RoaringBitmap &RoaringBitmap::operator-=(const RoaringBitmap &other) {
+    *this = Apply(std::move(*this), other, Op::kAndNot);
+    return *this;
+}
+
+uint64_t RoaringBitmap::AndCardinality(const RoaringBitmap &other) const {
+    uint64_t total = 0;
+    size_t i = 0, j = 0;
+    while (i < keys_.size() && j < other.keys_.size()) {
+        if (keys_[i] < other.keys_[j]) {
+            ++i;
+        } else if (keys_[i] > other.keys_[j]) {
+            ++j;
+        } else {
+            total += Container::AndCount(containers_[i++], other.containers_[j++]);
+        }
+    }
+    return total;
+}
+
+bool RoaringBitmap::operator==(const RoaringBitmap &other) const {
+    if (keys_ != other.keys_) return false;
+    for (size_t i = 0; i < containers_.size(); ++i) {
+        const Container &a = containers_[i], &b = other.containers_[i];
+        if (a.cardinality != b.cardinality ||
+            Container::AndCount(a, b) != a.cardinality) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<uint32_t> RoaringBitmap::ToVector() const {
+    std::vector<uint32_t> out;
+    out.reserve(Cardinality());
+    for (size_t i = 0; i < containers_.size(); ++i) {
+        uint32_t high = static_cast<uint32_t>(keys_[i]) << 16;
+        containers_[i].ForEach([&out, high](uint16_t low) { out.push_back(high | low); });
+    }
+    return out;
+}
+
+RoaringBitmap::Iterator::Iterator(const RoaringBitmap *bitmap) : bitmap_(bitmap) {
+    SeekToFirst();
+}
+
+void RoaringBitmap::Iterator::Seek(uint32_t target) {
+    uint16_t key = target >> 16;
+    index_ = bitmap_->LowerBound(key);
+    bool same = index_ < bitmap_->keys_.size() && bitmap_->keys_[index_] == key;
+    Load(same ? target & 0xFFFF : 0);
+}
+
+void RoaringBitmap::Iterator::Load(uint32_t low) {
+    while (index_ < bitmap_->containers_.size()) {
+        uint16_t found;
+        if (low <= 0xFFFF && bitmap_->containers_[index_].FindFrom(low, &pos_, &found)) {
+            value_ = static_cast<uint32_t>(bitmap_->keys_[index_]) << 16 | found;
+            valid_ = true;
+            return;
+        }
+        ++index_;
+        low = 0;
+    }
+    valid_ = false;
+}
+
+void RoaringBitmap::Iterator::Next() {
+    const Container &c = bitmap_->containers_[index_];
+    uint32_t high = value_ & 0xFFFF0000u, low = value_ & 0xFFFF;
+    if (c.type == Container::kArray) {
+        if (++pos_ < c.cardinality) {
+            value_ = high | c.Values()[pos_];
+            return;
+        }
+    } else if (c.type == Container::kRun) {
+        const uint16_t *v = c.Values();
+        if (low < static_cast<uint32_t>(v[2 * pos_] + v[2 * pos_ + 1])) {
+            ++value_;
+            return;
+        }
+        if (++pos_ < c.Runs()) {
+            value_ = high | v[2 * pos_];
+            return;
+        }
+    } else {
+        Load(low + 1);
+        return;
+    }
+    ++index_;
+    Load(0);
+}
+
+size_t RoaringBitmap::SerializedSize() const {
+    size_t size = kHeaderSize + containers_.size() * kDescriptorSize;
+    for (const Container &c : containers_) {
+        size += (c.Bytes() + 7) / 8 * 8;
+    }
+    return size;
+}
+
+void RoaringBitmap::Serialize(std::string *out) const {
+    out->clear();
+    out->reserve(SerializedSize());
+    Append<uint64_t>(out, kMagic);
+    Append<uint32_t>(out, static_cast<uint32_t>(containers_.size()));
+    Append<uint32_t>(out, 0);
+    size_t offset = kHeaderSize + containers_.size() * kDescriptorSize;
+    for (size_t i = 0; i < containers_.size(); ++i) {
+        const Container &c = containers_[i];
+        Append<uint16_t>(out, keys_[i]);
+        Append<uint8_t>(out, c.type);
+        Append<uint8_t>(out, 0);
+        Append<uint32_t>(out, c.cardinality);
+        Append<uint32_t>(out, static_cast<uint32_t>(c.type == Container::kBitset ? kWords
+                                                                                 : c.ValueCount()));
+        Append<uint32_t>(out, static_cast<uint32_t>(offset));
+        offset += (c.Bytes() + 7) / 8 * 8;
+    }
+    for (const Container &c : containers_) {
+        if (c.type == Container::kBitset) {
+            out->append(reinterpret_cast<const char *>(c.Words()), c.Bytes());
+        } else {
+            out->append(reinterpret_cast<const char *>(c.Values()), c.Bytes());
+        }
+        out->append((8 - c.Bytes() % 8) % 8, '\0');
+    }
+}
+
+absl::StatusOr<RoaringBitmap> RoaringBitmap::Parse(absl::string_view data, bool map,
+                                                   bool verify) {
+    auto corrupted = []() { return absl::DataLossError("not a roaring bitmap or corrupted"); };
+    if (data.size() < kHeaderSize || Read<uint64_t>(data.data()) != kMagic) {
+        return corrupted();
+    }
+    uint64_t count = Read<uint32_t>(data.data() + 8);
+    if (count > 65536 || kHeaderSize + count * kDescriptorSize > data.size()) {
+        return corrupted();
+    }
+    RoaringBitmap bitmap;
+    bitmap.keys_.reserve(count);
+    bitmap.containers_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const char *d = data.data() + kHeaderSize + i * kDescriptorSize;
+        uint16_t key = Read<uint16_t>(d);
+        uint8_t type = Read<uint8_t>(d + 2);
+        uint64_t size = Read<uint32_t>(d + 8);
+        uint64_t offset = Read<uint32_t>(d + 12);
+        if ((i > 0 && key <= bitmap.keys_.back()) || type < Container::kArray ||
+            type > Container::kRun || (type == Container::kBitset && size != kWords)) {
+            return corrupted();
+        }
+        uint64_t bytes = size * (type == Container::kBitset ? 8 : 2);
+        if (offset % 8 != 0 || offset > data.size() || bytes > data.size() - offset) {
+            return corrupted();
+        }
+        Container c;
+        c.type = static_cast<Container::Type>(type);
+        c.cardinality = Read<uint32_t>(d + 4);
+        const char *p = data.data() + offset;
+        if (type == Container::kBitset) {
+            if (map) {
+                c.mapped_words = reinterpret_cast<const uint64_t *>(p);
+            } else {
+                c.words.resize(kWords);
+                std::memcpy(c.words.data(), p, bytes);
+            }
+        } else if (map && size > 0) {
+            c.mapped_values = reinterpret_cast<const uint16_t *>(p);
+            c.mapped_size = size;
+        } else {
+            c.values.resize(size);
+            std::memcpy(c.values.data(), p, bytes);
+        }
+        if (verify && !c.Valid()) {
+            return corrupted();
+        }
+        bitmap.keys_.push_back(key);
+        bitmap.containers_.push_back(std::move(c));
+    }
+    return bitmap;
+}
+
+absl::StatusOr<RoaringBitmap> RoaringBitmap::Deserialize(absl::string_view data) {
+    return Parse(data, false, true);
+}
+
+absl::StatusOr<RoaringBitmap> RoaringBitmap::Map(absl::string_view data, bool verify) {
+    return Parse(data, reinterpret_cast<uintptr_t>(data.data()) % 8 == 0, verify);
+}
+
+absl::Status RoaringBitmap::SerializeCompressed(std::vector<uint8_t> *out) const {
+    std::string data;
+    Serialize(&data);
+    std::vector<uint8_t> in(data.begin(), data.end());
+    return compress::CompressZstd(in, *out);
+}
+
+absl::StatusOr<RoaringBitmap> RoaringBitmap::DeserializeCompressed(std::vector<uint8_t> &in) {
+    std::vector<uint8_t> data;
+    absl::Status status = compress::UnCompressZstd(in, data);
+    if (!status.ok()) {
+        return status;
+    }
+    return Deserialize(
+        absl::string_view(reinterpret_cast<const char *>(data.data()), data.size()));
+}
+
+RoaringBitmap operator&(const RoaringBitmap &a, const RoaringBitmap &b) {
+    return RoaringBitmap::Apply(a, b, RoaringBitmap::Op::kAnd);
+}
+
+RoaringBitmap operator|(const RoaringBitmap &a, const RoaringBitmap &b) {
+    return RoaringBitmap::Apply(a, b, RoaringBitmap::Op::kOr);
+}
+
+RoaringBitmap operator^(const RoaringBitmap &a, const RoaringBitmap &b) {
+    return RoaringBitmap::Apply(a, b, RoaringBitmap::Op::kXor);
+}
+
+RoaringBitmap operator-(const RoaringBitmap &a, const RoaringBitmap &b) {
+    return RoaringBitmap::Apply(a, b, RoaringBitmap::Op::kAndNot);
+}
+
+}  // namespace bitmap
+}  // namespace alpheratz
@@ -0,0 +1,68 @@
+#include <alpheratz/cache/frequency_sketch.h>
+
+#include <algorithm>
+
+namespace alpheratz {
+namespace cache {
+
+namespace {
+
+// odd multipliers giving every row its own view of the hash
+constexpr uint64_t kRowSeeds[] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full,
+                                  0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull};
+
+}  // namespace
+
+FrequencySketch::FrequencySketch(size_t capacity) {
+    size_t width = kCountersPerWord;
+    width_bits_ = 4;
+    while (width < capacity) {
+        width <<= 1;
+        ++width_bits_;
+    }
+    row_words_ = width / kCountersPerWord;
+    table_.assign(row_words_ * kRows, 0);
+    sample_size_ = width * 10;
+}
+
+size_t FrequencySketch::Index(uint64_t hash, int row) const {
+    uint64_t mixed = (hash ^ (hash >> 29)) * kRowSeeds[row];
+    return static_cast<size_t>(mixed >> (64 - width_bits_));
+}
+
+void FrequencySketch::Increment(uint64_t hash) {
+    bool added = false;
+    for (int row = 0; row < kRows; ++row) {
+        size_t counter = Index(hash, row);
+        uint64_t &word = table_[row * row_words_ + counter / kCountersPerWord];
+        int shift = static_cast<int>(counter % kCountersPerWord) * 4;
+        if (((word >> shift) & 0xF) != 0xF) {
+            word += uint64_t(1) << shift;
+            added = true;
+        }
+    }
+    if (added && ++additions_ >= sample_size_) {
+        Halve();
+    }
+}
+
+uint32_t FrequencySketch::Estimate(uint64_t hash) const {
+    uint32_t estimate = 0xF;
+    for (int row = 0; row < kRows; ++row) {
+        size_t counter = Index(hash, row);
+        uint64_t word = table_[row * row_words_ + counter / kCountersPerWord];
+        int shift = static_cast<int>(counter % kCountersPerWord) * 4;
+        estimate = std::min(estimate, static_cast<uint32_t>((word >> shift) & 0xF));
+    }
+    return estimate;
+}
+
+void FrequencySketch::Halve() {
+    for (uint64_t &word : table_) {
+        word = (word >> 1) & 0x7777777777777777ull;
+    }
+    additions_ /= 2;
+}
+
+}  // namespace cache
+}  // namespace alpheratz
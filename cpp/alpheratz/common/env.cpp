@@ -2,18 +2,25 @@
 
 #include <cstdlib>
 #include <string>
-#include <string_view>
 
 namespace alpheratz {
 namespace common {
 namespace env {
 
-std::string_view GetEnv(const std::string &key, const std::string &def) {
+std::string GetEnv(const std::string &key, const std::string &def) {
     const char *var = getenv(key.c_str());
     if (var == nullptr) {
         return def;
     }
-    return std::string_view(var);
+    return std::string(var);
+}
+
+absl::optional<std::string> LookupEnv(const std::string &key) {
+    const char *var = getenv(key.c_str());
+    if (var == nullptr) {
+        return absl::nullopt;
+    }
+    return std::string(var);
 }
 
 }  // namespace env
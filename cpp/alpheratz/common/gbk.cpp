@@ -0,0 +1,202 @@
+#include <alpheratz/common/gbk.h>
+#include <alpheratz/common/locale.h>
+#include <iconv.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace alpheratz {
+namespace common {
+namespace locale {
+
+namespace {
+
+constexpr unsigned kLeadFirst = 0x81;
+constexpr unsigned kLeadLast = 0xfe;
+constexpr unsigned kTrailFirst = 0x40;
+constexpr unsigned kTrailLast = 0xfe;
+constexpr size_t kTrails = kTrailLast - kTrailFirst + 1;
+// output slack kept past the worst case of the remaining input decoded as ascii
+constexpr size_t kSlack = 32;
+
+// code points of the bmp, 0 where the code is not one or two bytes or needs iconv
+struct GbkTable {
+    uint16_t single[0x80];
+    uint16_t pair[(kLeadLast - kLeadFirst + 1) * kTrails];
+};
+
+// code point of exactly one char in bytes, 0 otherwise
+uint32_t Probe(iconv_t cd, const char *bytes, size_t size) {
+    iconv(cd, nullptr, nullptr, nullptr, nullptr);
+    char *in = const_cast<char *>(bytes);
+    size_t in_left = size;
+    unsigned char utf32[8];
+    char *out = reinterpret_cast<char *>(utf32);
+    size_t out_left = sizeof(utf32);
+    if (iconv(cd, &in, &in_left, &out, &out_left) == static_cast<size_t>(-1) ||
+        in_left != 0 || out_left != sizeof(utf32) - 4) {
+        return 0;
+    }
+    return static_cast<uint32_t>(utf32[0]) | static_cast<uint32_t>(utf32[1]) << 8 |
+           static_cast<uint32_t>(utf32[2]) << 16 | static_cast<uint32_t>(utf32[3]) << 24;
+}
+
+uint16_t TableValue(uint32_t code_point) {
+    return code_point <= 0xffff ? static_cast<uint16_t>(code_point) : 0;
+}
+
+void BuildTable(const char *charset, GbkTable *table) {
+    std::memset(table, 0, sizeof(*table));
+    UniqueIconv cd(iconv_open("UTF-32LE", charset));
+    if (!cd.Valid()) {
+        // everything then goes through iconv, which reports the same failure
+        return;
+    }
+    char bytes[2];
+    for (unsigned b = 0x80; b <= 0xff; ++b) {
+        bytes[0] = static_cast<char>(b);
+        table->single[b - 0x80] = TableValue(Probe(cd.Get(), bytes, 1));
+    }
+    for (unsigned lead = kLeadFirst; lead <= kLeadLast; ++lead) {
+        if (table->single[lead - 0x80] != 0) continue;
+        bytes[0] = static_cast<char>(lead);
+        for (unsigned trail = kTrailFirst; trail <= kTrailLast; ++trail) {
+            bytes[1] = static_cast<char>(trail);
+            table->pair[(lead - kLeadFirst) * kTrails + trail - kTrailFirst] =
+                TableValue(Probe(cd.Get(), bytes, 2));
+        }
+    }
+}
+
+const GbkTable &Table(GbkCharset charset) {
+    static GbkTable tables[2];
+    static std::once_flag once[2];
+    size_t index = charset == GbkCharset::kGb18030 ? 1 : 0;
+    std::call_once(once[index], [index]() {
+        BuildTable(index == 1 ? "GB18030" : "GBK", &tables[index]);
+    });
+    return tables[index];
+}
+
+inline char *EmitUtf8(char *dst, uint32_t code_point) {
+    if (code_point < 0x80) {
+        *dst++ = static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        *dst++ = static_cast<char>(0xc0 | code_point >> 6);
+        *dst++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    } else {
+        *dst++ = static_cast<char>(0xe0 | code_point >> 12);
+        *dst++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3f));
+        *dst++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+    return dst;
+}
+
+// copy the ascii run at src, dst must have room for all of it plus 16 bytes
+inline size_t CopyAscii(const unsigned char *src, size_t size, char *dst) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    while (size - i >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), v);
+        int mask = _mm_movemask_epi8(v);
+        if (mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+        }
+        i += 16;
+    }
+#else
+    while (size - i >= 8) {
+        uint64_t word;
+        std::memcpy(&word, src + i, sizeof(word));
+        std::memcpy(dst + i, &word, sizeof(word));
+        if (word & 0x8080808080808080ULL) break;
+        i += 8;
+    }
+#endif
+    while (i < size && src[i] < 0x80) {
+        dst[i] = static_cast<char>(src[i]);
+        ++i;
+    }
+    return i;
+}
+
+// bytes iconv has to see for the code starting at src
+size_t SequenceSize(const unsigned char *src, size_t size) {
+    if (src[0] < kLeadFirst || src[0] > kLeadLast || size < 2) {
+        return 1;
+    }
+    if (src[1] >= '0' && src[1] <= '9') {
+        return std::min<size_t>(4, size);
+    }
+    return 2;
+}
+
+}  // namespace
+
+absl::Status GbkToUtf8(absl::string_view in, std::string *out, GbkCharset charset) {
+    const GbkTable &table = Table(charset);
+    const auto *src = reinterpret_cast<const unsigned char *>(in.data());
+    const size_t n = in.size();
+    out->resize(n + n / 2 + kSlack);
+    char *dst = &(*out)[0];
+    char *end = dst + out->size();
+    std::string fallback;
+    size_t i = 0;
+    while (i < n) {
+        // room for the rest as ascii plus the widest code, 4 bytes from at least 1
+        if (static_cast<size_t>(end - dst) < n - i + kSlack) {
+            size_t used = dst - out->data();
+            out->resize(used + (n - i) * 2 + kSlack);
+            dst = &(*out)[0] + used;
+            end = &(*out)[0] + out->size();
+        }
+        if (src[i] < 0x80) {
+            size_t run = CopyAscii(src + i, n - i, dst);
+            dst += run;
+            i += run;
+            continue;
+        }
+        uint16_t code_point = table.single[src[i] - 0x80];
+        if (code_point != 0) {
+            dst = EmitUtf8(dst, code_point);
+            ++i;
+            continue;
+        }
+        if (src[i] >= kLeadFirst && src[i] <= kLeadLast && i + 1 < n &&
+            src[i + 1] >= kTrailFirst && src[i + 1] <= kTrailLast) {
+            code_point = table.pair[(src[i] - kLeadFirst) * kTrails + src[i + 1] - kTrailFirst];
+            if (code_point != 0) {
+                dst = EmitUtf8(dst, code_point);
+                i += 2;
+                continue;
+            }
+        }
+        size_t size = SequenceSize(src + i, n - i);
+        auto transcoder =
+            Transcoder::Create("UTF-8", charset == GbkCharset::kGb18030 ? "GB18030" : "GBK");
+        absl::Status status = transcoder.ok()
+                                  ? transcoder->Convert(in.substr(i, size), &fallback)
+                                  : transcoder.status();
+        if (!status.ok() || fallback.size() > kSlack) {
+            out->resize(dst - out->data());
+            return absl::InvalidArgumentError("invalid multibyte sequence at offset " +
+                                              std::to_string(i));
+        }
+        std::memcpy(dst, fallback.data(), fallback.size());
+        dst += fallback.size();
+        i += size;
+    }
+    out->resize(dst - out->data());
+    return absl::OkStatus();
+}
+
+}  // namespace locale
+}  // namespace common
+}  // namespace alpheratz
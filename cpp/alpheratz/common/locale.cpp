@@ -1,38 +1,246 @@
+#include <absl/container/flat_hash_map.h>
+#include <alpheratz/common/gbk.h>
 #include <alpheratz/common/locale.h>
 #include <iconv.h>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace alpheratz {
 namespace common {
 namespace locale {
 
+namespace {
+
+// idle handles kept per encoding pair and thread
+constexpr size_t kPoolPerPair = 4;
+
+// set once the pool of this thread is destroyed, handles released later are closed
+thread_local bool pool_destroyed = false;
+
+struct HandlePool {
+    ~HandlePool() { pool_destroyed = true; }
+
+    absl::flat_hash_map<std::string, std::vector<UniqueIconv>> idle;
+};
+
+HandlePool& Pool() {
+    thread_local HandlePool pool;
+    return pool;
+}
+
+// a handle not taken back by the pool is closed when cd goes out of scope
+void Release(const std::string& key, UniqueIconv cd) {
+    if (pool_destroyed) {
+        return;
+    }
+    std::vector<UniqueIconv>& idle = Pool().idle[key];
+    if (idle.size() >= kPoolPerPair) {
+        return;
+    }
+    // back to the initial shift state for the next user
+    iconv(cd.Get(), nullptr, nullptr, nullptr, nullptr);
+    idle.push_back(std::move(cd));
+}
+
+// iconv over the whole input, 0 when it is used up, otherwise the errno that stopped it
+int Step(iconv_t cd, const char** in, size_t* in_left, char** out, size_t* out_left) {
+    while (*in_left > 0) {
+        if (iconv(cd, const_cast<char**>(in), in_left, out, out_left) != static_cast<size_t>(-1)) {
+            continue;
+        }
+        return errno;
+    }
+    return 0;
+}
+
+absl::Status StepError(int error, size_t offset) {
+    if (error == EILSEQ) {
+        return absl::InvalidArgumentError("invalid multibyte sequence at offset " +
+                                          std::to_string(offset));
+    }
+    return absl::InternalError(std::string("iconv: ") + std::strerror(error));
+}
+
+}  // namespace
+
 // gbk 2 bytes
 // utf-8 1-6 bytes, utf-8
 // utf-8 max 3 times outbuf of gbk size
 int ConvertGbk2Utf8(const std::string& gbk_content, std::string& out) {
-    iconv_t cd = iconv_open("UTF-8", "GBK");
-    if (cd == (iconv_t)-1) {
-        std::cerr << "Error opening iconv!" << std::endl;
+    if (!GbkToUtf8(gbk_content, &out, GbkCharset::kGbk).ok()) {
+        std::cerr << "Error converting encoding!" << std::endl;
         return -1;
     }
-    size_t in_size = gbk_content.size();
-    size_t utf8_len = in_size * 4;
-    size_t out_size = utf8_len;
-    out.resize(utf8_len);
-    char* inbuf = const_cast<char*>(gbk_content.c_str());
-    char* outbuf = out.data();
+    return 0;
+}
+
+absl::StatusOr<Transcoder> Transcoder::Create(absl::string_view to, absl::string_view from) {
+    std::string to_name(to.data(), to.size());
+    std::string from_name(from.data(), from.size());
+    std::string key = to_name + '\0' + from_name;
+    if (!pool_destroyed) {
+        auto it = Pool().idle.find(key);
+        if (it != Pool().idle.end() && !it->second.empty()) {
+            UniqueIconv cd = std::move(it->second.back());
+            it->second.pop_back();
+            return Transcoder(std::move(key), std::move(cd));
+        }
+    }
+    UniqueIconv cd(iconv_open(to_name.c_str(), from_name.c_str()));
+    if (!cd.Valid()) {
+        return absl::InvalidArgumentError("iconv_open " + from_name + " to " + to_name + ": " +
+                                          std::strerror(errno));
+    }
+    return Transcoder(std::move(key), std::move(cd));
+}
+
+Transcoder::Transcoder(Transcoder&& other) noexcept
+    : key_(std::move(other.key_)), cd_(std::move(other.cd_)), pending_size_(other.pending_size_) {
+    std::memcpy(pending_, other.pending_, pending_size_);
+    other.pending_size_ = 0;
+}
+
+Transcoder& Transcoder::operator=(Transcoder&& other) noexcept {
+    if (this != &other) {
+        if (cd_.Valid()) {
+            Release(key_, std::move(cd_));
+        }
+        key_ = std::move(other.key_);
+        cd_ = std::move(other.cd_);
+        pending_size_ = other.pending_size_;
+        std::memcpy(pending_, other.pending_, pending_size_);
+        other.pending_size_ = 0;
+    }
+    return *this;
+}
+
+Transcoder::~Transcoder() {
+    if (cd_.Valid()) {
+        Release(key_, std::move(cd_));
+    }
+}
+
+void Transcoder::Reset() {
+    iconv(cd_.Get(), nullptr, nullptr, nullptr, nullptr);
+    pending_size_ = 0;
+}
+
+absl::Status Transcoder::UpdatePending(absl::string_view chunk, char** out, size_t* out_left,
+                                       size_t* consumed) {
+    // complete the held sequence with the head of chunk in a scratch buffer
+    char scratch[kMaxPending * 2];
+    size_t take = std::min(chunk.size(), kMaxPending);
+    std::memcpy(scratch, pending_, pending_size_);
+    std::memcpy(scratch + pending_size_, chunk.data(), take);
+    const char* src = scratch;
+    size_t total = pending_size_ + take;
+    size_t left = total;
+    int error = Step(cd_.Get(), &src, &left, out, out_left);
+    size_t used = total - left;
+    if (used >= pending_size_) {
+        // the rest of scratch is chunk again, left to the caller
+        *consumed = used - pending_size_;
+        pending_size_ = 0;
+        return error == EILSEQ ? StepError(error, *consumed) : absl::OkStatus();
+    }
+    if (error == EINVAL && take == chunk.size() && total <= kMaxPending) {
+        // still cut, hold the longer prefix until more input arrives
+        std::memcpy(pending_, scratch + used, total - used);
+        pending_size_ = total - used;
+        *consumed = take;
+        return absl::OkStatus();
+    }
+    *consumed = 0;
+    if (error == E2BIG) {
+        return absl::OkStatus();
+    }
+    return StepError(error == EINVAL ? EILSEQ : error, 0);
+}
+
+absl::Status Transcoder::Update(absl::string_view chunk, char* out, size_t capacity,
+                                size_t* consumed, size_t* written) {
+    char* dst = out;
+    size_t dst_left = capacity;
+    *consumed = 0;
+    if (pending_size_ > 0) {
+        absl::Status status = UpdatePending(chunk, &dst, &dst_left, consumed);
+        if (!status.ok() || pending_size_ > 0) {
+            *written = capacity - dst_left;
+            return status;
+        }
+    }
+    const char* src = chunk.data() + *consumed;
+    size_t src_left = chunk.size() - *consumed;
+    int error = Step(cd_.Get(), &src, &src_left, &dst, &dst_left);
+    if (error == EINVAL && src_left <= kMaxPending) {
+        std::memcpy(pending_, src, src_left);
+        pending_size_ = src_left;
+        src_left = 0;
+        error = 0;
+    }
+    *consumed = chunk.size() - src_left;
+    *written = capacity - dst_left;
+    if (error != 0 && error != E2BIG) {
+        return StepError(error == EINVAL ? EILSEQ : error, *consumed);
+    }
+    return absl::OkStatus();
+}
+
+absl::Status Transcoder::Update(absl::string_view chunk, std::string* out) {
+    size_t offset = 0;
+    while (true) {
+        // most pairs grow at most by half, e.g. 2 byte gbk to 3 byte utf-8
+        size_t rest = chunk.size() - offset;
+        size_t capacity = rest + rest / 2 + 16;
+        size_t size = out->size();
+        out->resize(size + capacity);
+        size_t consumed, written;
+        absl::Status status =
+            Update(chunk.substr(offset), out->data() + size, capacity, &consumed, &written);
+        out->resize(size + written);
+        offset += consumed;
+        if (!status.ok()) {
+            return status;
+        }
+        if (offset == chunk.size()) {
+            return absl::OkStatus();
+        }
+    }
+}
 
-    size_t ret = iconv(cd, &inbuf, &in_size, &outbuf, &out_size);
+absl::Status Transcoder::Finish(std::string* out) {
+    if (pending_size_ > 0) {
+        Reset();
+        return absl::InvalidArgumentError("incomplete multibyte sequence at end of input");
+    }
+    char buf[32];
+    char* dst = buf;
+    size_t dst_left = sizeof(buf);
+    size_t ret = iconv(cd_.Get(), nullptr, nullptr, &dst, &dst_left);
+    int error = errno;
+    Reset();
     if (ret == static_cast<size_t>(-1)) {
-        std::cerr << "Error converting encoding!" << std::endl;
-        return -1;
+        return StepError(error, 0);
     }
-    out.resize(utf8_len - out_size);
-    iconv_close(cd);
-    return 0;
+    out->append(buf, sizeof(buf) - dst_left);
+    return absl::OkStatus();
+}
+
+absl::Status Transcoder::Convert(absl::string_view in, std::string* out) {
+    out->clear();
+    Reset();
+    absl::Status status = Update(in, out);
+    if (!status.ok()) {
+        Reset();
+        return status;
+    }
+    return Finish(out);
 }
 
 }  // namespace locale
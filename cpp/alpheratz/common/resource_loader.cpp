@@ -1,8 +1,15 @@
+#include <absl/synchronization/blocking_counter.h>
 #include <alpheratz/common/resource_loader.h>
+#include <alpheratz/concurrent/thread_pool.h>
+#include <alpheratz/io/async_io.h>
+#include <fcntl.h>
 #include <glog/logging.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <cerrno>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
 namespace fs = std::filesystem;
 namespace alpheratz {
 namespace common {
@@ -25,26 +32,76 @@ absl::Status ResourceLoader::Load(absl::string_view path) {
     loop_file(base_path_str);
 
     // LOAD
+    // table slots first, the table is not thread safe
+    std::vector<std::vector<uint8_t> *> buffers;
+    buffers.reserve(out.size());
     for (const auto &file : out) {
         std::string relative_name = file.substr(base_path_str.size());
         LOG(INFO) << file << ": " << relative_name;
-        std::ifstream ifs(file, std::ios::binary | std::ios::in);
-        ifs.seekg(0, std::ios::end);
-        size_t file_size = ifs.tellg();
-        auto &res = resource_map_[relative_name];
-        res.resize(file_size);
-        ifs.seekg(0, std::ios::beg);
-        ifs.read(reinterpret_cast<char *>(res.data()), file_size);
-        ifs.close();
+        auto &slot = resource_map_[relative_name];
+        if (slot == nullptr) slot.reset(new std::vector<uint8_t>());
+        buffers.push_back(slot.get());
     }
-    return absl::OkStatus();
+    // open, size and zero every buffer on the shared pool, then read them all in one batch
+    std::vector<int> fds(out.size(), -1);
+    std::vector<absl::Status> open_statuses(out.size());
+    concurrent::ThreadPool::Get().ParallelFor(0, out.size(), [&](size_t i) {
+        int fd = ::open(out[i].c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) != 0) {
+            open_statuses[i] = absl::InternalError(out[i] + ": " + std::strerror(errno));
+            if (fd >= 0) ::close(fd);
+            return;
+        }
+        fds[i] = fd;
+        buffers[i]->resize(st.st_size);
+    });
+    std::vector<io::IoOp> ops;
+    std::vector<const std::string *> op_files;
+    absl::Status status;
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (!open_statuses[i].ok()) {
+            if (status.ok()) status = open_statuses[i];
+            continue;
+        }
+        auto &res = *buffers[i];
+        if (res.empty()) continue;
+        io::IoOp op;
+        op.fd = fds[i];
+        op.buffer = res.data();
+        op.size = res.size();
+        ops.push_back(std::move(op));
+        op_files.push_back(&out[i]);
+    }
+    std::vector<absl::Status> statuses(ops.size());
+    absl::BlockingCounter pending(static_cast<int>(ops.size()));
+    for (size_t i = 0; i < ops.size(); ++i) {
+        size_t size = ops[i].size;
+        ops[i].done = [&statuses, &pending, &op_files, i, size](absl::StatusOr<size_t> result) {
+            if (!result.ok()) {
+                statuses[i] = absl::InternalError(*op_files[i] + ": " + result.status().ToString());
+            } else if (*result != size) {
+                statuses[i] = absl::DataLossError(*op_files[i] + ": file shrank while loading");
+            }
+            pending.DecrementCount();
+        };
+    }
+    io::AsyncIo::Get().Submit(std::move(ops));
+    pending.Wait();
+    for (int fd : fds) {
+        if (fd >= 0) ::close(fd);
+    }
+    for (auto &read_status : statuses) {
+        if (status.ok()) status = read_status;
+    }
+    return status;
 }
-absl::StatusOr<std::vector<uint8_t> *> ResourceLoader::GetResource(const std::string &path) {
+absl::StatusOr<std::vector<uint8_t> *> ResourceLoader::GetResource(absl::string_view path) {
     auto it = resource_map_.find(path);
     if (it == resource_map_.end()) {
-        return absl::NotFoundError(path + " not found");
+        return absl::NotFoundError(std::string(path) + " not found");
     }
-    return &(it->second);
+    return it->second.get();
 }
 }  // namespace common
 }  // namespace alpheratz
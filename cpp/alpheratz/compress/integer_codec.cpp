@@ -0,0 +1,306 @@
+#include <alpheratz/compress/integer_codec.h>
+
+#include <algorithm>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#define ALPHERATZ_INTEGER_CODEC_X86 1
+#endif
+
+namespace alpheratz {
+namespace compress {
+
+namespace {
+
+// values per frame of reference block
+constexpr size_t kBlock = 128;
+
+// data bytes and ssse3 shuffle of every stream vbyte control byte
+struct StreamVByteTables {
+    uint8_t length[256];
+    alignas(16) uint8_t shuffle[256][16];
+
+    StreamVByteTables() {
+        for (int control = 0; control < 256; ++control) {
+            uint8_t offset = 0;
+            for (int k = 0; k < 4; ++k) {
+                int bytes = (control >> (2 * k) & 3) + 1;
+                for (int j = 0; j < 4; ++j) {
+                    shuffle[control][4 * k + j] = j < bytes ? offset + j : 0x80;
+                }
+                offset += bytes;
+            }
+            length[control] = offset;
+        }
+    }
+};
+
+const StreamVByteTables &Tables() {
+    static const StreamVByteTables tables;
+    return tables;
+}
+
+int ByteLength(uint32_t value) {
+    return value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : value < (1u << 24) ? 3 : 4;
+}
+
+uint64_t LoadLittle64(const uint8_t *p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+// decodes values [from, count) one at a time, data has been checked to hold them all
+template <bool kDelta>
+const char *DecodeScalar(const uint8_t *control, const char *data, size_t from, size_t count,
+                         uint32_t previous, uint32_t *out) {
+    for (size_t i = from; i < count; ++i) {
+        int bytes = (control[i / 4] >> (2 * (i % 4)) & 3) + 1;
+        uint32_t value = 0;
+        for (int j = bytes - 1; j >= 0; --j) {
+            value = value << 8 | static_cast<unsigned char>(data[j]);
+        }
+        data += bytes;
+        previous = kDelta ? previous + value : value;
+        out[i] = previous;
+    }
+    return data;
+}
+
+#ifdef ALPHERATZ_INTEGER_CODEC_X86
+// four values per control byte while 16 bytes can be loaded, *done is how many were
+template <bool kDelta>
+__attribute__((target("ssse3"))) const char *DecodeSsse3(const uint8_t *control, size_t groups,
+                                                         const char *data, const char *end,
+                                                         uint32_t *out, size_t *done) {
+    const StreamVByteTables &tables = Tables();
+    __m128i previous = _mm_setzero_si128();
+    size_t g = 0;
+    for (; g < groups && end - data >= 16; ++g) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        __m128i shuffle =
+            _mm_load_si128(reinterpret_cast<const __m128i *>(tables.shuffle[control[g]]));
+        __m128i values = _mm_shuffle_epi8(bytes, shuffle);
+        if (kDelta) {
+            // prefix sum of the 4 differences on top of the last value so far
+            values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+            values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+            values = _mm_add_epi32(values, previous);
+            previous = _mm_shuffle_epi32(values, 0xFF);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 4 * g), values);
+        data += tables.length[control[g]];
+    }
+    *done = 4 * g;
+    return data;
+}
+
+bool HasSsse3() {
+    static const bool has = __builtin_cpu_supports("ssse3");
+    return has;
+}
+#endif
+
+template <bool kDelta>
+const char *DecodeStreamVByte(const uint8_t *control, const char *data, const char *end,
+                              size_t count, uint32_t *out) {
+    size_t done = 0;
+#ifdef ALPHERATZ_INTEGER_CODEC_X86
+    if (HasSsse3()) {
+        data = DecodeSsse3<kDelta>(control, count / 4, data, end, out, &done);
+    }
+#endif
+    uint32_t previous = done > 0 ? out[done - 1] : 0;
+    return DecodeScalar<kDelta>(control, data, done, count, previous, out);
+}
+
+void EncodeBlocks(std::string *out, const int64_t *values, size_t count) {
+    for (size_t begin = 0; begin < count; begin += kBlock) {
+        size_t n = std::min(kBlock, count - begin);
+        const int64_t *block = values + begin;
+        int64_t min = *std::min_element(block, block + n);
+        uint64_t max_offset = 0;
+        for (size_t i = 0; i < n; ++i) {
+            max_offset = std::max(max_offset, static_cast<uint64_t>(block[i]) - min);
+        }
+        int width = max_offset == 0 ? 0 : 64 - __builtin_clzll(max_offset);
+        PutVarint(out, ZigZagEncode(min));
+        out->push_back(static_cast<char>(width));
+        if (width == 0) continue;
+        // low bits first, 64 at a time
+        uint64_t word = 0;
+        int filled = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t offset = static_cast<uint64_t>(block[i]) - min;
+            word |= offset << filled;
+            filled += width;
+            if (filled >= 64) {
+                PutFixed64(out, word);
+                filled -= 64;
+                word = filled > 0 ? offset >> (width - filled) : 0;
+            }
+        }
+        for (int shift = 0; shift < filled; shift += 8) {
+            out->push_back(static_cast<char>(word >> shift));
+        }
+    }
+}
+
+// with kDelta the values are added up on top of previous as they are decoded
+template <bool kDelta>
+bool DecodeBlocks(const char **p, const char *end, size_t count, uint64_t previous,
+                  int64_t *out) {
+    // room for a block and the 9 bytes a value can span
+    uint8_t packed[kBlock * 8 + 16];
+    for (size_t begin = 0; begin < count; begin += kBlock) {
+        size_t n = std::min(kBlock, count - begin);
+        uint64_t zigzag;
+        if (!GetVarint(p, end, &zigzag) || *p == end) return false;
+        uint64_t min = ZigZagDecode(zigzag);
+        int width = static_cast<unsigned char>(*(*p)++);
+        if (width > 64) return false;
+        size_t bytes = (n * width + 7) / 8;
+        if (static_cast<size_t>(end - *p) < bytes) return false;
+        std::memcpy(packed, *p, bytes);
+        std::memset(packed + bytes, 0, 16);
+        *p += bytes;
+        uint64_t mask = width == 64 ? ~0ull : (1ull << width) - 1;
+        for (size_t i = 0; i < n; ++i) {
+            size_t bit = i * width;
+            int shift = bit & 7;
+            // the ninth byte, shifted in two steps as shift may be 0
+            uint64_t offset = LoadLittle64(packed + bit / 8) >> shift |
+                              (static_cast<uint64_t>(packed[bit / 8 + 8]) << 1) << (63 - shift);
+            uint64_t value = min + (offset & mask);
+            previous = kDelta ? previous + value : value;
+            out[begin + i] = static_cast<int64_t>(previous);
+        }
+    }
+    return true;
+}
+
+// a count of values that each take at least min_bytes of input, false when the input
+// is too short for it, so damaged counts cannot make Get allocate without bound
+bool GetCount(const char **p, const char *end, double min_bytes, uint64_t *count) {
+    return GetVarint(p, end, count) && *count * min_bytes <= static_cast<double>(end - *p);
+}
+
+}  // namespace
+
+size_t VarintLength(uint64_t value) { return (64 - __builtin_clzll(value | 1) + 6) / 7; }
+
+void PutVarint(std::string *out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back(static_cast<char>(value));
+}
+
+bool GetVarint(const char **p, const char *end, uint64_t *value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64 && *p < end; shift += 7) {
+        uint64_t byte = static_cast<unsigned char>(*(*p)++);
+        result |= (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PutStreamVByte(std::string *out, const uint32_t *values, size_t count, bool delta) {
+    PutVarint(out, count);
+    size_t control = out->size();
+    out->resize(control + (count + 3) / 4);
+    out->reserve(out->size() + 4 * count);
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t value = delta ? values[i] - previous : values[i];
+        previous = values[i];
+        int bytes = ByteLength(value);
+        (*out)[control + i / 4] |= static_cast<char>((bytes - 1) << (2 * (i % 4)));
+        for (int j = 0; j < bytes; ++j) {
+            out->push_back(static_cast<char>(value >> (8 * j)));
+        }
+    }
+}
+
+bool GetStreamVByte(const char **p, const char *end, std::vector<uint32_t> *values,
+                    bool delta) {
+    const char *pos = *p;
+    uint64_t count;
+    // a quarter control byte and a data byte per value
+    if (!GetCount(&pos, end, 1.25, &count)) return false;
+    const uint8_t *control = reinterpret_cast<const uint8_t *>(pos);
+    const char *data = pos + (count + 3) / 4;
+    // data size from the lengths, so decoding needs no bound checks
+    const StreamVByteTables &tables = Tables();
+    size_t size = 0;
+    for (size_t g = 0; g < count / 4; ++g) size += tables.length[control[g]];
+    for (size_t i = count / 4 * 4; i < count; ++i) {
+        size += (control[i / 4] >> (2 * (i % 4)) & 3) + 1;
+    }
+    if (static_cast<size_t>(end - data) < size) return false;
+    values->resize(count);
+    if (delta) {
+        *p = DecodeStreamVByte<true>(control, data, end, count, values->data());
+    } else {
+        *p = DecodeStreamVByte<false>(control, data, end, count, values->data());
+    }
+    return true;
+}
+
+void PutFrameOfReference(std::string *out, const int64_t *values, size_t count) {
+    PutVarint(out, count);
+    EncodeBlocks(out, values, count);
+}
+
+bool GetFrameOfReference(const char **p, const char *end, std::vector<int64_t> *values) {
+    const char *pos = *p;
+    uint64_t count;
+    // a block takes 2 bytes at least
+    if (!GetCount(&pos, end, 2.0 / kBlock, &count)) return false;
+    values->resize(count);
+    if (!DecodeBlocks<false>(&pos, end, count, 0, values->data())) return false;
+    *p = pos;
+    return true;
+}
+
+void PutDeltaColumn(std::string *out, const int64_t *values, size_t count) {
+    PutVarint(out, count);
+    if (count == 0) return;
+    PutVarint(out, ZigZagEncode(values[0]));
+    std::vector<int64_t> deltas(count - 1);
+    for (size_t i = 1; i < count; ++i) {
+        deltas[i - 1] =
+            static_cast<int64_t>(static_cast<uint64_t>(values[i]) - values[i - 1]);
+    }
+    EncodeBlocks(out, deltas.data(), deltas.size());
+}
+
+bool GetDeltaColumn(const char **p, const char *end, std::vector<int64_t> *values) {
+    const char *pos = *p;
+    uint64_t count, first;
+    if (!GetCount(&pos, end, 2.0 / kBlock, &count)) return false;
+    if (count == 0) {
+        values->clear();
+        *p = pos;
+        return true;
+    }
+    if (!GetVarint(&pos, end, &first)) return false;
+    values->resize(count);
+    int64_t *out = values->data();
+    out[0] = ZigZagDecode(first);
+    if (!DecodeBlocks<true>(&pos, end, count - 1, out[0], out + 1)) return false;
+    *p = pos;
+    return true;
+}
+
+}  // namespace compress
+}  // namespace alpheratz
@@ -0,0 +1,36 @@
+#include <alpheratz/concurrent/event_count.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <climits>
+
+namespace alpheratz {
+namespace concurrent {
+
+void EventCount::Wait(uint32_t key) {
+    while (epoch_.load(std::memory_order_acquire) == key) {
+#ifdef __linux__
+        // returns at once when the epoch already moved, EINTR and spurious wakes loop
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch_), FUTEX_WAIT_PRIVATE, key,
+                nullptr, nullptr, 0);
+#else
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+    }
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void EventCount::Wake() {
+    epoch_.fetch_add(1, std::memory_order_release);
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX,
+            nullptr, nullptr, 0);
+#endif
+}
+
+}  // namespace concurrent
+}  // namespace alpheratz
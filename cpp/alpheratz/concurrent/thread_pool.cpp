@@ -0,0 +1,190 @@
+#include <alpheratz/concurrent/thread_pool.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+
+namespace alpheratz {
+namespace concurrent {
+
+namespace {
+
+thread_local const ThreadPool *current_pool = nullptr;
+thread_local int current_index = -1;
+
+// "0-3,8,10-11" as in /sys/devices/system/node/node0/cpulist
+std::vector<int> ParseCpuList(const std::string &list) {
+    std::vector<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception &) {
+            // blank or malformed entry
+        }
+    }
+    return cpus;
+}
+
+std::vector<int> NumaNodeCpus(int node) {
+    std::ifstream input("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    std::getline(input, list);
+    return ParseCpuList(list);
+}
+
+}  // namespace
+
+ThreadPool &ThreadPool::Get() {
+    static ThreadPool instance;
+    return instance;
+}
+
+ThreadPool::ThreadPool(const ThreadPoolOptions &options) {
+    size_t threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back(new Worker());
+    }
+    // every deque exists before any worker may try to steal from it
+    for (size_t i = 0; i < threads; ++i) {
+        workers_[i]->thread = std::thread(&ThreadPool::Run, this, i);
+        Pin(i, options);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        stop_.store(true, std::memory_order_seq_cst);
+    }
+    park_cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+int ThreadPool::CurrentWorker() const { return current_pool == this ? current_index : -1; }
+
+void ThreadPool::Execute(std::function<void()> task) { Schedule(new Task(std::move(task))); }
+
+void ThreadPool::Schedule(Task *task) {
+    int self = CurrentWorker();
+    if (self >= 0) {
+        workers_[self]->deque.Push(task);
+    } else {
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+        shared_.push_back(task);
+        shared_size_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // pairs with the sleeper count in Run: either the sleeper sees the new epoch or we
+    // see the sleeper
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(park_mutex_);
+        park_cv_.notify_one();
+    }
+}
+
+ThreadPool::Task *ThreadPool::Take(int self) {
+    Task *task = nullptr;
+    if (self >= 0 && workers_[self]->deque.Pop(&task)) {
+        return task;
+    }
+    if (shared_size_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(shared_mutex_);
+        if (!shared_.empty()) {
+            task = shared_.front();
+            shared_.pop_front();
+            shared_size_.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    // steal starting after self so thieves spread over the victims
+    size_t n = workers_.size();
+    size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : 0;
+    for (size_t k = 0; k < n; ++k) {
+        size_t victim = (start + k) % n;
+        if (static_cast<int>(victim) != self && workers_[victim]->deque.Steal(&task)) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+bool ThreadPool::RunOne(int self) {
+    Task *task = Take(self);
+    if (task == nullptr) {
+        return false;
+    }
+    (*task)();
+    delete task;
+    return true;
+}
+
+void ThreadPool::Run(size_t index) {
+    current_pool = this;
+    current_index = static_cast<int>(index);
+    int self = current_index;
+    while (true) {
+        uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+        if (RunOne(self)) {
+            continue;
+        }
+        // a steal may lose a race on a non empty deque, look once more before parking
+        if (RunOne(self)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        if (stop_.load(std::memory_order_relaxed)) {
+            // queues were empty after stop, nothing can be scheduled any more
+            lock.unlock();
+            if (RunOne(self)) continue;
+            return;
+        }
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        park_cv_.wait(lock, [&]() {
+            return stop_.load(std::memory_order_relaxed) ||
+                   epoch_.load(std::memory_order_seq_cst) != epoch;
+        });
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void ThreadPool::Pin(size_t index, const ThreadPoolOptions &options) {
+#ifdef __linux__
+    pthread_t handle = workers_[index]->thread.native_handle();
+    std::string name = options.name + "-" + std::to_string(index);
+    pthread_setname_np(handle, name.substr(0, 15).c_str());
+    std::vector<int> cpus;
+    if (!options.cpus.empty()) {
+        cpus.push_back(options.cpus[index % options.cpus.size()]);
+    } else if (options.numa_node >= 0) {
+        cpus = NumaNodeCpus(options.numa_node);
+    }
+    if (cpus.empty()) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    // pinning is a hint, a cpu outside the allowed set leaves the worker unpinned
+    pthread_setaffinity_np(handle, sizeof(set), &set);
+#endif
+}
+
+}  // namespace concurrent
+}  // namespace alpheratz
@@ -0,0 +1,119 @@
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <alpheratz/conf/config_snapshot.h>
+
+#include <charconv>
+#include <utility>
+
+namespace alpheratz {
+namespace conf {
+
+namespace {
+
+// [-]digits[.digits][(e|E)[+|-]digits], either digit run may be empty but not both.
+// no whitespace, sign, hex, inf or nan, so text meant as a string stays one
+bool IsDecimal(absl::string_view text) {
+    size_t i = 0, digits = 0;
+    auto skip_digits = [&]() {
+        size_t begin = i;
+        while (i < text.size() && absl::ascii_isdigit(text[i])) ++i;
+        return i - begin;
+    };
+    if (i < text.size() && text[i] == '-') ++i;
+    digits += skip_digits();
+    if (i < text.size() && text[i] == '.') {
+        ++i;
+        digits += skip_digits();
+    }
+    if (digits == 0) return false;
+    if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+        ++i;
+        if (i < text.size() && (text[i] == '+' || text[i] == '-')) ++i;
+        if (skip_digits() == 0) return false;
+    }
+    return i == text.size();
+}
+
+}  // namespace
+
+ConfigValue ParseConfigText(absl::string_view text) {
+    if (text.empty()) {
+        return std::string();
+    }
+    const char *first = text.data();
+    const char *last = text.data() + text.size();
+    int64_t int_value;
+    auto result = std::from_chars(first, last, int_value);
+    if (result.ec == std::errc() && result.ptr == last) {
+        return int_value;
+    }
+    // from_chars is locale independent; out of range values stay strings
+    double double_value;
+    if (IsDecimal(text)) {
+        result = std::from_chars(first, last, double_value);
+        if (result.ec == std::errc() && result.ptr == last) {
+            return double_value;
+        }
+    }
+    if (absl::EqualsIgnoreCase(text, "true")) return true;
+    if (absl::EqualsIgnoreCase(text, "false")) return false;
+    return std::string(text.data(), text.size());
+}
+
+uint32_t ConfigSnapshot::Builder::Reserve(absl::string_view path) {
+    auto it = index_.find(path);
+    if (it != index_.end()) {
+        return it->second;
+    }
+    uint32_t index = static_cast<uint32_t>(paths_.size());
+    paths_.emplace_back(path.data(), path.size());
+    values_.emplace_back();
+    index_.emplace(paths_.back(), index);
+    return index;
+}
+
+ConfigSnapshot::Builder &ConfigSnapshot::Builder::Set(absl::string_view path, ConfigValue value) {
+    values_[Reserve(path)] = std::move(value);
+    return *this;
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigSnapshot::Builder::Build(uint64_t version) {
+    std::shared_ptr<ConfigSnapshot> snapshot(new ConfigSnapshot());
+    snapshot->version_ = version;
+    snapshot->paths_ = std::move(paths_);
+    snapshot->values_ = std::move(values_);
+    snapshot->index_ = std::move(index_);
+    paths_.clear();
+    values_.clear();
+    index_.clear();
+    return snapshot;
+}
+
+std::vector<std::string> ConfigSnapshot::ChangedPaths(const ConfigSnapshot *before,
+                                                      const ConfigSnapshot &after) {
+    std::vector<std::string> changed;
+    for (size_t i = 0; i < after.Size(); ++i) {
+        const ConfigValue &value = after.ValueAt(i);
+        const ConfigValue *old_value = nullptr;
+        if (before != nullptr) {
+            ConfigHandle handle = before->Find(after.PathAt(i));
+            old_value = handle.IsValid() ? &before->Value(handle) : nullptr;
+        }
+        if (old_value == nullptr ? !std::holds_alternative<std::monostate>(value)
+                                 : !(*old_value == value)) {
+            changed.push_back(after.PathAt(i));
+        }
+    }
+    if (before != nullptr) {
+        for (size_t i = 0; i < before->Size(); ++i) {
+            if (!after.Find(before->PathAt(i)).IsValid() &&
+                !std::holds_alternative<std::monostate>(before->ValueAt(i))) {
+                changed.push_back(before->PathAt(i));
+            }
+        }
+    }
+    return changed;
+}
+
+}  // namespace conf
+}  // namespace alpheratz
@@ -0,0 +1,144 @@
+#include <alpheratz/conf/config_watcher.h>
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace fs = std::filesystem;
+namespace alpheratz {
+namespace conf {
+
+ConfigWatcher::~ConfigWatcher() {
+#ifdef __linux__
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) != sizeof(one)) {
+            LOG(ERROR) << "wake config watcher failed: " << std::strerror(errno);
+        }
+        thread_.join();
+    }
+    if (inotify_fd_ >= 0) close(inotify_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+#endif
+}
+
+absl::Status ConfigWatcher::Start() {
+#ifdef __linux__
+    if (thread_.joinable()) {
+        return absl::OkStatus();
+    }
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        return absl::InternalError(std::string("inotify_init1: ") + std::strerror(errno));
+    }
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return absl::InternalError(std::string("eventfd: ") + std::strerror(errno));
+    }
+    thread_ = std::thread(&ConfigWatcher::Run, this);
+    return absl::OkStatus();
+#else
+    return absl::UnimplementedError("config watcher needs inotify");
+#endif
+}
+
+absl::StatusOr<uint64_t> ConfigWatcher::Watch(absl::string_view filename, Callback callback) {
+#ifdef __linux__
+    fs::path path = fs::absolute(fs::path(std::string(filename.data(), filename.size())));
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto status = Start();
+    if (!status.ok()) {
+        return status;
+    }
+    // same directory returns the same watch descriptor
+    int wd = inotify_add_watch(inotify_fd_, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+        return absl::InternalError(path.parent_path().string() + ": " + std::strerror(errno));
+    }
+    uint64_t token = ++next_token_;
+    watches_[token] = WatchEntry{wd, path.filename().string(), std::move(callback)};
+    ++wd_refs_[wd];
+    return token;
+#else
+    return absl::UnimplementedError("config watcher needs inotify");
+#endif
+}
+
+void ConfigWatcher::Unwatch(uint64_t token) {
+#ifdef __linux__
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = watches_.find(token);
+        if (it == watches_.end()) {
+            return;
+        }
+        int wd = it->second.wd;
+        watches_.erase(it);
+        if (--wd_refs_[wd] == 0) {
+            wd_refs_.erase(wd);
+            inotify_rm_watch(inotify_fd_, wd);
+        }
+    }
+    // wait for a running callback, unless called from inside one
+    if (std::this_thread::get_id() != thread_.get_id()) {
+        std::lock_guard<std::mutex> callback_lock(callback_mutex_);
+    }
+#endif
+}
+
+void ConfigWatcher::Run() {
+#ifdef __linux__
+    alignas(struct inotify_event) char buffer[4096];
+    struct pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOG(ERROR) << "config watcher poll: " << std::strerror(errno);
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            return;
+        }
+        // one reload per file for all events drained in this round
+        std::set<uint64_t> fired;
+        ssize_t len;
+        while ((len = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (char *p = buffer; p < buffer + len;) {
+                auto *event = reinterpret_cast<const struct inotify_event *>(p);
+                p += sizeof(struct inotify_event) + event->len;
+                if (event->len == 0) continue;
+                for (const auto &it : watches_) {
+                    if (it.second.wd == event->wd && it.second.name == event->name) {
+                        fired.insert(it.first);
+                    }
+                }
+            }
+        }
+        std::lock_guard<std::mutex> callback_lock(callback_mutex_);
+        for (uint64_t token : fired) {
+            Callback callback;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = watches_.find(token);
+                if (it == watches_.end()) continue;
+                callback = it->second.callback;
+            }
+            callback();
+        }
+    }
+#endif
+}
+
+}  // namespace conf
+}  // namespace alpheratz
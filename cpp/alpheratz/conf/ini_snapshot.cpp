@@ -0,0 +1,31 @@
+#include <absl/strings/str_cat.h>
+#include <alpheratz/conf/ini_snapshot.h>
+
+namespace alpheratz {
+namespace conf {
+
+std::shared_ptr<const ConfigSnapshot> CompileIni(const XiniFileT &ini, uint64_t version) {
+    ConfigSnapshot::Builder builder;
+    for (auto sect = ini.Begin(); sect != ini.End(); ++sect) {
+        const std::string &name = (*sect)->name();
+        for (const XiniNodeT *node : **sect) {
+            if (node->Ntype() != kXiniNtypeKeyvalue) continue;
+            auto *kv = static_cast<const XiniKeyvalueT *>(node);
+            builder.Set(name.empty() ? kv->key() : absl::StrCat(name, ".", kv->key()),
+                        ParseConfigText(kv->value()));
+        }
+    }
+    return builder.Build(version);
+}
+
+absl::StatusOr<std::shared_ptr<const ConfigSnapshot>> LoadIniSnapshot(const std::string &path,
+                                                                      uint64_t version) {
+    XiniFileT ini;
+    if (!ini.Load(path)) {
+        return absl::NotFoundError(absl::StrCat(path, " not found"));
+    }
+    return CompileIni(ini, version);
+}
+
+}  // namespace conf
+}  // namespace alpheratz
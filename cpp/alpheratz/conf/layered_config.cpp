@@ -0,0 +1,110 @@
+#include <alpheratz/common/env.h>
+#include <alpheratz/conf/layered_config.h>
+
+#include <cctype>
+
+namespace alpheratz {
+namespace conf {
+
+uint32_t LayeredConfig::Intern(absl::string_view key) {
+    auto it = ids_.find(key);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(keys_.size());
+    keys_.emplace_back(key.data(), key.size());
+    ids_.emplace(keys_.back(), id);
+    return id;
+}
+
+std::string LayeredConfig::EnvName(const std::string &key) const {
+    std::string name = env_prefix_;
+    name.reserve(env_prefix_.size() + key.size());
+    for (char c : key) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        name.push_back(std::isalnum(uc) ? static_cast<char>(std::toupper(uc)) : '_');
+    }
+    return name;
+}
+
+void LayeredConfig::SetDefault(absl::string_view key, ConfigValue value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    defaults_.emplace_back(Intern(key), std::move(value));
+}
+
+void LayeredConfig::AddFile(std::shared_ptr<const ConfigSnapshot> snapshot) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.emplace_back([snapshot]() { return snapshot; });
+}
+
+void LayeredConfig::AddFile(const ReloadableConfig &config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.emplace_back([&config]() { return config.Snapshot(); });
+}
+
+void LayeredConfig::SetEnvPrefix(absl::string_view prefix) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    env_prefix_ = std::string(prefix.data(), prefix.size());
+    env_prefix_set_ = true;
+}
+
+void LayeredConfig::BindEnv(absl::string_view key, absl::string_view env_name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    env_bindings_.emplace_back(Intern(key), std::string(env_name.data(), env_name.size()));
+}
+
+ConfigHandle LayeredConfig::Handle(absl::string_view key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ConfigHandle(Intern(key));
+}
+
+absl::Status LayeredConfig::Build() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::shared_ptr<const ConfigSnapshot>> files;
+    files.reserve(files_.size());
+    for (const auto &source : files_) {
+        auto file = source();
+        if (file == nullptr) {
+            return absl::FailedPreconditionError("config file layer is not loaded");
+        }
+        for (size_t i = 0; i < file->Size(); ++i) {
+            Intern(file->PathAt(i));
+        }
+        files.push_back(std::move(file));
+    }
+
+    // reserve in id order, so the index of every key equals its id
+    ConfigSnapshot::Builder builder;
+    for (const auto &key : keys_) {
+        builder.Reserve(key);
+    }
+    for (const auto &it : defaults_) {
+        builder.Set(keys_[it.first], it.second);
+    }
+    for (const auto &file : files) {
+        for (size_t i = 0; i < file->Size(); ++i) {
+            if (!std::holds_alternative<std::monostate>(file->ValueAt(i))) {
+                builder.Set(file->PathAt(i), file->ValueAt(i));
+            }
+        }
+    }
+    if (env_prefix_set_) {
+        for (const auto &key : keys_) {
+            auto value = common::env::LookupEnv(EnvName(key));
+            if (value) {
+                builder.Set(key, ParseConfigText(*value));
+            }
+        }
+    }
+    for (const auto &it : env_bindings_) {
+        auto value = common::env::LookupEnv(it.second);
+        if (value) {
+            builder.Set(keys_[it.first], ParseConfigText(*value));
+        }
+    }
+    snapshot_.Publish(builder.Build(++version_));
+    return absl::OkStatus();
+}
+
+}  // namespace conf
+}  // namespace alpheratz
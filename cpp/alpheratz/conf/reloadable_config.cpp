@@ -0,0 +1,148 @@
+#include <absl/strings/match.h>
+#include <alpheratz/conf/config_watcher.h>
+#include <alpheratz/conf/reloadable_config.h>
+#include <glog/logging.h>
+
+#include <vector>
+
+namespace alpheratz {
+namespace conf {
+
+ReloadableConfig::ReloadableConfig(Parser parser) : parser_(std::move(parser)) {
+    // construct watcher first so it is destroyed after static configs
+    ConfigWatcher::Get();
+}
+
+ReloadableConfig::~ReloadableConfig() { DisableHotReload(); }
+
+absl::Status ReloadableConfig::Load(absl::string_view path) {
+    auto status = Bind(path);
+    if (!status.ok()) {
+        return status;
+    }
+    return Reload();
+}
+
+absl::Status ReloadableConfig::Load(absl::string_view path, const Compiler &compile) {
+    auto status = Bind(path);
+    if (!status.ok()) {
+        return status;
+    }
+    std::unique_lock<std::mutex> lock(reload_mutex_);
+    return Publish(compile(version_ + 1), &lock);
+}
+
+absl::Status ReloadableConfig::Bind(absl::string_view path) {
+    bool hot_reload;
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        path_ = std::string(path.data(), path.size());
+        hot_reload = hot_reload_;
+    }
+    if (hot_reload) {
+        DisableHotReload();
+        return EnableHotReload();
+    }
+    return absl::OkStatus();
+}
+
+absl::Status ReloadableConfig::Reload() {
+    std::unique_lock<std::mutex> lock(reload_mutex_);
+    auto snapshot = parser_(path_, version_ + 1);
+    if (!snapshot.ok()) {
+        LOG(ERROR) << "reload " << path_ << " failed: " << snapshot.status();
+        return snapshot.status();
+    }
+    return Publish(*std::move(snapshot), &lock);
+}
+
+absl::Status ReloadableConfig::Publish(std::shared_ptr<const ConfigSnapshot> snapshot,
+                                       std::unique_lock<std::mutex> *lock) {
+    if (validator_) {
+        auto status = validator_(*snapshot);
+        if (!status.ok()) {
+            LOG(ERROR) << "reject " << path_ << " version " << snapshot->Version() << ": "
+                       << status;
+            return status;
+        }
+    }
+    version_ = snapshot->Version();
+    auto previous = snapshot_.Publish(snapshot);
+    if (previous == nullptr) {
+        return absl::OkStatus();
+    }
+
+    std::vector<std::string> changed = ConfigSnapshot::ChangedPaths(previous.get(), *snapshot);
+    if (changed.empty()) {
+        return absl::OkStatus();
+    }
+    std::vector<Listener> fired;
+    {
+        std::lock_guard<std::mutex> lock(listener_mutex_);
+        for (const auto &it : listeners_) {
+            const std::string &key = it.second.first;
+            for (const auto &path : changed) {
+                if (path == key ||
+                    (absl::StartsWith(path, key) && path.size() > key.size() &&
+                     path[key.size()] == '.')) {
+                    fired.push_back(it.second.second);
+                    break;
+                }
+            }
+        }
+    }
+    // listeners may reload, load or reconfigure this config
+    lock->unlock();
+    for (const auto &listener : fired) {
+        listener(*snapshot);
+    }
+    return absl::OkStatus();
+}
+
+absl::Status ReloadableConfig::EnableHotReload() {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    if (watch_token_ != 0) {
+        return absl::OkStatus();
+    }
+    auto token = ConfigWatcher::Get().Watch(path_, [this]() { Reload().IgnoreError(); });
+    if (!token.ok()) {
+        return token.status();
+    }
+    watch_token_ = *token;
+    hot_reload_ = true;
+    return absl::OkStatus();
+}
+
+void ReloadableConfig::DisableHotReload() {
+    uint64_t token;
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+        token = watch_token_;
+        watch_token_ = 0;
+        hot_reload_ = false;
+    }
+    // outside the lock, a running reload callback must be able to finish
+    if (token != 0) {
+        ConfigWatcher::Get().Unwatch(token);
+    }
+}
+
+void ReloadableConfig::SetValidator(Validator validator) {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    validator_ = std::move(validator);
+}
+
+uint64_t ReloadableConfig::Subscribe(absl::string_view key, Listener listener) {
+    std::lock_guard<std::mutex> lock(listener_mutex_);
+    uint64_t id = ++next_listener_;
+    listeners_[id] = std::make_pair(std::string(key.data(), key.size()), std::move(listener));
+    return id;
+}
+
+void ReloadableConfig::Unsubscribe(uint64_t id) {
+    std::lock_guard<std::mutex> lock(listener_mutex_);
+    listeners_.erase(id);
+}
+
+}  // namespace conf
+}  // namespace alpheratz
@@ -4,6 +4,73 @@
 namespace fs = std::filesystem;
 namespace alpheratz {
 namespace conf {
+namespace {
+
+ConfigScalar CompileScalar(const YAML::Node& node) {
+    if (node.IsNull()) {
+        return std::monostate();
+    }
+    // quoted scalars carry the non-specific tag "!" and always stay strings
+    if (node.Tag() != "!") {
+        int64_t int_value;
+        if (YAML::convert<int64_t>::decode(node, int_value)) {
+            return int_value;
+        }
+        double double_value;
+        if (YAML::convert<double>::decode(node, double_value)) {
+            return double_value;
+        }
+        bool bool_value;
+        if (YAML::convert<bool>::decode(node, bool_value)) {
+            return bool_value;
+        }
+    }
+    return node.Scalar();
+}
+
+ConfigValue ToValue(ConfigScalar scalar) {
+    return std::visit([](auto&& v) -> ConfigValue { return std::move(v); }, std::move(scalar));
+}
+
+void CompileNode(const YAML::Node& node, const std::string& path,
+                 ConfigSnapshot::Builder& builder) {
+    switch (node.Type()) {
+        case YAML::NodeType::Map:
+            for (const auto& it : node) {
+                std::string key = it.first.as<std::string>();
+                CompileNode(it.second, path.empty() ? key : absl::StrCat(path, ".", key), builder);
+            }
+            break;
+        case YAML::NodeType::Sequence: {
+            bool all_scalar = true;
+            for (const auto& item : node) {
+                all_scalar = all_scalar && (item.IsScalar() || item.IsNull());
+            }
+            if (all_scalar) {
+                ConfigArray array;
+                array.reserve(node.size());
+                for (const auto& item : node) {
+                    array.push_back(CompileScalar(item));
+                }
+                builder.Set(path, std::move(array));
+                break;
+            }
+            for (size_t i = 0; i < node.size(); ++i) {
+                CompileNode(node[i], absl::StrCat(path, ".", i), builder);
+            }
+            break;
+        }
+        case YAML::NodeType::Scalar:
+        case YAML::NodeType::Null:
+            builder.Set(path, ToValue(CompileScalar(node)));
+            break;
+        case YAML::NodeType::Undefined:
+            break;
+    }
+}
+
+}  // namespace
+
 absl::Status YamlConfig::Load(absl::string_view filename) {
     fs::path config_path(std::string(filename.data(), filename.size()));
     if (!fs::exists(config_path)) {
@@ -19,9 +86,33 @@ absl::Status YamlConfig::Load(absl::string_view filename) {
         LOG(ERROR) << "Bad File:" << e.what();
         return absl::InternalError(absl::StrCat(e.what(), " msg:", e.msg));
     }
+    // publish the tree parsed above, a second read could see a newer file than root_
+    auto status = reloadable_.Load(config_path.string(),
+                                   [this](uint64_t version) { return Compile(root_, version); });
+    if (!status.ok()) {
+        return status;
+    }
     initialized_ = true;
     return absl::OkStatus();
 }
 
+absl::StatusOr<std::shared_ptr<const ConfigSnapshot>> YamlConfig::LoadSnapshot(
+    const std::string& filename, uint64_t version) {
+    try {
+        return Compile(YAML::LoadFile(filename), version);
+    } catch (const YAML::BadFile& e) {
+        return absl::NotFoundError(absl::StrCat(filename, " ", e.what()));
+    } catch (const YAML::Exception& e) {
+        return absl::InvalidArgumentError(absl::StrCat(e.what(), " msg:", e.msg));
+    }
+}
+
+std::shared_ptr<const ConfigSnapshot> YamlConfig::Compile(const YAML::Node& root,
+                                                          uint64_t version) {
+    ConfigSnapshot::Builder builder;
+    CompileNode(root, "", builder);
+    return builder.Build(version);
+}
+
 }  // namespace conf
 }  // namespace alpheratz
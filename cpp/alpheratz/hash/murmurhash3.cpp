@@ -435,6 +435,12 @@ int64_t MurmurHash64(const std::string &str, uint32_t seed){
   MurmurHash3_x64_128((void *)(str.c_str()), length, seed, (void *)mac_hash);
   return mac_hash[0];
 }
+
+int64_t MurmurHash64(const void *key, int len, uint32_t seed) {
+  int64_t mac_hash[2] = {0};
+  MurmurHash3_x64_128(key, len, seed, (void *)mac_hash);
+  return mac_hash[0];
+}
 //-----------------------------------------------------------------------------
 
 } // namespace hash
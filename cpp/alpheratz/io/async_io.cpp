@@ -0,0 +1,347 @@
+#include <alpheratz/io/async_io.h>
+#include <alpheratz/concurrent/thread_pool.h>
+#include <unistd.h>
+#ifdef ALPHERATZ_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace alpheratz {
+namespace io {
+
+class AsyncIo::Backend {
+   public:
+    virtual ~Backend() = default;
+    virtual void Submit(std::vector<IoOp> ops) = 0;
+    virtual const char *Name() const = 0;
+};
+
+namespace {
+
+absl::Status ErrnoError(int error, IoKind kind) {
+    return absl::Status(absl::ErrnoToStatusCode(error),
+                        std::string(kind == IoKind::kRead ? "read: " : "write: ") +
+                            std::strerror(error));
+}
+
+// an op and how much of it is done
+struct Pending {
+    IoOp op;
+    size_t transferred = 0;
+};
+
+// blocking pread / pwrite until the op is complete, end of file or an error
+absl::StatusOr<size_t> Run(const IoOp &op) {
+    size_t transferred = 0;
+    while (transferred < op.size) {
+        char *buffer = static_cast<char *>(op.buffer) + transferred;
+        size_t left = op.size - transferred;
+        off_t offset = static_cast<off_t>(op.offset + transferred);
+        ssize_t n = op.kind == IoKind::kRead ? ::pread(op.fd, buffer, left, offset)
+                                             : ::pwrite(op.fd, buffer, left, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return ErrnoError(errno, op.kind);
+        }
+        if (n == 0) break;
+        transferred += n;
+    }
+    return transferred;
+}
+
+class ThreadBackend : public AsyncIo::Backend {
+   public:
+    // a pool of its own, blocking syscalls would starve the compute tasks of the shared one
+    explicit ThreadBackend(size_t threads) : pool_(Options(threads)) {}
+
+    void Submit(std::vector<IoOp> ops) override {
+        for (auto &op : ops) {
+            pool_.Execute([op = std::move(op)]() {
+                absl::StatusOr<size_t> result = Run(op);
+                if (op.done) op.done(std::move(result));
+            });
+        }
+    }
+
+    const char *Name() const override { return "threads"; }
+
+   private:
+    static concurrent::ThreadPoolOptions Options(size_t threads) {
+        concurrent::ThreadPoolOptions options;
+        options.threads = std::max<size_t>(threads, 1);
+        options.name = "alpheratz-io";
+        return options;
+    }
+
+    // runs the queued ops before joining
+    concurrent::ThreadPool pool_;
+};
+
+#ifdef ALPHERATZ_HAVE_LIBURING
+/**
+ * at most capacity_ entries are in the ring, prepared or in the kernel, so taking an
+ * entry never waits and the completion queue cannot overflow. ops beyond that wait in
+ * backlog_ and the reaper moves them in as completions free entries. a failed submit is
+ * retried after the next completion when the kernel still holds ops, else the ops not
+ * taken by the kernel fail with its error and their entries are turned into nops
+ */
+class UringBackend : public AsyncIo::Backend {
+   public:
+    static std::unique_ptr<UringBackend> Create(unsigned queue_depth) {
+        std::unique_ptr<UringBackend> backend(new UringBackend());
+        queue_depth = std::max(queue_depth, 2u);
+        if (io_uring_queue_init(queue_depth, &backend->ring_, 0) < 0) {
+            return nullptr;
+        }
+        // one entry is kept for the nop that stops the reaper
+        backend->capacity_ = queue_depth - 1;
+        backend->reaper_ = std::thread(&UringBackend::Reap, backend.get());
+        return backend;
+    }
+
+    ~UringBackend() override {
+        if (!reaper_.joinable()) {
+            // io_uring_queue_init failed, the ring was never set up
+            return;
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            drained_.wait(lock, [this]() { return inflight_ == 0; });
+            // the reaper finishes on this nop
+            io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+            io_uring_prep_nop(sqe);
+            io_uring_sqe_set_data(sqe, this);
+            unsubmitted_.push_back({sqe, nullptr});
+            ++in_ring_;
+            int ret;
+            do {
+                ret = io_uring_submit(&ring_);
+            } while (ret == -EINTR || ret == -EAGAIN || ret == -EBUSY);
+        }
+        reaper_.join();
+        io_uring_queue_exit(&ring_);
+    }
+
+    void Submit(std::vector<IoOp> ops) override {
+        std::vector<std::pair<Pending *, absl::Status>> failed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            inflight_ += ops.size();
+            for (auto &op : ops) {
+                backlog_.push_back(new Pending{std::move(op), 0});
+            }
+            Flush(&failed);
+        }
+        Fail(std::move(failed));
+    }
+
+    const char *Name() const override { return "io_uring"; }
+
+   private:
+    UringBackend() = default;
+
+    // mutex_ held
+    void Prepare(io_uring_sqe *sqe, Pending *pending) {
+        const IoOp &op = pending->op;
+        char *buffer = static_cast<char *>(op.buffer) + pending->transferred;
+        unsigned left = static_cast<unsigned>(
+            std::min<size_t>(op.size - pending->transferred, 1u << 30));
+        uint64_t offset = op.offset + pending->transferred;
+        if (op.kind == IoKind::kRead) {
+            io_uring_prep_read(sqe, op.fd, buffer, left, offset);
+        } else {
+            io_uring_prep_write(sqe, op.fd, buffer, left, offset);
+        }
+        io_uring_sqe_set_data(sqe, pending);
+    }
+
+    // mutex_ held. moves backlog into free entries and submits, ops that cannot be
+    // submitted go to failed
+    void Flush(std::vector<std::pair<Pending *, absl::Status>> *failed) {
+        while (in_ring_ < capacity_ && !backlog_.empty()) {
+            io_uring_sqe *sqe = io_uring_get_sqe(&ring_);
+            if (sqe == nullptr) break;
+            Prepare(sqe, backlog_.front());
+            unsubmitted_.push_back({sqe, backlog_.front()});
+            backlog_.pop_front();
+            ++in_ring_;
+        }
+        if (unsubmitted_.empty()) {
+            return;
+        }
+        int ret;
+        do {
+            ret = io_uring_submit(&ring_);
+        } while (ret == -EINTR);
+        if (ret > 0) {
+            unsubmitted_.erase(unsubmitted_.begin(),
+                               unsubmitted_.begin() + std::min<size_t>(ret, unsubmitted_.size()));
+        }
+        bool transient = ret >= 0 || ret == -EAGAIN || ret == -EBUSY;
+        if (unsubmitted_.empty() || (transient && in_ring_ > unsubmitted_.size())) {
+            // the kernel holds ops, the reaper flushes again when one completes
+            return;
+        }
+        for (Unsubmitted &entry : unsubmitted_) {
+            if (entry.pending == nullptr) continue;
+            absl::Status status =
+                ret < 0 ? ErrnoError(-ret, entry.pending->op.kind)
+                        : absl::UnavailableError("io_uring submitted none of the queued ops");
+            failed->emplace_back(entry.pending, std::move(status));
+            // still in the submission queue, a nop frees it on a later submit
+            io_uring_prep_nop(entry.sqe);
+            io_uring_sqe_set_data(entry.sqe, nullptr);
+            entry.pending = nullptr;
+        }
+        // later ops would meet the same error, fail them now rather than leave them waiting
+        while (!backlog_.empty()) {
+            Pending *pending = backlog_.front();
+            backlog_.pop_front();
+            failed->emplace_back(pending, ret < 0 ? ErrnoError(-ret, pending->op.kind)
+                                                  : absl::UnavailableError("io_uring stalled"));
+        }
+    }
+
+    // runs done of each op and forgets it, outside mutex_ as done may submit
+    void Fail(std::vector<std::pair<Pending *, absl::Status>> failed) {
+        for (auto &it : failed) {
+            Finish(it.first, std::move(it.second));
+        }
+    }
+
+    void Finish(Pending *pending, absl::StatusOr<size_t> result) {
+        if (pending->op.done) {
+            pending->op.done(std::move(result));
+        }
+        delete pending;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--inflight_ == 0) {
+            drained_.notify_all();
+        }
+    }
+
+    void Reap() {
+        while (true) {
+            io_uring_cqe *cqe;
+            int ret = io_uring_wait_cqe(&ring_, &cqe);
+            if (ret < 0) {
+                if (ret == -EINTR) continue;
+                break;
+            }
+            void *data = io_uring_cqe_get_data(cqe);
+            int res = cqe->res;
+            io_uring_cqe_seen(&ring_, cqe);
+            if (data == this) {
+                break;
+            }
+            auto *pending = static_cast<Pending *>(data);
+            std::vector<std::pair<Pending *, absl::Status>> failed;
+            bool finished = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --in_ring_;
+                if (pending != nullptr) {
+                    if (res > 0) pending->transferred += res;
+                    // short transfers and interrupted ones go on where they stopped
+                    bool again = res == -EINTR || res == -EAGAIN ||
+                                 (res > 0 && pending->transferred < pending->op.size);
+                    if (again) {
+                        backlog_.push_front(pending);
+                    } else {
+                        finished = true;
+                    }
+                }
+                Flush(&failed);
+            }
+            if (finished) {
+                if (res < 0) {
+                    Finish(pending, ErrnoError(-res, pending->op.kind));
+                } else {
+                    Finish(pending, pending->transferred);
+                }
+            }
+            Fail(std::move(failed));
+        }
+    }
+
+    io_uring ring_;
+    unsigned capacity_ = 0;
+    std::mutex mutex_;
+    std::condition_variable drained_;
+    // accepted ops whose done has not run yet
+    size_t inflight_ = 0;
+    // entries prepared or in the kernel, their completion not reaped yet
+    size_t in_ring_ = 0;
+    // prepared entries the kernel has not taken, in submission queue order
+    struct Unsubmitted {
+        io_uring_sqe *sqe;
+        // nullptr for nops
+        Pending *pending;
+    };
+    std::deque<Unsubmitted> unsubmitted_;
+    std::deque<Pending *> backlog_;
+    std::thread reaper_;
+};
+#endif
+
+}  // namespace
+
+AsyncIo &AsyncIo::Get() {
+    static AsyncIo instance;
+    return instance;
+}
+
+AsyncIo::AsyncIo(const AsyncIoOptions &options) {
+#ifdef ALPHERATZ_HAVE_LIBURING
+    if (!options.force_threads) {
+        backend_ = UringBackend::Create(options.queue_depth);
+    }
+#endif
+    if (backend_ == nullptr) {
+        backend_.reset(new ThreadBackend(options.threads));
+    }
+}
+
+AsyncIo::~AsyncIo() = default;
+
+void AsyncIo::Submit(std::vector<IoOp> ops) {
+    if (!ops.empty()) {
+        backend_->Submit(std::move(ops));
+    }
+}
+
+std::future<absl::StatusOr<size_t>> AsyncIo::Read(int fd, void *buffer, size_t size,
+                                                  uint64_t offset) {
+    auto promise = std::make_shared<std::promise<absl::StatusOr<size_t>>>();
+    std::future<absl::StatusOr<size_t>> future = promise->get_future();
+    std::vector<IoOp> ops(1);
+    ops[0] = {IoKind::kRead, fd, buffer, size, offset,
+              [promise](absl::StatusOr<size_t> result) { promise->set_value(std::move(result)); }};
+    Submit(std::move(ops));
+    return future;
+}
+
+std::future<absl::StatusOr<size_t>> AsyncIo::Write(int fd, const void *buffer, size_t size,
+                                                   uint64_t offset) {
+    auto promise = std::make_shared<std::promise<absl::StatusOr<size_t>>>();
+    std::future<absl::StatusOr<size_t>> future = promise->get_future();
+    std::vector<IoOp> ops(1);
+    ops[0] = {IoKind::kWrite, fd, const_cast<void *>(buffer), size, offset,
+              [promise](absl::StatusOr<size_t> result) { promise->set_value(std::move(result)); }};
+    Submit(std::move(ops));
+    return future;
+}
+
+const char *AsyncIo::BackendName() const { return backend_->Name(); }
+
+}  // namespace io
+}  // namespace alpheratz
@@ -1,27 +1,58 @@
 #include <absl/strings/match.h>
 #include <alpheratz/io/file_loader.h>
+#include <alpheratz/string/utf8.h>
 
 #include <fstream>
 namespace alpheratz {
 namespace io {
-// load file and line process callback
-void LoadFile(absl::string_view filename,
-              std::function<void(const std::string &, uint32_t)> &callback,
-              absl::string_view exclude = "") {
+
+namespace {
+
+absl::Status LoadLines(absl::string_view filename,
+                       const std::function<void(const std::string &, uint32_t)> &callback,
+                       absl::string_view exclude, bool validate_utf8) {
     std::ifstream input_file(std::string(filename.data(), filename.length()));
+    if (!input_file) {
+        return absl::NotFoundError("can not open " + std::string(filename));
+    }
     std::string line;
     uint32_t index = 0;
-    while (!input_file.eof()) {
-        std::getline(input_file, line);
+    uint64_t line_number = 0;
+    while (std::getline(input_file, line)) {
+        ++line_number;
         if (line.length() == 0) {
             continue;
         }
         if (!exclude.empty() && absl::StartsWith(line, exclude)) {
             continue;
         }
+        if (validate_utf8) {
+            size_t invalid = string::FindInvalidUtf8(line);
+            if (invalid != line.size()) {
+                return absl::InvalidArgumentError(
+                    std::string(filename) + ":" + std::to_string(line_number) +
+                    ": invalid utf-8 at offset " + std::to_string(invalid));
+            }
+        }
         callback(line, index);
         ++index;
     }
+    return absl::OkStatus();
+}
+
+}  // namespace
+
+// load file and line process callback
+void LoadFile(absl::string_view filename,
+              std::function<void(const std::string &, uint32_t)> &callback,
+              absl::string_view exclude = "") {
+    LoadLines(filename, callback, exclude, false).IgnoreError();
+}
+
+absl::Status LoadUtf8File(absl::string_view filename,
+                          const std::function<void(const std::string &, uint32_t)> &callback,
+                          absl::string_view exclude) {
+    return LoadLines(filename, callback, exclude, true);
 }
 
 }  // namespace io
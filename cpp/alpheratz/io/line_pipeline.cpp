@@ -0,0 +1,390 @@
+#include <absl/synchronization/blocking_counter.h>
+#include <alpheratz/io/line_pipeline.h>
+#include <alpheratz/compress/zstd.h>
+#include <alpheratz/concurrent/spsc_queue.h>
+#include <alpheratz/concurrent/thread_pool.h>
+#include <alpheratz/io/unique_handle.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <utility>
+
+namespace alpheratz {
+namespace io {
+
+namespace {
+
+// a piece of the file or of the decompressed text, owner is null for mapped data
+struct Block {
+    std::shared_ptr<const std::string> owner;
+    absl::string_view data;
+};
+
+using BlockQueue = concurrent::SpscQueue<Block>;
+using BatchQueue = concurrent::SpscQueue<std::unique_ptr<LineBatch>>;
+
+// little endian 28 b5 2f fd
+constexpr uint32_t kZstdMagic = 0xFD2FB528;
+
+uint64_t NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+absl::Status ErrnoError(const std::string &what) {
+    int error = errno;
+    return absl::Status(absl::ErrnoToStatusCode(error), what + ": " + std::strerror(error));
+}
+
+// time a stage spends blocked inside the queue call passed in
+template <typename Call>
+auto Timed(StageStats *stats, Call &&call) -> decltype(call()) {
+    uint64_t start = NowNanos();
+    auto result = call();
+    stats->wait_ns += NowNanos() - start;
+    return result;
+}
+
+// the stages of one Run and what they share
+class Runner {
+   public:
+    Runner(const PipelineOptions &options, std::vector<StageStats> *stats,
+           concurrent::ThreadPool *pool)
+        : options_(options), stats_(stats), pool_(pool) {}
+
+    absl::Status Run(absl::string_view path, const LinePipeline::Callback &callback) {
+        std::string name(path.data(), path.size());
+        fd_.Reset(::open(name.c_str(), O_RDONLY | O_CLOEXEC));
+        if (!fd_.Valid()) {
+            return ErrnoError("open " + name);
+        }
+        absl::Status status = Prepare();
+        if (!status.ok()) {
+            return status;
+        }
+
+        size_t depth = std::max<size_t>(options_.queue_depth, 1);
+        // every stage blocks on its links, so each needs a worker of its own
+        std::vector<std::function<void()>> stages;
+        stats_->clear();
+        stats_->reserve(5);
+        BlockQueue raw(depth);
+        BlockQueue text(depth);
+        BatchQueue lines(depth);
+        BatchQueue fields(depth);
+        closers_ = {[&]() { raw.Close(); }, [&]() { text.Close(); }, [&]() { lines.Close(); },
+                    [&]() { fields.Close(); }};
+
+        StageStats *read = AddStage("read");
+        stages.emplace_back([&, read]() { Read(&raw, read); });
+        BlockQueue *text_in = &raw;
+        if (zstd_) {
+            StageStats *decompress = AddStage("decompress");
+            stages.emplace_back([&, decompress]() { Decompress(&raw, &text, decompress); });
+            text_in = &text;
+        }
+        StageStats *split = AddStage("split");
+        stages.emplace_back([&, split, text_in]() { Split(text_in, &lines, split); });
+        BatchQueue *done = &lines;
+        if (!options_.delimiter.empty()) {
+            StageStats *cut = AddStage("fields");
+            stages.emplace_back([&, cut]() { Fields(&lines, &fields, cut); });
+            done = &fields;
+        }
+        StageStats *process = AddStage("process");
+        absl::BlockingCounter running(static_cast<int>(stages.size()));
+        for (auto &stage : stages) {
+            pool_->Execute([&stage, &running]() {
+                stage();
+                running.DecrementCount();
+            });
+        }
+        try {
+            Process(done, callback, process);
+        } catch (...) {
+            Abort(absl::AbortedError("callback threw"));
+            running.Wait();
+            throw;
+        }
+        running.Wait();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return status_;
+    }
+
+   private:
+    StageStats *AddStage(const char *name) {
+        stats_->emplace_back();
+        stats_->back().name = name;
+        return &stats_->back();
+    }
+
+    // detects compression and maps the file
+    absl::Status Prepare() {
+        struct stat st;
+        if (::fstat(fd_.Get(), &st) != 0) {
+            return ErrnoError("fstat");
+        }
+        size_ = static_cast<uint64_t>(st.st_size);
+        zstd_ = options_.compression == PipelineCompression::kZstd;
+        if (options_.compression == PipelineCompression::kAuto) {
+            unsigned char magic[4];
+            if (::pread(fd_.Get(), magic, sizeof(magic), 0) == sizeof(magic)) {
+                uint32_t value = magic[0] | magic[1] << 8 | magic[2] << 16 |
+                                 static_cast<uint32_t>(magic[3]) << 24;
+                zstd_ = value == kZstdMagic;
+            }
+        }
+        if (options_.source == PipelineSource::kMmap && size_ > 0) {
+            map_.Reset({::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_.Get(), 0), size_});
+            if (!map_.Valid()) {
+                return ErrnoError("mmap");
+            }
+            ::madvise(map_.Get().data, size_, MADV_SEQUENTIAL);
+        }
+        return absl::OkStatus();
+    }
+
+    // first error wins, closing every link wakes and stops all stages
+    void Abort(absl::Status status) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!status_.ok()) return;
+            status_ = std::move(status);
+        }
+        failed_.store(true, std::memory_order_release);
+        for (auto &close : closers_) {
+            close();
+        }
+    }
+    bool Failed() const { return failed_.load(std::memory_order_acquire); }
+
+    size_t BlockSize() const { return std::max<size_t>(options_.block_size, 1); }
+
+    void Read(BlockQueue *out, StageStats *stats) {
+        uint64_t start = NowNanos();
+        if (map_.Valid()) {
+            const char *data = static_cast<const char *>(map_.Get().data);
+            for (uint64_t offset = 0; offset < size_ && !Failed(); offset += BlockSize()) {
+                size_t size = std::min<uint64_t>(BlockSize(), size_ - offset);
+                Block block{nullptr, absl::string_view(data + offset, size)};
+                ++stats->items;
+                stats->bytes += block.data.size();
+                if (!Timed(stats, [&]() { return out->Push(std::move(block)); })) break;
+            }
+        } else {
+            while (!Failed()) {
+                auto buffer = std::make_shared<std::string>(BlockSize(), '\0');
+                size_t used = 0;
+                while (used < buffer->size()) {
+                    ssize_t n = ::read(fd_.Get(), &(*buffer)[used], buffer->size() - used);
+                    if (n < 0) {
+                        if (errno == EINTR) continue;
+                        Abort(ErrnoError("read"));
+                        break;
+                    }
+                    if (n == 0) break;
+                    used += n;
+                }
+                if (used == 0 || Failed()) break;
+                buffer->resize(used);
+                ++stats->items;
+                stats->bytes += used;
+                Block block{buffer, *buffer};
+                if (!Timed(stats, [&]() { return out->Push(std::move(block)); })) break;
+                if (used < BlockSize()) break;
+            }
+        }
+        out->Close();
+        stats->busy_ns = NowNanos() - start - stats->wait_ns;
+    }
+
+    void Decompress(BlockQueue *in, BlockQueue *out, StageStats *stats) {
+        uint64_t start = NowNanos();
+        compress::UniqueZstdDCtx dctx(ZSTD_createDCtx());
+        if (!dctx.Valid()) {
+            Abort(absl::ResourceExhaustedError("ZSTD_createDCtx failed"));
+        }
+        auto buffer = std::make_shared<std::string>(BlockSize(), '\0');
+        size_t used = 0;
+        // 0 once a frame is complete
+        size_t rest = 0;
+        auto push = [&]() {
+            buffer->resize(used);
+            Block block{buffer, *buffer};
+            buffer = std::make_shared<std::string>(BlockSize(), '\0');
+            used = 0;
+            return Timed(stats, [&]() { return out->Push(std::move(block)); });
+        };
+        Block block;
+        while (!Failed() && Timed(stats, [&]() { return in->Pop(&block); })) {
+            ++stats->items;
+            stats->bytes += block.data.size();
+            ZSTD_inBuffer input = {block.data.data(), block.data.size(), 0};
+            // a full output may leave data inside the context, so call again after it
+            bool full = true;
+            while ((input.pos < input.size || full) && !Failed()) {
+                ZSTD_outBuffer output = {&(*buffer)[0], buffer->size(), used};
+                rest = ZSTD_decompressStream(dctx.Get(), &output, &input);
+                if (ZSTD_isError(rest)) {
+                    Abort(absl::DataLossError(std::string("zstd: ") + ZSTD_getErrorName(rest)));
+                    break;
+                }
+                used = output.pos;
+                full = used == buffer->size();
+                if (full && !push()) break;
+            }
+        }
+        if (!Failed()) {
+            if (rest != 0) {
+                Abort(absl::DataLossError("zstd: truncated frame"));
+            } else if (used > 0) {
+                push();
+            }
+        }
+        out->Close();
+        stats->busy_ns = NowNanos() - start - stats->wait_ns;
+    }
+
+    void Split(BlockQueue *in, BatchQueue *out, StageStats *stats) {
+        uint64_t start = NowNanos();
+        size_t per_batch = std::max<size_t>(options_.lines_per_batch, 1);
+        uint64_t line = 0;
+        auto batch = std::make_unique<LineBatch>();
+        batch->lines.reserve(per_batch);
+        // the start of a line cut by the end of a block
+        std::string carry;
+        auto flush = [&]() {
+            line += batch->lines.size();
+            bool pushed = Timed(stats, [&]() { return out->Push(std::move(batch)); });
+            batch = std::make_unique<LineBatch>();
+            batch->first_line = line;
+            batch->lines.reserve(per_batch);
+            return pushed;
+        };
+        Block block;
+        bool stopped = false;
+        while (!stopped && !Failed() && Timed(stats, [&]() { return in->Pop(&block); })) {
+            ++stats->items;
+            stats->bytes += block.data.size();
+            absl::string_view data = block.data;
+            bool referenced = false;
+            size_t pos = 0;
+            size_t end;
+            while ((end = data.find('\n', pos)) != absl::string_view::npos) {
+                if (!carry.empty()) {
+                    carry.append(data.data() + pos, end - pos);
+                    batch->stitched.push_back(std::move(carry));
+                    carry.clear();
+                    batch->lines.push_back(batch->stitched.back());
+                } else {
+                    if (!referenced && block.owner != nullptr) {
+                        batch->blocks.push_back(block.owner);
+                        referenced = true;
+                    }
+                    batch->lines.push_back(data.substr(pos, end - pos));
+                }
+                pos = end + 1;
+                if (batch->lines.size() == per_batch) {
+                    referenced = false;
+                    if (!flush()) {
+                        stopped = true;
+                        break;
+                    }
+                }
+            }
+            carry.append(data.data() + pos, data.size() - pos);
+        }
+        if (!stopped && !Failed()) {
+            if (!carry.empty()) {
+                // the last line has no '\n'
+                batch->stitched.push_back(std::move(carry));
+                batch->lines.push_back(batch->stitched.back());
+            }
+            if (!batch->lines.empty()) flush();
+        }
+        out->Close();
+        stats->busy_ns = NowNanos() - start - stats->wait_ns;
+    }
+
+    void Fields(BatchQueue *in, BatchQueue *out, StageStats *stats) {
+        uint64_t start = NowNanos();
+        absl::string_view delimiter = options_.delimiter;
+        std::unique_ptr<LineBatch> batch;
+        while (!Failed() && Timed(stats, [&]() { return in->Pop(&batch); })) {
+            ++stats->items;
+            batch->field_begin.reserve(batch->lines.size() + 1);
+            batch->field_begin.push_back(0);
+            for (absl::string_view line : batch->lines) {
+                stats->bytes += line.size() + 1;
+                size_t pos = 0;
+                size_t end;
+                while ((end = line.find(delimiter, pos)) != absl::string_view::npos) {
+                    batch->fields.push_back(line.substr(pos, end - pos));
+                    pos = end + delimiter.size();
+                }
+                batch->fields.push_back(line.substr(pos));
+                batch->field_begin.push_back(static_cast<uint32_t>(batch->fields.size()));
+            }
+            if (!Timed(stats, [&]() { return out->Push(std::move(batch)); })) break;
+        }
+        out->Close();
+        stats->busy_ns = NowNanos() - start - stats->wait_ns;
+    }
+
+    void Process(BatchQueue *in, const LinePipeline::Callback &callback, StageStats *stats) {
+        uint64_t start = NowNanos();
+        std::unique_ptr<LineBatch> batch;
+        while (Timed(stats, [&]() { return in->Pop(&batch); })) {
+            if (Failed()) continue;
+            ++stats->items;
+            for (absl::string_view line : batch->lines) {
+                stats->bytes += line.size() + 1;
+            }
+            callback(*batch);
+        }
+        stats->busy_ns = NowNanos() - start - stats->wait_ns;
+    }
+
+    const PipelineOptions &options_;
+    std::vector<StageStats> *stats_;
+    concurrent::ThreadPool *pool_;
+    UniqueFd fd_;
+    UniqueMmap map_;
+    uint64_t size_ = 0;
+    bool zstd_ = false;
+
+    std::vector<std::function<void()>> closers_;
+    std::mutex mutex_;
+    absl::Status status_;
+    std::atomic<bool> failed_{false};
+};
+
+}  // namespace
+
+LinePipeline::LinePipeline(const PipelineOptions &options) : options_(options) {
+    // read and split, decompress and fields when they may run
+    concurrent::ThreadPoolOptions pool_options;
+    pool_options.threads = 2 + (options_.compression != PipelineCompression::kNone) +
+                           !options_.delimiter.empty();
+    pool_options.name = "alpheratz-line";
+    pool_ = std::make_unique<concurrent::ThreadPool>(pool_options);
+}
+
+LinePipeline::~LinePipeline() = default;
+
+absl::Status LinePipeline::Run(absl::string_view path, const Callback &callback) {
+    Runner runner(options_, &stats_, pool_.get());
+    return runner.Run(path, callback);
+}
+
+}  // namespace io
+}  // namespace alpheratz
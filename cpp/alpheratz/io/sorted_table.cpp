@@ -0,0 +1,304 @@
+#include <absl/strings/match.h>
+#include <alpheratz/compress/integer_codec.h>
+#include <alpheratz/io/line_pipeline.h>
+#include <alpheratz/io/sorted_table.h>
+#include <alpheratz/string/string_arena.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+namespace alpheratz {
+namespace io {
+
+namespace {
+
+// "ALPSTBL1" read as little endian
+constexpr uint64_t kMagic = 0x314C425453504C41ull;
+// index offset, offsets offset, block count, entry count, magic
+constexpr size_t kFooterSize = 5 * 8;
+
+absl::Status ErrnoError(const std::string &what) {
+    int error = errno;
+    return absl::Status(absl::ErrnoToStatusCode(error), what + ": " + std::strerror(error));
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<SortedTableBuilder>> SortedTableBuilder::Create(
+    absl::string_view path, const SortedTableOptions &options) {
+    auto writer = Writer::Open(path);
+    if (!writer.ok()) {
+        return writer.status();
+    }
+    return std::unique_ptr<SortedTableBuilder>(
+        new SortedTableBuilder(std::move(*writer), options));
+}
+
+SortedTableBuilder::SortedTableBuilder(std::unique_ptr<Writer> writer,
+                                       const SortedTableOptions &options)
+    : writer_(std::move(writer)), block_size_(std::max<size_t>(options.block_size, 1)) {}
+
+absl::Status SortedTableBuilder::Add(absl::string_view key, absl::string_view value) {
+    if (finished_) {
+        return absl::FailedPreconditionError("table already finished");
+    }
+    if (entries_ > 0 && key <= last_key_) {
+        return absl::InvalidArgumentError("keys out of order at \"" + std::string(key) + "\"");
+    }
+    size_t shared = 0;
+    if (block_entries_ == 0) {
+        // the sparse index gets the whole first key of the block
+        index_offsets_.push_back(index_.size());
+        compress::PutVarint(&index_, key.size());
+        index_.append(key.data(), key.size());
+    } else {
+        size_t limit = std::min(key.size(), last_key_.size());
+        while (shared < limit && key[shared] == last_key_[shared]) ++shared;
+    }
+    compress::PutVarint(&block_, shared);
+    compress::PutVarint(&block_, key.size() - shared);
+    compress::PutVarint(&block_, value.size());
+    block_.append(key.data() + shared, key.size() - shared);
+    block_.append(value.data(), value.size());
+    last_key_.assign(key.data(), key.size());
+    ++entries_;
+    ++block_entries_;
+    if (block_.size() >= block_size_) {
+        return FlushBlock();
+    }
+    return absl::OkStatus();
+}
+
+absl::Status SortedTableBuilder::FlushBlock() {
+    if (block_entries_ == 0) {
+        return absl::OkStatus();
+    }
+    compress::PutVarint(&index_, writer_->BytesAppended());
+    compress::PutVarint(&index_, block_.size());
+    absl::Status status = writer_->Append(block_);
+    block_.clear();
+    block_entries_ = 0;
+    return status;
+}
+
+absl::Status SortedTableBuilder::Finish() {
+    if (finished_) {
+        return absl::OkStatus();
+    }
+    finished_ = true;
+    absl::Status status = FlushBlock();
+    if (!status.ok()) {
+        return status;
+    }
+    uint64_t index_offset = writer_->BytesAppended();
+    std::string tail;
+    uint64_t offsets_offset = index_offset + index_.size();
+    for (uint64_t offset : index_offsets_) {
+        compress::PutFixed64(&tail, index_offset + offset);
+    }
+    compress::PutFixed64(&tail, index_offset);
+    compress::PutFixed64(&tail, offsets_offset);
+    compress::PutFixed64(&tail, index_offsets_.size());
+    compress::PutFixed64(&tail, entries_);
+    compress::PutFixed64(&tail, kMagic);
+    absl::string_view parts[] = {index_, tail};
+    status = writer_->Append(parts, 2);
+    if (!status.ok()) {
+        return status;
+    }
+    return writer_->Close();
+}
+
+absl::Status BuildSortedTable(absl::string_view text_path, absl::string_view table_path,
+                              const SortedTableOptions &options) {
+    // the whole dictionary is sorted in memory, keys and values packed in an arena
+    string::StringArena arena(1 << 20);
+    std::vector<std::pair<absl::string_view, absl::string_view>> entries;
+    absl::string_view delimiter = options.delimiter;
+    LinePipeline pipeline;
+    absl::Status status = pipeline.Run(text_path, [&](const LineBatch &batch) {
+        for (absl::string_view line : batch.lines) {
+            if (line.empty()) continue;
+            if (!options.exclude.empty() && absl::StartsWith(line, options.exclude)) continue;
+            size_t split = delimiter.empty() ? absl::string_view::npos : line.find(delimiter);
+            absl::string_view key = line.substr(0, split);
+            absl::string_view value;
+            if (split != absl::string_view::npos) {
+                value = line.substr(split + delimiter.size());
+            }
+            entries.emplace_back(arena.Copy(key), arena.Copy(value));
+        }
+    });
+    if (!status.ok()) {
+        return status;
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+    auto builder = SortedTableBuilder::Create(table_path, options);
+    if (!builder.ok()) {
+        return builder.status();
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first) {
+            // a later line repeats the key
+            continue;
+        }
+        status = (*builder)->Add(entries[i].first, entries[i].second);
+        if (!status.ok()) {
+            return status;
+        }
+    }
+    return (*builder)->Finish();
+}
+
+absl::StatusOr<std::unique_ptr<SortedTable>> SortedTable::Open(absl::string_view path) {
+    std::string name(path.data(), path.size());
+    std::unique_ptr<SortedTable> table(new SortedTable());
+    table->fd_.Reset(::open(name.c_str(), O_RDONLY | O_CLOEXEC));
+    if (!table->fd_.Valid()) {
+        return ErrnoError("open " + name);
+    }
+    struct stat st;
+    if (::fstat(table->fd_.Get(), &st) != 0) {
+        return ErrnoError("fstat " + name);
+    }
+    table->size_ = static_cast<uint64_t>(st.st_size);
+    if (table->size_ < kFooterSize) {
+        return absl::DataLossError(name + ": too small for a sorted table");
+    }
+    table->map_.Reset(
+        {::mmap(nullptr, table->size_, PROT_READ, MAP_SHARED, table->fd_.Get(), 0),
+         table->size_});
+    if (!table->map_.Valid()) {
+        return ErrnoError("mmap " + name);
+    }
+    // lookups jump around, read ahead would only waste page cache
+    ::madvise(table->map_.Get().data, table->size_, MADV_RANDOM);
+    table->data_ = static_cast<const char *>(table->map_.Get().data);
+
+    const char *footer = table->data_ + table->size_ - kFooterSize;
+    uint64_t index_offset = compress::GetFixed64(footer);
+    table->offsets_offset_ = compress::GetFixed64(footer + 8);
+    table->blocks_ = compress::GetFixed64(footer + 16);
+    table->entries_ = compress::GetFixed64(footer + 24);
+    uint64_t offsets_end = table->size_ - kFooterSize;
+    if (compress::GetFixed64(footer + 32) != kMagic || index_offset > table->offsets_offset_ ||
+        table->offsets_offset_ > offsets_end ||
+        (offsets_end - table->offsets_offset_) / 8 != table->blocks_) {
+        return absl::DataLossError(name + ": not a sorted table or corrupted");
+    }
+    return table;
+}
+
+bool SortedTable::IndexEntry(uint64_t block, absl::string_view *first_key, uint64_t *offset,
+                             uint64_t *size) const {
+    uint64_t entry = compress::GetFixed64(data_ + offsets_offset_ + block * 8);
+    if (entry >= offsets_offset_) return false;
+    const char *p = data_ + entry;
+    const char *end = data_ + offsets_offset_;
+    uint64_t key_size;
+    if (!compress::GetVarint(&p, end, &key_size) || key_size > static_cast<uint64_t>(end - p)) {
+        return false;
+    }
+    *first_key = absl::string_view(p, key_size);
+    p += key_size;
+    return compress::GetVarint(&p, end, offset) && compress::GetVarint(&p, end, size) &&
+           *offset <= offsets_offset_ && *size <= offsets_offset_ - *offset;
+}
+
+uint64_t SortedTable::FindBlock(absl::string_view key) const {
+    // the first block whose first key is greater than key, then one back
+    uint64_t low = 0;
+    uint64_t high = blocks_;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        absl::string_view first_key;
+        uint64_t offset, size;
+        if (IndexEntry(mid, &first_key, &offset, &size) && first_key <= key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low == 0 ? 0 : low - 1;
+}
+
+bool SortedTable::Find(absl::string_view key, absl::string_view *value) const {
+    Iterator it(this);
+    it.Seek(key);
+    if (!it.Valid() || it.Key() != key) {
+        return false;
+    }
+    *value = it.Value();
+    return true;
+}
+
+void SortedTable::ScanPrefix(
+    absl::string_view prefix,
+    const std::function<bool(absl::string_view, absl::string_view)> &fn) const {
+    Iterator it(this);
+    for (it.Seek(prefix); it.Valid() && absl::StartsWith(it.Key(), prefix); it.Next()) {
+        if (!fn(it.Key(), it.Value())) break;
+    }
+}
+
+bool SortedTable::Iterator::LoadBlock(uint64_t block) {
+    absl::string_view first_key;
+    uint64_t offset, size;
+    if (block >= table_->blocks_ || !table_->IndexEntry(block, &first_key, &offset, &size)) {
+        return false;
+    }
+    block_ = block;
+    pos_ = table_->data_ + offset;
+    end_ = pos_ + size;
+    key_.clear();
+    return true;
+}
+
+void SortedTable::Iterator::ParseNext() {
+    while (pos_ == end_) {
+        if (!LoadBlock(block_ + 1)) {
+            valid_ = false;
+            return;
+        }
+    }
+    uint64_t shared, rest, value_size;
+    if (!compress::GetVarint(&pos_, end_, &shared) || !compress::GetVarint(&pos_, end_, &rest) ||
+        !compress::GetVarint(&pos_, end_, &value_size) || shared > key_.size() ||
+        rest > static_cast<uint64_t>(end_ - pos_) ||
+        value_size > static_cast<uint64_t>(end_ - pos_) - rest) {
+        // corrupted block
+        valid_ = false;
+        return;
+    }
+    key_.resize(shared);
+    key_.append(pos_, rest);
+    value_ = absl::string_view(pos_ + rest, value_size);
+    pos_ += rest + value_size;
+    valid_ = true;
+}
+
+void SortedTable::Iterator::SeekToFirst() {
+    valid_ = LoadBlock(0);
+    if (valid_) ParseNext();
+}
+
+void SortedTable::Iterator::Seek(absl::string_view target) {
+    valid_ = LoadBlock(table_->FindBlock(target));
+    if (!valid_) return;
+    // keys before target in this block are skipped, the next block starts above it
+    for (ParseNext(); valid_ && absl::string_view(key_) < target; ParseNext()) {
+    }
+}
+
+void SortedTable::Iterator::Next() {
+    if (valid_) ParseNext();
+}
+
+}  // namespace io
+}  // namespace alpheratz
@@ -0,0 +1,308 @@
+#include <alpheratz/io/writer.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace alpheratz {
+namespace io {
+
+namespace {
+
+// iovecs per writev, far below IOV_MAX
+constexpr int kMaxIov = 64;
+
+absl::Status ErrnoError(const std::string &what) {
+    int error = errno;
+    return absl::Status(absl::ErrnoToStatusCode(error), what + ": " + std::strerror(error));
+}
+
+bool DropDirect(int fd) {
+#ifdef O_DIRECT
+    int flags = ::fcntl(fd, F_GETFL);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags & ~O_DIRECT) == 0;
+#else
+    return true;
+#endif
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<Writer>> Writer::Open(absl::string_view path,
+                                                     const WriterOptions &options) {
+    std::string name(path.data(), path.size());
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (options.append ? O_APPEND : O_TRUNC);
+    UniqueFd fd;
+    bool direct = false;
+#ifdef O_DIRECT
+    if (options.direct) {
+        fd.Reset(::open(name.c_str(), flags | O_DIRECT, options.mode));
+        if (!fd.Valid() && errno != EINVAL) {
+            return ErrnoError("open " + name);
+        }
+        direct = fd.Valid();
+    }
+#endif
+    if (!fd.Valid()) {
+        fd.Reset(::open(name.c_str(), flags, options.mode));
+        if (!fd.Valid()) {
+            return ErrnoError("open " + name);
+        }
+    }
+    if (direct && options.append) {
+        // appending at an unaligned end would fail every direct write
+        struct stat st;
+        if (::fstat(fd.Get(), &st) != 0 || st.st_size % kAlignment != 0) {
+            direct = !DropDirect(fd.Get());
+        }
+    }
+
+    size_t capacity = std::max(options.buffer_size, kAlignment);
+    capacity = (capacity + kAlignment - 1) / kAlignment * kAlignment;
+    void *buffer = nullptr;
+    if (::posix_memalign(&buffer, kAlignment, capacity) != 0) {
+        return absl::ResourceExhaustedError("no memory for a writer buffer of " +
+                                            std::to_string(capacity) + " bytes");
+    }
+    std::unique_ptr<Writer> writer(
+        new Writer(std::move(fd), static_cast<char *>(buffer), capacity, direct, options));
+    if (options.zstd) {
+        writer->zstd_.Reset(ZSTD_createCCtx());
+        if (!writer->zstd_.Valid()) {
+            return absl::ResourceExhaustedError("ZSTD_createCCtx failed");
+        }
+        size_t ret = ZSTD_CCtx_setParameter(writer->zstd_.Get(), ZSTD_c_compressionLevel,
+                                            options.zstd_level);
+        if (ZSTD_isError(ret)) {
+            return absl::InvalidArgumentError(ZSTD_getErrorName(ret));
+        }
+    }
+    return writer;
+}
+
+Writer::Writer(UniqueFd fd, char *buffer, size_t capacity, bool direct,
+               const WriterOptions &options)
+    : fd_(std::move(fd)),
+      buffer_(buffer),
+      capacity_(capacity),
+      direct_(direct),
+      sync_(options.sync),
+      sync_data_only_(options.sync_data_only),
+      sync_bytes_(options.sync_bytes) {}
+
+Writer::~Writer() {
+    Close().IgnoreError();
+    std::free(buffer_);
+}
+
+absl::Status Writer::Append(absl::string_view data) { return Append(&data, 1); }
+
+absl::Status Writer::Append(const absl::string_view *parts, size_t count) {
+    if (!fd_.Valid()) {
+        return absl::FailedPreconditionError("writer is closed");
+    }
+    for (size_t i = 0; i < count; ++i) {
+        appended_ += parts[i].size();
+    }
+    if (!zstd_.Valid()) {
+        return AppendRaw(parts, count);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        absl::Status status = Compress(parts[i], ZSTD_e_continue);
+        if (!status.ok()) {
+            return status;
+        }
+    }
+    return absl::OkStatus();
+}
+
+absl::Status Writer::AppendRaw(const absl::string_view *parts, size_t count) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += parts[i].size();
+    }
+    if (total <= capacity_ - used_) {
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(buffer_ + used_, parts[i].data(), parts[i].size());
+            used_ += parts[i].size();
+        }
+        return absl::OkStatus();
+    }
+    if (direct_) {
+        // direct writes need aligned memory, so data goes through the buffer
+        for (size_t i = 0; i < count; ++i) {
+            const char *data = parts[i].data();
+            size_t left = parts[i].size();
+            while (left > 0) {
+                if (used_ == capacity_) {
+                    absl::Status status = WriteBuffer(false);
+                    if (!status.ok()) {
+                        return status;
+                    }
+                }
+                size_t take = std::min(left, capacity_ - used_);
+                std::memcpy(buffer_ + used_, data, take);
+                used_ += take;
+                data += take;
+                left -= take;
+            }
+        }
+        return absl::OkStatus();
+    }
+    struct iovec iov[kMaxIov];
+    int n = 0;
+    if (used_ > 0) {
+        iov[n++] = {buffer_, used_};
+    }
+    used_ = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (parts[i].empty()) continue;
+        iov[n++] = {const_cast<char *>(parts[i].data()), parts[i].size()};
+        if (n == kMaxIov || i + 1 == count) {
+            absl::Status status = WriteAll(iov, n);
+            if (!status.ok()) {
+                return status;
+            }
+            n = 0;
+        }
+    }
+    return n > 0 ? WriteAll(iov, n) : absl::OkStatus();
+}
+
+absl::Status Writer::Compress(absl::string_view data, int directive) {
+    ZSTD_inBuffer in = {data.data(), data.size(), 0};
+    while (true) {
+        if (used_ == capacity_) {
+            absl::Status status = WriteBuffer(false);
+            if (!status.ok()) {
+                return status;
+            }
+        }
+        ZSTD_outBuffer out = {buffer_ + used_, capacity_ - used_, 0};
+        size_t rest = ZSTD_compressStream2(zstd_.Get(), &out, &in,
+                                           static_cast<ZSTD_EndDirective>(directive));
+        used_ += out.pos;
+        if (ZSTD_isError(rest)) {
+            return absl::InternalError(ZSTD_getErrorName(rest));
+        }
+        // continue is done once input is taken, flush and end once nothing is left inside
+        if (directive == ZSTD_e_continue ? in.pos == in.size : rest == 0) {
+            return absl::OkStatus();
+        }
+    }
+}
+
+absl::Status Writer::WriteBuffer(bool all) {
+    size_t size = used_;
+    if (direct_ && !all) {
+        size -= used_ % kAlignment;
+    }
+    if (size == 0) {
+        return absl::OkStatus();
+    }
+    struct iovec iov = {buffer_, size};
+    absl::Status status = WriteAll(&iov, 1);
+    std::memmove(buffer_, buffer_ + size, used_ - size);
+    used_ -= size;
+    return status;
+}
+
+absl::Status Writer::WriteAll(struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t n = ::writev(fd_.Get(), iov, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return ErrnoError("writev");
+        }
+        written_ += n;
+        unsynced_ += n;
+        // skip what went out, a short write resumes inside an iovec
+        while (count > 0 && static_cast<size_t>(n) >= iov->iov_len) {
+            n -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + n;
+            iov->iov_len -= n;
+        }
+    }
+    if (sync_bytes_ > 0 && unsynced_ >= sync_bytes_) {
+        return SyncFd();
+    }
+    return absl::OkStatus();
+}
+
+absl::Status Writer::SyncFd() {
+#ifdef __APPLE__
+    int ret = ::fsync(fd_.Get());
+#else
+    int ret = sync_data_only_ ? ::fdatasync(fd_.Get()) : ::fsync(fd_.Get());
+#endif
+    if (ret != 0) {
+        return ErrnoError(sync_data_only_ ? "fdatasync" : "fsync");
+    }
+    unsynced_ = 0;
+    return absl::OkStatus();
+}
+
+absl::Status Writer::Flush() {
+    if (!fd_.Valid()) {
+        return absl::FailedPreconditionError("writer is closed");
+    }
+    if (zstd_.Valid()) {
+        absl::Status status = Compress({}, ZSTD_e_flush);
+        if (!status.ok()) {
+            return status;
+        }
+    }
+    absl::Status status = WriteBuffer(false);
+    if (!status.ok() || sync_ != SyncPolicy::kOnFlush) {
+        return status;
+    }
+    return SyncFd();
+}
+
+absl::Status Writer::Sync() {
+    absl::Status status = Flush();
+    if (!status.ok() || sync_ == SyncPolicy::kOnFlush) {
+        return status;
+    }
+    return SyncFd();
+}
+
+absl::Status Writer::Close() {
+    if (!fd_.Valid()) {
+        return absl::OkStatus();
+    }
+    absl::Status status;
+    if (zstd_.Valid()) {
+        status = Compress({}, ZSTD_e_end);
+        zstd_.Reset();
+    }
+    if (status.ok()) {
+        status = WriteBuffer(false);
+    }
+    if (status.ok() && used_ > 0) {
+        // the unaligned tail of a direct file goes through the page cache
+        direct_ = !DropDirect(fd_.Get());
+        status = WriteBuffer(true);
+    }
+    if (status.ok() && sync_ != SyncPolicy::kNone) {
+        status = SyncFd();
+    }
+    // close directly, its error is the last chance to hear about lost writes
+    if (::close(fd_.Release()) != 0 && status.ok()) {
+        status = ErrnoError("close");
+    }
+    return status;
+}
+
+}  // namespace io
+}  // namespace alpheratz
@@ -0,0 +1,465 @@
+#include <absl/strings/string_view.h>
+#include <alpheratz/compress/integer_codec.h>
+#include <alpheratz/io/file_loader.h>
+#include <alpheratz/io/writer.h>
+#include <alpheratz/string/double_array_trie.h>
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iterator>
+
+namespace alpheratz {
+namespace string {
+
+namespace {
+
+// "ALPDAT01" read as little endian
+constexpr uint64_t kMagic = 0x3130544144504C41ull;
+// magic, slots, keys
+constexpr size_t kHeaderSize = 3 * 8;
+// base, check, fail, report, value, length
+constexpr size_t kSlotFields = 6;
+
+}  // namespace
+
+/**
+ * states are placed breadth first. the children of a state need a base where every
+ * child slot is free, candidates come from a list of the free slots in the last few
+ * blocks of 256; older blocks are closed once they fall behind, their free slots stay
+ * unused, which bounds the search. breadth first order also means the failure links of
+ * all shallower states exist when a state is placed, so they are set on the way
+ */
+class DoubleArrayTrie::Builder {
+   public:
+    Builder(DoubleArrayTrie *trie, const std::vector<std::pair<std::string, uint32_t>> &entries)
+        : trie_(trie), entries_(entries) {}
+
+    void Run() {
+        AddBlock();
+        Take(0);
+        trie_->nodes_[0] = {0, kEmpty, 0, 0};
+        std::deque<Pending> queue;
+        queue.push_back({0, 0, entries_.size(), 0});
+        std::vector<Edge> edges;
+        while (!queue.empty()) {
+            Pending node = queue.front();
+            queue.pop_front();
+            // the key ending at this state, if any, comes first and was set on placing it
+            size_t i = node.begin;
+            if (i < node.end && entries_[i].first.size() == node.depth) ++i;
+            auto byte_at = [&](size_t k) {
+                return static_cast<uint8_t>(entries_[k].first[node.depth]);
+            };
+            edges.clear();
+            while (i < node.end) {
+                uint8_t byte = byte_at(i);
+                size_t j = i + 1;
+                while (j < node.end && byte_at(j) == byte) ++j;
+                edges.push_back({byte, i, j});
+                i = j;
+            }
+            if (edges.empty()) continue;
+            uint32_t base = FindBase(edges);
+            trie_->nodes_[node.state].base = base;
+            for (const Edge &edge : edges) {
+                uint32_t child = base + edge.byte;
+                Take(child);
+                trie_->nodes_[child].check = node.state;
+                // values are set before any link reads them, a failure link may lead to
+                // a state of the same depth that is still queued
+                const auto &entry = entries_[edge.begin];
+                if (entry.first.size() == node.depth + 1) {
+                    trie_->value_[child] = entry.second;
+                    trie_->length_[child] = static_cast<uint32_t>(node.depth + 1);
+                }
+                Link(node.state, child, edge.byte);
+                queue.push_back({child, edge.begin, edge.end, node.depth + 1});
+            }
+        }
+        // free slots past the last used one are only padding
+        size_t size = state_.size();
+        while (size > 1 && state_[size - 1] != kUsed) --size;
+        trie_->nodes_.resize(size);
+        trie_->value_.resize(size);
+        trie_->length_.resize(size);
+        trie_->nodes_.shrink_to_fit();
+        trie_->value_.shrink_to_fit();
+        trie_->length_.shrink_to_fit();
+    }
+
+   private:
+    struct Pending {
+        uint32_t state;
+        size_t begin;
+        size_t end;
+        size_t depth;
+    };
+    struct Edge {
+        uint8_t byte;
+        size_t begin;
+        size_t end;
+    };
+    enum SlotState : uint8_t { kFree, kUsed, kClosed };
+
+    static constexpr size_t kBlock = 256;
+    // blocks whose free slots are still candidates
+    static constexpr size_t kOpenBlocks = 16;
+
+    void AddBlock() {
+        size_t begin = state_.size();
+        size_t size = begin + kBlock;
+        state_.resize(size, kFree);
+        trie_->nodes_.resize(size, {0, kEmpty, 0, 0});
+        trie_->value_.resize(size, kNotFound);
+        trie_->length_.resize(size, 0);
+        next_.resize(size);
+        prev_.resize(size);
+        for (size_t slot = begin; slot < size; ++slot) {
+            AddFree(static_cast<uint32_t>(slot));
+        }
+        if (size - closed_ > kOpenBlocks * kBlock) {
+            for (size_t slot = closed_; slot < closed_ + kBlock; ++slot) {
+                if (state_[slot] == kFree) {
+                    RemoveFree(static_cast<uint32_t>(slot));
+                    state_[slot] = kClosed;
+                }
+            }
+            closed_ += kBlock;
+        }
+    }
+
+    // appends a free slot to the candidate list
+    void AddFree(uint32_t slot) {
+        if (head_ == kEmpty) {
+            head_ = next_[slot] = prev_[slot] = slot;
+            return;
+        }
+        uint32_t tail = prev_[head_];
+        next_[tail] = slot;
+        prev_[slot] = tail;
+        next_[slot] = head_;
+        prev_[head_] = slot;
+    }
+
+    void RemoveFree(uint32_t slot) {
+        if (next_[slot] == slot) {
+            head_ = kEmpty;
+            return;
+        }
+        next_[prev_[slot]] = next_[slot];
+        prev_[next_[slot]] = prev_[slot];
+        if (head_ == slot) head_ = next_[slot];
+    }
+
+    void Take(uint32_t slot) {
+        while (slot >= state_.size()) AddBlock();
+        if (state_[slot] == kFree) RemoveFree(slot);
+        state_[slot] = kUsed;
+    }
+
+    bool Fits(size_t base, const std::vector<Edge> &edges) const {
+        for (const Edge &edge : edges) {
+            size_t slot = base + edge.byte;
+            if (slot < state_.size() && state_[slot] != kFree) return false;
+        }
+        return true;
+    }
+
+    uint32_t FindBase(const std::vector<Edge> &edges) {
+        uint8_t first = edges.front().byte;
+        if (head_ != kEmpty) {
+            uint32_t slot = head_;
+            do {
+                if (slot >= first && Fits(slot - first, edges)) {
+                    return slot - first;
+                }
+                slot = next_[slot];
+            } while (slot != head_);
+        }
+        // nothing open fits, start past the end
+        return static_cast<uint32_t>(std::max<size_t>(state_.size(), first) - first);
+    }
+
+    // failure and report links of a new child
+    void Link(uint32_t parent, uint32_t child, uint8_t byte) {
+        std::vector<Node> &nodes = trie_->nodes_;
+        uint32_t fail = 0;
+        if (parent != 0) {
+            uint32_t state = nodes[parent].fail;
+            while (true) {
+                uint32_t next = trie_->Child(state, byte);
+                if (next != kEmpty) {
+                    fail = next;
+                    break;
+                }
+                if (state == 0) break;
+                state = nodes[state].fail;
+            }
+        }
+        nodes[child].fail = fail;
+        nodes[child].report = trie_->value_[child] != kNotFound ? child : nodes[fail].report;
+    }
+
+    DoubleArrayTrie *trie_;
+    const std::vector<std::pair<std::string, uint32_t>> &entries_;
+    std::vector<uint8_t> state_;
+    // circular list of the open free slots
+    std::vector<uint32_t> next_;
+    std::vector<uint32_t> prev_;
+    uint32_t head_ = kEmpty;
+    // slots below are in closed blocks
+    size_t closed_ = 0;
+};
+
+absl::StatusOr<std::unique_ptr<DoubleArrayTrie>> DoubleArrayTrie::Build(
+    std::vector<std::pair<std::string, uint32_t>> entries) {
+    for (const auto &entry : entries) {
+        if (entry.first.empty()) {
+            return absl::InvalidArgumentError("empty key");
+        }
+        if (entry.second == kNotFound) {
+            return absl::InvalidArgumentError("value of key " + entry.first + " is kNotFound");
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+    // keep the last of each repeated key
+    size_t keys = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first) continue;
+        if (keys != i) entries[keys] = std::move(entries[i]);
+        ++keys;
+    }
+    entries.resize(keys);
+    // a state per key byte at most, slots must stay below kEmpty
+    uint64_t bytes = 0;
+    for (const auto &entry : entries) bytes += entry.first.size();
+    if (bytes >= kEmpty / 2) {
+        return absl::InvalidArgumentError("keys too large for a double-array trie");
+    }
+
+    std::unique_ptr<DoubleArrayTrie> trie(new DoubleArrayTrie());
+    Builder(trie.get(), entries).Run();
+    trie->keys_ = keys;
+    return trie;
+}
+
+absl::StatusOr<std::unique_ptr<DoubleArrayTrie>> DoubleArrayTrie::BuildFromFile(
+    absl::string_view path, const TrieFileOptions &options) {
+    std::vector<std::pair<std::string, uint32_t>> entries;
+    const std::string &delimiter = options.delimiter;
+    absl::Status status = io::LoadUtf8File(
+        path,
+        [&](const std::string &line, uint32_t index) {
+            size_t split = delimiter.empty() ? std::string::npos : line.find(delimiter);
+            if (split == 0) return;
+            entries.emplace_back(line.substr(0, split), index);
+        },
+        options.exclude);
+    if (!status.ok()) {
+        return status;
+    }
+    return Build(std::move(entries));
+}
+
+void DoubleArrayTrie::Serialize(std::string *out) const {
+    out->clear();
+    out->reserve(kHeaderSize + nodes_.size() * kSlotFields * 4);
+    compress::PutFixed64(out, kMagic);
+    compress::PutFixed64(out, nodes_.size());
+    compress::PutFixed64(out, keys_);
+    for (const Node &node : nodes_) {
+        compress::PutFixed32(out, node.base);
+        compress::PutFixed32(out, node.check);
+        compress::PutFixed32(out, node.fail);
+        compress::PutFixed32(out, node.report);
+    }
+    for (uint32_t value : value_) compress::PutFixed32(out, value);
+    for (uint32_t length : length_) compress::PutFixed32(out, length);
+}
+
+absl::StatusOr<std::unique_ptr<DoubleArrayTrie>> DoubleArrayTrie::Deserialize(
+    absl::string_view data) {
+    auto corrupted = []() { return absl::DataLossError("not a double-array trie or corrupted"); };
+    if (data.size() < kHeaderSize || compress::GetFixed64(data.data()) != kMagic) {
+        return corrupted();
+    }
+    uint64_t slots = compress::GetFixed64(data.data() + 8);
+    uint64_t keys = compress::GetFixed64(data.data() + 16);
+    size_t body = data.size() - kHeaderSize;
+    if (slots == 0 || slots >= kEmpty - 1 || body % (kSlotFields * 4) != 0 ||
+        body / (kSlotFields * 4) != slots) {
+        return corrupted();
+    }
+    std::unique_ptr<DoubleArrayTrie> trie(new DoubleArrayTrie());
+    const char *p = data.data() + kHeaderSize;
+    trie->nodes_.resize(slots);
+    for (Node &node : trie->nodes_) {
+        node = {compress::GetFixed32(p), compress::GetFixed32(p + 4),
+                compress::GetFixed32(p + 8), compress::GetFixed32(p + 12)};
+        p += 16;
+    }
+    for (auto *field : {&trie->value_, &trie->length_}) {
+        field->resize(slots);
+        for (uint32_t &value : *field) {
+            value = compress::GetFixed32(p);
+            p += 4;
+        }
+    }
+
+    // depth of every state from the parent links, which must lead to the root without a
+    // cycle. Scan follows failure and report links, they must not lead deeper, so every
+    // walk along them ends
+    const std::vector<Node> &nodes = trie->nodes_;
+    const uint32_t kUnknown = kEmpty, kVisiting = kEmpty - 1;
+    if (nodes[0].check != kEmpty) return corrupted();
+    std::vector<uint32_t> depth(slots, kUnknown);
+    depth[0] = 0;
+    std::vector<uint32_t> path;
+    for (uint32_t slot = 1; slot < slots; ++slot) {
+        if (nodes[slot].check == kEmpty) continue;
+        uint32_t state = slot;
+        while (depth[state] == kUnknown) {
+            uint32_t parent = nodes[state].check;
+            if (parent >= slots || depth[parent] == kVisiting ||
+                (parent != 0 && nodes[parent].check == kEmpty)) {
+                return corrupted();
+            }
+            depth[state] = kVisiting;
+            path.push_back(state);
+            state = parent;
+        }
+        uint32_t level = depth[state];
+        while (!path.empty()) {
+            depth[path.back()] = ++level;
+            path.pop_back();
+        }
+    }
+    uint64_t found = 0;
+    for (uint32_t slot = 0; slot < slots; ++slot) {
+        if (depth[slot] == kUnknown) continue;
+        uint32_t fail = nodes[slot].fail, report = nodes[slot].report;
+        if (fail >= slots || depth[fail] == kUnknown || report >= slots ||
+            depth[report] == kUnknown) {
+            return corrupted();
+        }
+        if (slot != 0 && depth[fail] >= depth[slot]) return corrupted();
+        if (report != 0 && (trie->value_[report] == kNotFound ||
+                            (report != slot && depth[report] >= depth[slot]))) {
+            return corrupted();
+        }
+        if (trie->value_[slot] != kNotFound) {
+            if (slot == 0 || trie->length_[slot] != depth[slot]) return corrupted();
+            ++found;
+        }
+    }
+    if (found != keys) return corrupted();
+    trie->keys_ = keys;
+    return trie;
+}
+
+absl::StatusOr<std::unique_ptr<DoubleArrayTrie>> DoubleArrayTrie::Load(absl::string_view path) {
+    std::string name(path.data(), path.size());
+    std::ifstream input(name, std::ios::binary);
+    if (!input) {
+        return absl::NotFoundError("can not open " + name);
+    }
+    std::string data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    if (input.bad()) {
+        return absl::DataLossError("can not read " + name);
+    }
+    return Deserialize(data);
+}
+
+absl::Status DoubleArrayTrie::Save(absl::string_view path) const {
+    auto writer = io::Writer::Open(path);
+    if (!writer.ok()) {
+        return writer.status();
+    }
+    std::string data;
+    Serialize(&data);
+    absl::Status status = (*writer)->Append(data);
+    if (!status.ok()) {
+        return status;
+    }
+    return (*writer)->Close();
+}
+
+uint32_t DoubleArrayTrie::Find(absl::string_view key) const {
+    uint32_t state = 0;
+    for (char c : key) {
+        state = Child(state, static_cast<uint8_t>(c));
+        if (state == kEmpty) return kNotFound;
+    }
+    return value_[state];
+}
+
+size_t DoubleArrayTrie::LongestPrefix(absl::string_view text, uint32_t *value) const {
+    size_t length = 0;
+    uint32_t state = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        state = Child(state, static_cast<uint8_t>(text[i]));
+        if (state == kEmpty) break;
+        if (value_[state] != kNotFound) {
+            length = i + 1;
+            if (value != nullptr) *value = value_[state];
+        }
+    }
+    return length;
+}
+
+void DoubleArrayTrie::CommonPrefixes(absl::string_view text,
+                                     const std::function<void(size_t, uint32_t)> &fn) const {
+    uint32_t state = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        state = Child(state, static_cast<uint8_t>(text[i]));
+        if (state == kEmpty) return;
+        if (value_[state] != kNotFound) {
+            fn(i + 1, value_[state]);
+        }
+    }
+}
+
+void DoubleArrayTrie::Scan(absl::string_view text,
+                           const std::function<void(const TrieMatch &)> &fn) const {
+    uint32_t state = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint8_t byte = static_cast<uint8_t>(text[i]);
+        uint32_t next;
+        while ((next = Child(state, byte)) == kEmpty && state != 0) {
+            state = nodes_[state].fail;
+        }
+        state = next == kEmpty ? 0 : next;
+        for (uint32_t match = nodes_[state].report; match != 0;
+             match = nodes_[nodes_[match].fail].report) {
+            fn({i + 1 - length_[match], length_[match], value_[match]});
+        }
+    }
+}
+
+std::vector<TrieMatch> DoubleArrayTrie::ScanLongest(absl::string_view text) const {
+    std::vector<TrieMatch> matches;
+    size_t i = 0;
+    while (i < text.size()) {
+        uint32_t value = kNotFound;
+        size_t length = LongestPrefix(text.substr(i), &value);
+        if (length > 0) {
+            matches.push_back({i, length, value});
+            i += length;
+            continue;
+        }
+        // on to the next code point
+        ++i;
+        while (i < text.size() && (static_cast<uint8_t>(text[i]) & 0xC0) == 0x80) ++i;
+    }
+    return matches;
+}
+
+size_t DoubleArrayTrie::BytesUsed() const {
+    return nodes_.capacity() * sizeof(Node) +
+           (value_.capacity() + length_.capacity()) * sizeof(uint32_t);
+}
+
+}  // namespace string
+}  // namespace alpheratz
@@ -0,0 +1,49 @@
+#include <alpheratz/string/string_arena.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace alpheratz {
+namespace string {
+
+StringArena::StringArena(size_t block_size) : block_size_(std::max<size_t>(block_size, 64)) {}
+
+char *StringArena::Allocate(size_t size) {
+    used_ += size;
+    if (size > left_) {
+        if (size > block_size_ / 4) {
+            // a large value gets a block of its own and the current block stays in use
+            blocks_.emplace_back(new char[size]);
+            reserved_ += size;
+            return blocks_.back().get();
+        }
+        blocks_.emplace_back(new char[block_size_]);
+        reserved_ += block_size_;
+        next_ = blocks_.back().get();
+        left_ = block_size_;
+    }
+    char *out = next_;
+    next_ += size;
+    left_ -= size;
+    return out;
+}
+
+absl::string_view StringArena::Copy(absl::string_view value) {
+    if (value.empty()) {
+        return absl::string_view();
+    }
+    char *out = Allocate(value.size());
+    std::memcpy(out, value.data(), value.size());
+    return absl::string_view(out, value.size());
+}
+
+void StringArena::Clear() {
+    blocks_.clear();
+    next_ = nullptr;
+    left_ = 0;
+    used_ = 0;
+    reserved_ = 0;
+}
+
+}  // namespace string
+}  // namespace alpheratz
@@ -0,0 +1,147 @@
+#include <alpheratz/hash/murmurhash3.h>
+#include <alpheratz/string/string_interner.h>
+
+#include <cstring>
+
+namespace alpheratz {
+namespace string {
+
+StringInterner &StringInterner::Get() {
+    static StringInterner instance;
+    return instance;
+}
+
+StringInterner::Table::Table(size_t capacity)
+    : mask(capacity - 1), slots(new std::atomic<uint64_t>[capacity]) {
+    for (size_t i = 0; i < capacity; ++i) {
+        slots[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+StringInterner::StringInterner(size_t expected) {
+    // at most half full
+    size_t capacity = 16;
+    while (capacity < expected * 2) capacity <<= 1;
+    tables_.emplace_back(new Table(capacity));
+    table_.store(tables_.back().get(), std::memory_order_release);
+}
+
+StringInterner::~StringInterner() {
+    for (auto &chunk : chunks_) {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t StringInterner::Hash(absl::string_view value) {
+    return static_cast<uint64_t>(
+        hash::MurmurHash64(value.data(), static_cast<int>(value.size()), 0));
+}
+
+StringInterner::Entry *StringInterner::At(uint32_t id) const {
+    uint64_t index = static_cast<uint64_t>(id) + (uint64_t(1) << kFirstChunkBits);
+    int top = 63 - __builtin_clzll(index);
+    Entry *chunk = chunks_[top - kFirstChunkBits].load(std::memory_order_acquire);
+    return chunk + (index - (uint64_t(1) << top));
+}
+
+uint32_t StringInterner::Probe(const Table &table, absl::string_view value,
+                               uint64_t hash) const {
+    uint64_t tag = hash & 0xFFFFFFFF00000000ull;
+    for (size_t i = hash & table.mask;; i = (i + 1) & table.mask) {
+        uint64_t slot = table.slots[i].load(std::memory_order_acquire);
+        if (slot == 0) {
+            return kNotFound;
+        }
+        if ((slot & 0xFFFFFFFF00000000ull) == tag) {
+            uint32_t id = static_cast<uint32_t>(slot) - 1;
+            const Entry *entry = At(id);
+            if (entry->size == value.size() &&
+                (value.empty() || std::memcmp(entry->data, value.data(), value.size()) == 0)) {
+                return id;
+            }
+        }
+    }
+}
+
+uint32_t StringInterner::Find(absl::string_view value) const {
+    return Probe(*table_.load(std::memory_order_acquire), value, Hash(value));
+}
+
+absl::string_view StringInterner::Name(uint32_t id) const {
+    if (id >= Size()) {
+        return absl::string_view();
+    }
+    const Entry *entry = At(id);
+    return absl::string_view(entry->data, entry->size);
+}
+
+uint32_t StringInterner::Intern(absl::string_view value) {
+    uint64_t hash = Hash(value);
+    uint32_t id = Probe(*table_.load(std::memory_order_acquire), value, hash);
+    if (id != kNotFound) {
+        return id;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    // another writer may have added it, or grown the table we probed
+    Table *table = table_.load(std::memory_order_relaxed);
+    id = Probe(*table, value, hash);
+    if (id != kNotFound) {
+        return id;
+    }
+    size_t size = size_.load(std::memory_order_relaxed);
+    if (size >= kNotFound - 1) {
+        // ids are exhausted
+        return kNotFound;
+    }
+    id = static_cast<uint32_t>(size);
+    uint64_t index = static_cast<uint64_t>(id) + (uint64_t(1) << kFirstChunkBits);
+    int top = 63 - __builtin_clzll(index);
+    if (index == (uint64_t(1) << top)) {
+        // first id of a chunk
+        chunks_[top - kFirstChunkBits].store(new Entry[uint64_t(1) << top],
+                                             std::memory_order_release);
+    }
+    absl::string_view copy = arena_.Copy(value);
+    *At(id) = Entry{copy.data(), static_cast<uint32_t>(copy.size())};
+    // readers that see the slot or the size also see the entry
+    size_.store(size + 1, std::memory_order_release);
+    if ((size + 1) * 2 > table->mask + 1) {
+        Grow();
+        table = table_.load(std::memory_order_relaxed);
+    }
+    uint64_t slot = (hash & 0xFFFFFFFF00000000ull) | (static_cast<uint64_t>(id) + 1);
+    size_t i = hash & table->mask;
+    while (table->slots[i].load(std::memory_order_relaxed) != 0) {
+        i = (i + 1) & table->mask;
+    }
+    table->slots[i].store(slot, std::memory_order_release);
+    return id;
+}
+
+// mutex_ held
+void StringInterner::Grow() {
+    Table *old = table_.load(std::memory_order_relaxed);
+    std::unique_ptr<Table> bigger(new Table((old->mask + 1) * 2));
+    for (size_t i = 0; i <= old->mask; ++i) {
+        uint64_t slot = old->slots[i].load(std::memory_order_relaxed);
+        if (slot == 0) continue;
+        const Entry *entry = At(static_cast<uint32_t>(slot) - 1);
+        uint64_t hash = Hash(absl::string_view(entry->data, entry->size));
+        size_t j = hash & bigger->mask;
+        while (bigger->slots[j].load(std::memory_order_relaxed) != 0) {
+            j = (j + 1) & bigger->mask;
+        }
+        bigger->slots[j].store(slot, std::memory_order_relaxed);
+    }
+    // the old table stays alive for readers that already loaded it
+    table_.store(bigger.get(), std::memory_order_release);
+    tables_.push_back(std::move(bigger));
+}
+
+size_t StringInterner::BytesUsed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return arena_.BytesUsed();
+}
+
+}  // namespace string
+}  // namespace alpheratz
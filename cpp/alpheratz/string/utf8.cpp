@@ -0,0 +1,424 @@
+#include <alpheratz/string/utf8.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#define ALPHERATZ_UTF8_X86 1
+#endif
+
+namespace alpheratz {
+namespace string {
+
+namespace {
+
+inline bool IsContinuation(unsigned char c) { return (c & 0xc0) == 0x80; }
+
+// offset of the first ill-formed sequence at or after i, which must start a sequence
+size_t ScalarFindInvalid(const unsigned char *s, size_t i, size_t n) {
+    while (i < n) {
+        if (n - i >= 8) {
+            uint64_t word;
+            std::memcpy(&word, s + i, sizeof(word));
+            if ((word & 0x8080808080808080ULL) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+        unsigned char c = s[i];
+        if (c < 0x80) {
+            ++i;
+            continue;
+        }
+        // table 3-7 of the unicode standard, the second byte range depends on the lead
+        size_t size;
+        unsigned char low = 0x80;
+        unsigned char high = 0xbf;
+        if (c >= 0xc2 && c <= 0xdf) {
+            size = 2;
+        } else if (c >= 0xe0 && c <= 0xef) {
+            size = 3;
+            if (c == 0xe0) low = 0xa0;
+            if (c == 0xed) high = 0x9f;
+        } else if (c >= 0xf0 && c <= 0xf4) {
+            size = 4;
+            if (c == 0xf0) low = 0x90;
+            if (c == 0xf4) high = 0x8f;
+        } else {
+            return i;
+        }
+        if (n - i < size || s[i + 1] < low || s[i + 1] > high) {
+            return i;
+        }
+        for (size_t k = 2; k < size; ++k) {
+            if (!IsContinuation(s[i + k])) {
+                return i;
+            }
+        }
+        i += size;
+    }
+    return n;
+}
+
+// start of the sequence pos falls into, or pos, for a prefix known to be well formed
+size_t SequenceStart(const unsigned char *s, size_t pos) {
+    for (size_t k = 1; k <= 3 && k <= pos; ++k) {
+        if (!IsContinuation(s[pos - k])) {
+            return pos - k;
+        }
+    }
+    return pos;
+}
+
+// code point of the valid sequence at s[*i], *i moves past it
+inline uint32_t DecodeValid(const unsigned char *s, size_t *i) {
+    unsigned char c = s[*i];
+    if (c < 0x80) {
+        *i += 1;
+        return c;
+    }
+    if (c < 0xe0) {
+        uint32_t code_point = (c & 0x1fu) << 6 | (s[*i + 1] & 0x3fu);
+        *i += 2;
+        return code_point;
+    }
+    if (c < 0xf0) {
+        uint32_t code_point = (c & 0x0fu) << 12 | (s[*i + 1] & 0x3fu) << 6 | (s[*i + 2] & 0x3fu);
+        *i += 3;
+        return code_point;
+    }
+    uint32_t code_point = (c & 0x07u) << 18 | (s[*i + 1] & 0x3fu) << 12 |
+                          (s[*i + 2] & 0x3fu) << 6 | (s[*i + 3] & 0x3fu);
+    *i += 4;
+    return code_point;
+}
+
+inline char *EncodeUtf8(uint32_t code_point, char *dst) {
+    if (code_point < 0x80) {
+        *dst++ = static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        *dst++ = static_cast<char>(0xc0 | code_point >> 6);
+        *dst++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    } else if (code_point < 0x10000) {
+        *dst++ = static_cast<char>(0xe0 | code_point >> 12);
+        *dst++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3f));
+        *dst++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    } else {
+        *dst++ = static_cast<char>(0xf0 | code_point >> 18);
+        *dst++ = static_cast<char>(0x80 | (code_point >> 12 & 0x3f));
+        *dst++ = static_cast<char>(0x80 | (code_point >> 6 & 0x3f));
+        *dst++ = static_cast<char>(0x80 | (code_point & 0x3f));
+    }
+    return dst;
+}
+
+absl::Status InvalidAt(const char *what, size_t offset) {
+    return absl::InvalidArgumentError(std::string("invalid ") + what + " at offset " +
+                                      std::to_string(offset));
+}
+
+#ifdef ALPHERATZ_UTF8_X86
+// lookup validation of Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction
+// Per Byte". each table maps a nibble to the errors it allows, a byte pair is bad when
+// the high and low nibble of the first and the high nibble of the second all agree
+constexpr uint8_t kTooShort = 1 << 0;
+constexpr uint8_t kTooLong = 1 << 1;
+constexpr uint8_t kOverlong3 = 1 << 2;
+constexpr uint8_t kTooLarge = 1 << 3;
+constexpr uint8_t kSurrogate = 1 << 4;
+constexpr uint8_t kOverlong2 = 1 << 5;
+constexpr uint8_t kTooLarge1000 = 1 << 6;
+constexpr uint8_t kOverlong4 = 1 << 6;
+constexpr uint8_t kTwoConts = 1 << 7;
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+alignas(16) constexpr uint8_t kByte1High[16] = {
+    kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    kTooShort | kOverlong2,
+    kTooShort,
+    kTooShort | kOverlong3 | kSurrogate,
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+alignas(16) constexpr uint8_t kByte1Low[16] = {
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    kCarry | kOverlong2,
+    kCarry,
+    kCarry,
+    kCarry | kTooLarge,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+};
+alignas(16) constexpr uint8_t kByte2High[16] = {
+    kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooShort, kTooShort, kTooShort, kTooShort,
+};
+// a lead byte in the last 1, 2 or 3 positions still waits for continuation bytes
+alignas(16) constexpr uint8_t kIncompleteMax[16] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf,
+};
+
+__attribute__((target("ssse3"), always_inline)) inline __m128i Load(const uint8_t *table) {
+    return _mm_load_si128(reinterpret_cast<const __m128i *>(table));
+}
+
+__attribute__((target("ssse3"), always_inline)) inline __m128i HighNibble(__m128i v) {
+    return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+}
+
+// error bits of the 16 bytes in input, prev holds the 16 bytes before them
+__attribute__((target("ssse3"), always_inline)) inline __m128i CheckBlock(__m128i input,
+                                                                          __m128i prev) {
+    __m128i prev1 = _mm_alignr_epi8(input, prev, 15);
+    __m128i special = _mm_and_si128(
+        _mm_and_si128(_mm_shuffle_epi8(Load(kByte1High), HighNibble(prev1)),
+                      _mm_shuffle_epi8(Load(kByte1Low), _mm_and_si128(prev1, _mm_set1_epi8(0x0f)))),
+        _mm_shuffle_epi8(Load(kByte2High), HighNibble(input)));
+    // the third and fourth byte of a sequence must be continuations, which special
+    // flags as kTwoConts
+    __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 14), _mm_set1_epi8(0xe0 - 0x80));
+    __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev, 13), _mm_set1_epi8(0xf0 - 0x80));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(-0x80));
+    return _mm_xor_si128(must23, special);
+}
+
+// false with *chunk at the first 64 byte chunk holding an error, which is n for a
+// sequence cut at the end
+__attribute__((target("ssse3"))) bool ValidateSsse3(const unsigned char *s, size_t n,
+                                                    size_t *chunk) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i prev = zero;
+    __m128i incomplete = zero;
+    alignas(16) unsigned char tail[64];
+    for (size_t i = 0; i <= n; i += 64) {
+        const unsigned char *p = s + i;
+        if (n - i < 64) {
+            // zero padding reads as ascii, which also settles a sequence cut at the end
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, p, n - i);
+            p = tail;
+        }
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 48));
+        __m128i error;
+        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))) == 0) {
+            error = incomplete;
+            incomplete = zero;
+        } else {
+            error = _mm_or_si128(_mm_or_si128(CheckBlock(a, prev), CheckBlock(b, a)),
+                                 _mm_or_si128(CheckBlock(c, b), CheckBlock(d, c)));
+            incomplete = _mm_subs_epu8(d, Load(kIncompleteMax));
+        }
+        prev = d;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(error, zero)) != 0xffff) {
+            *chunk = i;
+            return false;
+        }
+        if (n - i < 64) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool HasSsse3() {
+    static const bool has = __builtin_cpu_supports("ssse3");
+    return has;
+}
+#endif
+
+}  // namespace
+
+size_t FindInvalidUtf8(absl::string_view in) {
+    const auto *s = reinterpret_cast<const unsigned char *>(in.data());
+    const size_t n = in.size();
+    size_t start = 0;
+#ifdef ALPHERATZ_UTF8_X86
+    if (HasSsse3()) {
+        size_t chunk;
+        if (ValidateSsse3(s, n, &chunk)) {
+            return n;
+        }
+        // the error may sit in a sequence that began up to 3 bytes before the chunk
+        start = SequenceStart(s, chunk);
+    }
+#endif
+    return ScalarFindInvalid(s, start, n);
+}
+
+size_t CountCodePoints(absl::string_view in) {
+    const auto *s = reinterpret_cast<const unsigned char *>(in.data());
+    const size_t n = in.size();
+    size_t continuations = 0;
+    size_t i = 0;
+#ifdef ALPHERATZ_UTF8_X86
+    const __m128i zero = _mm_setzero_si128();
+    // continuation bytes are the signed values below -64
+    const __m128i bound = _mm_set1_epi8(-64);
+    while (n - i >= 16) {
+        // byte counters hold up to 255 rounds before they are summed
+        size_t rounds = std::min<size_t>((n - i) / 16, 255);
+        __m128i counts = zero;
+        for (size_t r = 0; r < rounds; ++r, i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(bound, v));
+        }
+        __m128i sums = _mm_sad_epu8(counts, zero);
+        continuations += static_cast<size_t>(_mm_cvtsi128_si32(sums)) +
+                         static_cast<size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+    }
+#endif
+    for (; i < n; ++i) {
+        continuations += IsContinuation(s[i]);
+    }
+    return n - continuations;
+}
+
+absl::Status Utf8ToUtf16(absl::string_view in, std::u16string *out) {
+    const auto *s = reinterpret_cast<const unsigned char *>(in.data());
+    const size_t n = in.size();
+    size_t invalid = FindInvalidUtf8(in);
+    if (invalid != n) {
+        out->clear();
+        return InvalidAt("utf-8", invalid);
+    }
+    // never more units than bytes, so a block store past the last unit stays in bounds
+    out->resize(n);
+    char16_t *dst = &(*out)[0];
+    size_t i = 0;
+    while (i < n) {
+#ifdef ALPHERATZ_UTF8_X86
+        if (n - i >= 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                             _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 8),
+                             _mm_unpackhi_epi8(v, _mm_setzero_si128()));
+            int mask = _mm_movemask_epi8(v);
+            size_t ascii = mask == 0 ? 16 : static_cast<size_t>(__builtin_ctz(mask));
+            i += ascii;
+            dst += ascii;
+            if (ascii == 16) continue;
+        }
+#endif
+        uint32_t code_point = DecodeValid(s, &i);
+        if (code_point < 0x10000) {
+            *dst++ = static_cast<char16_t>(code_point);
+        } else {
+            code_point -= 0x10000;
+            *dst++ = static_cast<char16_t>(0xd800 | code_point >> 10);
+            *dst++ = static_cast<char16_t>(0xdc00 | (code_point & 0x3ff));
+        }
+    }
+    out->resize(dst - out->data());
+    return absl::OkStatus();
+}
+
+absl::Status Utf8ToUtf32(absl::string_view in, std::u32string *out) {
+    const auto *s = reinterpret_cast<const unsigned char *>(in.data());
+    const size_t n = in.size();
+    size_t invalid = FindInvalidUtf8(in);
+    if (invalid != n) {
+        out->clear();
+        return InvalidAt("utf-8", invalid);
+    }
+    out->resize(n);
+    char32_t *dst = &(*out)[0];
+    size_t i = 0;
+    while (i < n) {
+#ifdef ALPHERATZ_UTF8_X86
+        if (n - i >= 16) {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            __m128i low = _mm_unpacklo_epi8(v, zero);
+            __m128i high = _mm_unpackhi_epi8(v, zero);
+            auto *block = reinterpret_cast<__m128i *>(dst);
+            _mm_storeu_si128(block, _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(block + 1, _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(block + 2, _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(block + 3, _mm_unpackhi_epi16(high, zero));
+            int mask = _mm_movemask_epi8(v);
+            size_t ascii = mask == 0 ? 16 : static_cast<size_t>(__builtin_ctz(mask));
+            i += ascii;
+            dst += ascii;
+            if (ascii == 16) continue;
+        }
+#endif
+        *dst++ = DecodeValid(s, &i);
+    }
+    out->resize(dst - out->data());
+    return absl::OkStatus();
+}
+
+absl::Status Utf16ToUtf8(std::u16string_view in, std::string *out) {
+    const size_t n = in.size();
+    // 3 bytes per unit at most, a surrogate pair takes 4 for 2
+    out->resize(n * 3);
+    char *dst = &(*out)[0];
+    size_t i = 0;
+    while (i < n) {
+#ifdef ALPHERATZ_UTF8_X86
+        if (n - i >= 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in.data() + i));
+            __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(v, _mm_set1_epi16(-0x80)),
+                                            _mm_setzero_si128());
+            if (_mm_movemask_epi8(ascii) == 0xffff) {
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(v, v));
+                i += 8;
+                dst += 8;
+                continue;
+            }
+        }
+#endif
+        uint32_t code_point = in[i];
+        if (code_point >= 0xd800 && code_point <= 0xdfff) {
+            if (code_point > 0xdbff || i + 1 == n || in[i + 1] < 0xdc00 || in[i + 1] > 0xdfff) {
+                out->clear();
+                return InvalidAt("utf-16", i);
+            }
+            code_point = 0x10000 + ((code_point - 0xd800) << 10 | (in[i + 1] - 0xdc00u));
+            ++i;
+        }
+        ++i;
+        dst = EncodeUtf8(code_point, dst);
+    }
+    out->resize(dst - out->data());
+    return absl::OkStatus();
+}
+
+absl::Status Utf32ToUtf8(std::u32string_view in, std::string *out) {
+    const size_t n = in.size();
+    out->resize(n * 4);
+    char *dst = &(*out)[0];
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t code_point = in[i];
+        if (code_point > 0x10ffff || (code_point >= 0xd800 && code_point <= 0xdfff)) {
+            out->clear();
+            return InvalidAt("utf-32", i);
+        }
+        dst = EncodeUtf8(code_point, dst);
+    }
+    out->resize(dst - out->data());
+    return absl::OkStatus();
+}
+
+}  // namespace string
+}  // namespace alpheratz
@@ -0,0 +1,269 @@
+#include <alpheratz/time/batch_parse.h>
+#include <alpheratz/time/datetime_kernel.h>
+
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#define ALPHERATZ_BATCH_PARSE_X86 1
+#endif
+
+namespace alpheratz {
+namespace time {
+
+namespace {
+
+// per layout vector tables cover two 16 byte registers
+constexpr size_t kRowVector = 32;
+
+bool ParseFraction(absl::string_view fraction, int *millis) {
+    if (fraction.size() < 2 || fraction.size() > 10 || fraction[0] != '.') {
+        return false;
+    }
+    int value = 0;
+    for (size_t i = 1; i < fraction.size(); ++i) {
+        uint32_t digit = internal::DigitAt(fraction.data() + i);
+        if (digit > 9) {
+            return false;
+        }
+        if (i <= 3) value = value * 10 + static_cast<int>(digit);
+    }
+    for (size_t i = fraction.size(); i <= 3; ++i) {
+        value *= 10;
+    }
+    *millis = value;
+    return true;
+}
+
+struct ScalarKernel {
+    template <DateTimeLayout layout>
+    static bool Parse(const char *row, internal::CivilFields *f) {
+        return internal::ParseLayout<layout>(row, internal::LayoutTraits<layout>::kSize, f);
+    }
+};
+
+#ifdef ALPHERATZ_BATCH_PARSE_X86
+// per layout vectors: xor with expect turns digits into 0..9 and matching literals
+// into 0, a byte passes when it is not above limit. digits gathered by the shuffles
+// are YYYYMMDDHHMMSS, absent fields stay 0
+struct alignas(16) VectorLayout {
+    uint8_t expect[kRowVector];
+    uint8_t limit[kRowVector];
+    uint8_t shuffle_lo[16];
+    uint8_t shuffle_hi[16];
+};
+
+template <DateTimeLayout layout>
+constexpr VectorLayout MakeVectorLayout() {
+    using Traits = internal::LayoutTraits<layout>;
+    VectorLayout v{};
+    for (size_t i = 0; i < kRowVector; ++i) {
+        if (i >= Traits::kSize) {
+            v.expect[i] = 0;
+            v.limit[i] = 0xff;
+        } else if (Traits::kPattern[i] == 'd') {
+            v.expect[i] = '0';
+            v.limit[i] = 9;
+        } else {
+            v.expect[i] = static_cast<uint8_t>(Traits::kPattern[i]);
+            v.limit[i] = 0;
+        }
+    }
+    for (size_t i = 0; i < 16; ++i) {
+        v.shuffle_lo[i] = 0x80;
+        v.shuffle_hi[i] = 0x80;
+    }
+    const int offsets[] = {0, 2, internal::MonthOffset<layout>(), internal::DayOffset<layout>(),
+                           Traits::kHour, Traits::kMinute, Traits::kSecond};
+    for (size_t field = 0; field < 7; ++field) {
+        if (offsets[field] < 0) continue;
+        for (size_t k = 0; k < 2; ++k) {
+            size_t pos = static_cast<size_t>(offsets[field]) + k;
+            if (pos < 16) {
+                v.shuffle_lo[field * 2 + k] = static_cast<uint8_t>(pos);
+            } else {
+                v.shuffle_hi[field * 2 + k] = static_cast<uint8_t>(pos - 16);
+            }
+        }
+    }
+    return v;
+}
+
+template <DateTimeLayout layout>
+struct VectorTables {
+    static constexpr VectorLayout kLayout = MakeVectorLayout<layout>();
+};
+
+inline __m128i LoadVector(const uint8_t *p) {
+    return _mm_load_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+// row bytes 0..15 in *lo and 16.. in *hi, zero past the layout. built from overlapping
+// loads that stay inside the row: no over-read, and no copy whose narrow stores would
+// stall the wide loads reading them back
+template <DateTimeLayout layout>
+inline void LoadRow(const char *row, __m128i *lo, __m128i *hi) {
+    constexpr int kSize = static_cast<int>(internal::LayoutTraits<layout>::kSize);
+    if constexpr (kSize >= 16) {
+        *lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + kSize - 16));
+        *hi = _mm_srli_si128(tail, 32 - kSize);
+    } else {
+        __m128i head = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row));
+        __m128i tail = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + kSize - 8));
+        *lo = _mm_or_si128(head, _mm_slli_si128(tail, kSize - 8));
+        *hi = _mm_setzero_si128();
+    }
+}
+
+// digits as 0..9 in *lo / *hi, false on any mismatch
+template <DateTimeLayout layout>
+inline bool Validate(const char *row, __m128i *lo, __m128i *hi) {
+    const VectorLayout &v = VectorTables<layout>::kLayout;
+    LoadRow<layout>(row, lo, hi);
+    __m128i limit = LoadVector(v.limit);
+    *lo = _mm_xor_si128(*lo, LoadVector(v.expect));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(*lo, limit), limit));
+    if constexpr (internal::LayoutTraits<layout>::kSize > 16) {
+        limit = LoadVector(v.limit + 16);
+        *hi = _mm_xor_si128(*hi, LoadVector(v.expect + 16));
+        mask &= _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(*hi, limit), limit));
+    }
+    return mask == 0xffff;
+}
+
+struct Sse2Kernel {
+    template <DateTimeLayout layout>
+    static bool Parse(const char *row, internal::CivilFields *f) {
+        using Traits = internal::LayoutTraits<layout>;
+        __m128i lo, hi;
+        if (!Validate<layout>(row, &lo, &hi)) {
+            return false;
+        }
+        f->year = internal::Read4(row);
+        f->month = internal::Read2(row + internal::MonthOffset<layout>());
+        f->day = internal::Read2(row + internal::DayOffset<layout>());
+        f->hour = Traits::kHour < 0 ? 0 : internal::Read2(row + Traits::kHour);
+        f->minute = Traits::kMinute < 0 ? 0 : internal::Read2(row + Traits::kMinute);
+        f->second = Traits::kSecond < 0 ? 0 : internal::Read2(row + Traits::kSecond);
+        return internal::InRange(*f);
+    }
+};
+
+struct Ssse3Kernel {
+    // gather the digit pairs with pshufb, then pmaddubsw folds each pair to d0 * 10 + d1
+    template <DateTimeLayout layout>
+    __attribute__((target("ssse3"))) static bool Parse(const char *row,
+                                                        internal::CivilFields *f) {
+        const VectorLayout &v = VectorTables<layout>::kLayout;
+        __m128i lo, hi;
+        if (!Validate<layout>(row, &lo, &hi)) {
+            return false;
+        }
+        __m128i digits = _mm_shuffle_epi8(lo, LoadVector(v.shuffle_lo));
+        if constexpr (internal::LayoutTraits<layout>::kSize > 16) {
+            digits = _mm_or_si128(digits, _mm_shuffle_epi8(hi, LoadVector(v.shuffle_hi)));
+        }
+        __m128i pairs = _mm_maddubs_epi16(digits, _mm_set1_epi16(0x010a));
+        f->year = _mm_extract_epi16(pairs, 0) * 100 + _mm_extract_epi16(pairs, 1);
+        f->month = _mm_extract_epi16(pairs, 2);
+        f->day = _mm_extract_epi16(pairs, 3);
+        f->hour = _mm_extract_epi16(pairs, 4);
+        f->minute = _mm_extract_epi16(pairs, 5);
+        f->second = _mm_extract_epi16(pairs, 6);
+        return internal::InRange(*f);
+    }
+};
+#endif
+
+template <DateTimeLayout layout, typename Kernel>
+__attribute__((always_inline)) inline size_t ParseColumn(const absl::string_view *rows,
+                                                         size_t n, TimeUnit unit, int64_t *out,
+                                                         uint64_t *errors,
+                                                         const TimeZoneCache &tz) {
+    constexpr size_t kSize = internal::LayoutTraits<layout>::kSize;
+    static_assert(kSize >= 8 && kSize <= kRowVector, "layout must fit the row vectors");
+    size_t failed = 0;
+    // columns are mostly sorted, consecutive rows share one offset
+    TimeZoneCache::LocalRange range{0, 0, 0};
+    for (size_t i = 0; i < n; ++i) {
+        const absl::string_view row = rows[i];
+        internal::CivilFields f;
+        int millis = 0;
+        bool ok = row.size() >= kSize &&
+                  (row.size() == kSize || ParseFraction(row.substr(kSize), &millis));
+        ok = ok && Kernel::template Parse<layout>(row.data(), &f);
+        if (!ok) {
+            out[i] = 0;
+            if (errors != nullptr) errors[i / 64] |= uint64_t{1} << (i % 64);
+            ++failed;
+            continue;
+        }
+        int64_t local = SecondsFromCivil(f.year, f.month, f.day, f.hour, f.minute, f.second);
+        if (!range.Contains(local)) {
+            range = tz.RangeOf(local);
+        }
+        int64_t seconds = range.Contains(local) ? local - range.offset
+                                                : tz.ToEpoch(CivilTime{f.year, f.month, f.day,
+                                                                       f.hour, f.minute, f.second});
+        out[i] = unit == TimeUnit::kMillis ? seconds * 1000 + millis : seconds;
+    }
+    return failed;
+}
+
+template <DateTimeLayout layout>
+size_t ParseColumnScalar(const absl::string_view *rows, size_t n, TimeUnit unit, int64_t *out,
+                         uint64_t *errors, const TimeZoneCache &tz) {
+#ifdef ALPHERATZ_BATCH_PARSE_X86
+    return ParseColumn<layout, Sse2Kernel>(rows, n, unit, out, errors, tz);
+#else
+    return ParseColumn<layout, ScalarKernel>(rows, n, unit, out, errors, tz);
+#endif
+}
+
+#ifdef ALPHERATZ_BATCH_PARSE_X86
+template <DateTimeLayout layout>
+__attribute__((target("ssse3"))) size_t ParseColumnSsse3(const absl::string_view *rows,
+                                                         size_t n, TimeUnit unit, int64_t *out,
+                                                         uint64_t *errors,
+                                                         const TimeZoneCache &tz) {
+    return ParseColumn<layout, Ssse3Kernel>(rows, n, unit, out, errors, tz);
+}
+
+bool HasSsse3() {
+    static const bool has = __builtin_cpu_supports("ssse3");
+    return has;
+}
+#endif
+
+template <DateTimeLayout layout>
+size_t Dispatch(const absl::string_view *rows, size_t n, TimeUnit unit, int64_t *out,
+                uint64_t *errors, const TimeZoneCache &tz) {
+#ifdef ALPHERATZ_BATCH_PARSE_X86
+    if (HasSsse3()) {
+        return ParseColumnSsse3<layout>(rows, n, unit, out, errors, tz);
+    }
+#endif
+    return ParseColumnScalar<layout>(rows, n, unit, out, errors, tz);
+}
+
+}  // namespace
+
+size_t ParseTimestamps(const absl::string_view *rows, size_t n, DateTimeLayout layout,
+                       TimeUnit unit, int64_t *out, uint64_t *errors, const TimeZoneCache &tz) {
+    if (errors != nullptr) {
+        std::memset(errors, 0, ErrorBitmapWords(n) * sizeof(uint64_t));
+    }
+    switch (layout) {
+        case DateTimeLayout::kDateTime:
+            return Dispatch<DateTimeLayout::kDateTime>(rows, n, unit, out, errors, tz);
+        case DateTimeLayout::kDateTime2:
+            return Dispatch<DateTimeLayout::kDateTime2>(rows, n, unit, out, errors, tz);
+        case DateTimeLayout::kDate:
+            return Dispatch<DateTimeLayout::kDate>(rows, n, unit, out, errors, tz);
+    }
+    return 0;
+}
+
+}  // namespace time
+}  // namespace alpheratz
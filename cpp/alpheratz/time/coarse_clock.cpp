@@ -0,0 +1,166 @@
+#include <alpheratz/time/coarse_clock.h>
+#include <alpheratz/time/datetime_kernel.h>
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+namespace alpheratz {
+namespace time {
+
+namespace {
+
+#ifdef CLOCK_REALTIME_COARSE
+constexpr clockid_t kWallCoarse = CLOCK_REALTIME_COARSE;
+constexpr clockid_t kMonotonicCoarse = CLOCK_MONOTONIC_COARSE;
+#else
+constexpr clockid_t kWallCoarse = CLOCK_REALTIME;
+constexpr clockid_t kMonotonicCoarse = CLOCK_MONOTONIC;
+#endif
+
+int64_t ClockMillis(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+void FormatSecond(int64_t seconds, const TimeZoneCache &tz, char *buf) {
+    CivilTime c = tz.ToCivil(seconds);
+    internal::CivilFields f{static_cast<int>(c.year), c.month, c.day, c.hour, c.minute,
+                            c.second};
+    if (internal::Formattable(f)) {
+        internal::FormatLayout<DateTimeLayout::kDateTime>(f, buf);
+        return;
+    }
+    char text[64];
+    std::snprintf(text, sizeof(text), "%04lld-%02d-%02d %02d:%02d:%02d",
+                  static_cast<long long>(c.year), c.month, c.day, c.hour, c.minute, c.second);
+    std::memcpy(buf, text, CoarseClock::kTextSize);
+}
+
+}  // namespace
+
+CoarseClock &CoarseClock::Get() {
+    // the zones a ticker may format in are built first, so they are destroyed after the
+    // clock has stopped its ticker
+    TimeZoneCache::Local();
+    TimeZoneCache::Utc();
+    static CoarseClock clock;
+    return clock;
+}
+
+CoarseClock::~CoarseClock() { Stop(); }
+
+absl::Status CoarseClock::Start(std::chrono::milliseconds interval, const TimeZoneCache &tz) {
+    if (interval.count() <= 0) {
+        return absl::InvalidArgumentError("coarse clock interval must be positive");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) {
+        return absl::OkStatus();
+    }
+    stop_ = false;
+    // readers switch over only after the first reading is in place
+    int64_t formatted = std::numeric_limits<int64_t>::min();
+    Tick(tz, &formatted);
+    thread_ = std::thread(&CoarseClock::Run, this, interval, &tz);
+    running_.store(true, std::memory_order_release);
+    return absl::OkStatus();
+}
+
+void CoarseClock::Stop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!thread_.joinable()) {
+        return;
+    }
+    running_.store(false, std::memory_order_release);
+    stop_ = true;
+    stop_cv_.notify_all();
+    lock.unlock();
+    thread_.join();
+}
+
+void CoarseClock::Run(std::chrono::milliseconds interval, const TimeZoneCache *tz) {
+    int64_t formatted = std::numeric_limits<int64_t>::min();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_cv_.wait_for(lock, interval, [this]() { return stop_; })) {
+        lock.unlock();
+        Tick(*tz, &formatted);
+        lock.lock();
+    }
+}
+
+void CoarseClock::Tick(const TimeZoneCache &tz, int64_t *formatted) {
+    int64_t millis = ClockMillis(CLOCK_REALTIME);
+    int64_t seconds = millis / 1000;
+    if (seconds != *formatted) {
+        uint64_t words[kTextWords] = {};
+        FormatSecond(seconds, tz, reinterpret_cast<char *>(words));
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kTextWords; ++i) {
+            text_[i].store(words[i], std::memory_order_relaxed);
+        }
+        sequence_.store(sequence + 2, std::memory_order_release);
+        *formatted = seconds;
+    }
+    monotonic_.store(ClockMillis(CLOCK_MONOTONIC), std::memory_order_relaxed);
+    millis_.store(millis, std::memory_order_release);
+}
+
+int64_t CoarseClock::NowMillis() const {
+    if (Running()) {
+        return millis_.load(std::memory_order_acquire);
+    }
+    return ClockMillis(kWallCoarse);
+}
+
+int64_t CoarseClock::MonotonicMillis() const {
+    if (Running()) {
+        return monotonic_.load(std::memory_order_relaxed);
+    }
+    return ClockMillis(kMonotonicCoarse);
+}
+
+void CoarseClock::NowText(char *buf) const {
+    if (Running()) {
+        uint64_t words[kTextWords];
+        while (true) {
+            uint64_t before = sequence_.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            for (size_t i = 0; i < kTextWords; ++i) {
+                words[i] = text_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+        std::memcpy(buf, words, kTextSize);
+        return;
+    }
+    struct Cache {
+        int64_t second = std::numeric_limits<int64_t>::min();
+        char text[kTextSize];
+    };
+    thread_local Cache cache;
+    int64_t second = NowSeconds();
+    if (second != cache.second) {
+        FormatSecond(second, TimeZoneCache::Local(), cache.text);
+        cache.second = second;
+    }
+    std::memcpy(buf, cache.text, kTextSize);
+}
+
+std::string CoarseClock::NowText() const {
+    char buf[kTextSize];
+    NowText(buf);
+    return std::string(buf, kTextSize);
+}
+
+}  // namespace time
+}  // namespace alpheratz
@@ -1,51 +1,288 @@
+#include <alpheratz/time/coarse_clock.h>
 #include <alpheratz/time/datetime.h>
+#include <alpheratz/time/datetime_kernel.h>
 
 #include <cstring>
-#include <sstream>
 namespace alpheratz {
 namespace time {
 
-std::string DateTime::ToString(const std::string &format) const {
-    std::ostringstream oss;
+namespace {
+
+// strftime output above this was reported as failure, keep the limit
+constexpr size_t kMaxFormatted = 99;
+
+internal::CivilFields FieldsOf(int year, int month, int day, int hour, int minute, int second) {
+    return internal::CivilFields{year, month, day, hour, minute, second};
+}
+
+bool FixedLayout(const std::string &format, DateTimeLayout *layout) {
+    if (format == DATETIME_FORMAT) {
+        *layout = DateTimeLayout::kDateTime;
+    } else if (format == DATETIME_FORMAT2) {
+        *layout = DateTimeLayout::kDateTime2;
+    } else if (format == DATE_FORMAT) {
+        *layout = DateTimeLayout::kDate;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// %Y %m %d %H %M %S %% and literals only, false means strftime has to do it
+bool FormatGeneral(const internal::CivilFields &f, const std::string &format, std::string *out) {
+    if (!internal::Formattable(f)) {
+        return false;
+    }
+    out->clear();
+    out->reserve(format.size() + 8);
+    char digits[4];
+    for (size_t i = 0; i < format.size(); ++i) {
+        if (format[i] != '%') {
+            out->push_back(format[i]);
+            continue;
+        }
+        if (++i == format.size()) {
+            return false;
+        }
+        switch (format[i]) {
+            case 'Y':
+                internal::Write4(digits, f.year);
+                out->append(digits, 4);
+                continue;
+            case 'm':
+                internal::Write2(digits, f.month);
+                break;
+            case 'd':
+                internal::Write2(digits, f.day);
+                break;
+            case 'H':
+                internal::Write2(digits, f.hour);
+                break;
+            case 'M':
+                internal::Write2(digits, f.minute);
+                break;
+            case 'S':
+                internal::Write2(digits, f.second);
+                break;
+            case '%':
+                out->push_back('%');
+                continue;
+            default:
+                return false;
+        }
+        out->append(digits, 2);
+    }
+    return true;
+}
+
+std::string FormatStrftime(const internal::CivilFields &f, const char *format) {
     struct tm t;
-    t.tm_year = year_ - 1900;
-    t.tm_mon = month_ - 1;
-    t.tm_mday = day_;
-    t.tm_hour = hour_;
-    t.tm_min = minute_;
-    t.tm_sec = second_;
-    char buf[100];
-    if (strftime(buf, sizeof(buf), format.c_str(), &t) == 0) {
+    std::memset(&t, 0, sizeof(t));
+    t.tm_year = f.year - 1900;
+    t.tm_mon = f.month - 1;
+    t.tm_mday = f.day;
+    t.tm_hour = f.hour;
+    t.tm_min = f.minute;
+    t.tm_sec = f.second;
+    char buf[kMaxFormatted + 1];
+    if (strftime(buf, sizeof(buf), format, &t) == 0) {
         return "";
     }
     return buf;
 }
 
-DateTime DateTime::Parse(const std::string &str, const std::string &format) {
-    DateTime dt;
-    struct tm t = {};
+// strict counterpart of strptime for the same specifiers: fixed width numbers, exact
+// literals, whole input consumed. false leaves the lenient cases to strptime
+bool ParseGeneral(absl::string_view str, const std::string &format, internal::CivilFields *f) {
+    size_t pos = 0;
+    for (size_t i = 0; i < format.size(); ++i) {
+        if (format[i] != '%') {
+            if (pos == str.size() || str[pos] != format[i]) {
+                return false;
+            }
+            ++pos;
+            continue;
+        }
+        if (++i == format.size()) {
+            return false;
+        }
+        char spec = format[i];
+        if (spec == '%') {
+            if (pos == str.size() || str[pos] != '%') {
+                return false;
+            }
+            ++pos;
+            continue;
+        }
+        size_t width = spec == 'Y' ? 4 : 2;
+        if (str.size() - pos < width) {
+            return false;
+        }
+        for (size_t k = 0; k < width; ++k) {
+            if (internal::DigitAt(str.data() + pos + k) > 9) {
+                return false;
+            }
+        }
+        const char *p = str.data() + pos;
+        pos += width;
+        int v = width == 4 ? internal::Read4(p) : internal::Read2(p);
+        switch (spec) {
+            case 'Y':
+                f->year = v;
+                break;
+            case 'm':
+                if (v < 1 || v > 12) return false;
+                f->month = v;
+                break;
+            case 'd':
+                if (v < 1 || v > 31) return false;
+                f->day = v;
+                break;
+            case 'H':
+                if (v > 23) return false;
+                f->hour = v;
+                break;
+            case 'M':
+                if (v > 59) return false;
+                f->minute = v;
+                break;
+            case 'S':
+                if (v > 61) return false;
+                f->second = v;
+                break;
+            default:
+                return false;
+        }
+    }
+    return pos == str.size();
+}
+
+bool ParseStrptime(const std::string &str, const std::string &format, internal::CivilFields *f) {
+    struct tm t;
     std::memset(&t, 0, sizeof(t));
     if (strptime(str.c_str(), format.c_str(), &t) == nullptr) {
-        return dt;
+        return false;
     }
-    dt.year_ = t.tm_year + 1900;
-    dt.month_ = t.tm_mon + 1;
-    dt.day_ = t.tm_mday;
-    dt.hour_ = t.tm_hour;
-    dt.minute_ = t.tm_min;
-    dt.second_ = t.tm_sec;
-    return dt;
+    *f = FieldsOf(t.tm_year + 1900, t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+    return true;
 }
-time_t DateTime::GetTimestamp() const {
-    struct tm t;
-    t.tm_year = year_ - 1900;
-    t.tm_mon = month_ - 1;
-    t.tm_mday = day_;
-    t.tm_hour = hour_;
-    t.tm_min = minute_;
-    t.tm_sec = second_;
-    t.tm_isdst = -1;
-    return mktime(&t);
+
+template <DateTimeLayout layout>
+bool ParseLayoutOrStrptime(absl::string_view str, internal::CivilFields *f) {
+    if (internal::ParseLayout<layout>(str.data(), str.size(), f)) {
+        return true;
+    }
+    return ParseStrptime(std::string(str.data(), str.size()),
+                         internal::LayoutTraits<layout>::kFormat, f);
+}
+
+}  // namespace
+
+std::string DateTime::ToString(const std::string &format) const {
+    DateTimeLayout layout;
+    if (FixedLayout(format, &layout)) {
+        switch (layout) {
+            case DateTimeLayout::kDateTime:
+                return ToString<DateTimeLayout::kDateTime>();
+            case DateTimeLayout::kDateTime2:
+                return ToString<DateTimeLayout::kDateTime2>();
+            case DateTimeLayout::kDate:
+                return ToString<DateTimeLayout::kDate>();
+        }
+    }
+    std::string out;
+    if (FormatGeneral(FieldsOf(year_, month_, day_, hour_, minute_, second_), format, &out)) {
+        return out.size() > kMaxFormatted ? "" : out;
+    }
+    return FormatStrftime(FieldsOf(year_, month_, day_, hour_, minute_, second_), format.c_str());
+}
+
+DateTime DateTime::Parse(const std::string &str, const std::string &format) {
+    DateTimeLayout layout;
+    if (FixedLayout(format, &layout)) {
+        switch (layout) {
+            case DateTimeLayout::kDateTime:
+                return Parse<DateTimeLayout::kDateTime>(str);
+            case DateTimeLayout::kDateTime2:
+                return Parse<DateTimeLayout::kDateTime2>(str);
+            case DateTimeLayout::kDate:
+                return Parse<DateTimeLayout::kDate>(str);
+        }
+    }
+    // fields missing from format read as a zeroed struct tm
+    internal::CivilFields f = FieldsOf(1900, 1, 0, 0, 0, 0);
+    if (!ParseGeneral(str, format, &f) && !ParseStrptime(str, format, &f)) {
+        return DateTime();
+    }
+    return DateTime(f.year, f.month, f.day, f.hour, f.minute, f.second);
+}
+
+template <DateTimeLayout layout>
+std::string DateTime::ToString() const {
+    char buf[internal::LayoutTraits<layout>::kSize];
+    size_t n = Format<layout>(buf, sizeof(buf));
+    if (n == 0) {
+        return FormatStrftime(FieldsOf(year_, month_, day_, hour_, minute_, second_),
+                              internal::LayoutTraits<layout>::kFormat);
+    }
+    return std::string(buf, n);
+}
+
+template <DateTimeLayout layout>
+size_t DateTime::Format(char *buf, size_t size) const {
+    internal::CivilFields f = FieldsOf(year_, month_, day_, hour_, minute_, second_);
+    if (size < internal::LayoutTraits<layout>::kSize || !internal::Formattable(f)) {
+        return 0;
+    }
+    internal::FormatLayout<layout>(f, buf);
+    return internal::LayoutTraits<layout>::kSize;
+}
+
+template <DateTimeLayout layout>
+DateTime DateTime::Parse(absl::string_view str) {
+    internal::CivilFields f;
+    if (!ParseLayoutOrStrptime<layout>(str, &f)) {
+        return DateTime();
+    }
+    return DateTime(f.year, f.month, f.day, f.hour, f.minute, f.second);
+}
+
+template <DateTimeLayout layout>
+bool DateTime::TryParse(absl::string_view str, DateTime *dt) {
+    internal::CivilFields f;
+    if (!internal::ParseLayout<layout>(str.data(), str.size(), &f)) {
+        return false;
+    }
+    *dt = DateTime(f.year, f.month, f.day, f.hour, f.minute, f.second);
+    return true;
+}
+
+#define ALPHERATZ_DATETIME_LAYOUT(layout)                                        \
+    template std::string DateTime::ToString<layout>() const;                    \
+    template size_t DateTime::Format<layout>(char *buf, size_t size) const;      \
+    template DateTime DateTime::Parse<layout>(absl::string_view str);            \
+    template bool DateTime::TryParse<layout>(absl::string_view str, DateTime *dt);
+
+ALPHERATZ_DATETIME_LAYOUT(DateTimeLayout::kDateTime)
+ALPHERATZ_DATETIME_LAYOUT(DateTimeLayout::kDateTime2)
+ALPHERATZ_DATETIME_LAYOUT(DateTimeLayout::kDate)
+#undef ALPHERATZ_DATETIME_LAYOUT
+
+DateTime::DateTime() : DateTime(static_cast<time_t>(CoarseClock::Get().NowSeconds())) {}
+
+DateTime::DateTime(time_t timestamp, const TimeZoneCache &tz) {
+    CivilTime civil = tz.ToCivil(timestamp);
+    year_ = static_cast<int>(civil.year);
+    month_ = civil.month;
+    day_ = civil.day;
+    hour_ = civil.hour;
+    minute_ = civil.minute;
+    second_ = civil.second;
+}
+
+time_t DateTime::GetTimestamp(const TimeZoneCache &tz) const {
+    return static_cast<time_t>(
+        tz.ToEpoch(CivilTime{year_, month_, day_, hour_, minute_, second_}));
 }
 }  // namespace time
 }  // namespace alpheratz
@@ -0,0 +1,175 @@
+#pragma once
+// @author all3n
+// digit kernels for the fixed DateTime layouts, shared by single and batch parsing
+#include <alpheratz/time/datetime.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace alpheratz {
+namespace time {
+namespace internal {
+
+struct CivilFields {
+    int year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    int second;
+};
+
+// 'd' is a digit, any other char must match literally;
+// offsets are -1 for fields absent from the layout
+template <DateTimeLayout layout>
+struct LayoutTraits;
+
+template <>
+struct LayoutTraits<DateTimeLayout::kDateTime> {
+    static constexpr const char *kFormat = DATETIME_FORMAT;
+    static constexpr const char *kPattern = "dddd-dd-dd dd:dd:dd";
+    static constexpr size_t kSize = 19;
+    static constexpr int kHour = 11, kMinute = 14, kSecond = 17;
+};
+
+template <>
+struct LayoutTraits<DateTimeLayout::kDateTime2> {
+    static constexpr const char *kFormat = DATETIME_FORMAT2;
+    static constexpr const char *kPattern = "dddddddddddddd";
+    static constexpr size_t kSize = 14;
+    static constexpr int kHour = 8, kMinute = 10, kSecond = 12;
+};
+
+template <>
+struct LayoutTraits<DateTimeLayout::kDate> {
+    static constexpr const char *kFormat = DATE_FORMAT;
+    static constexpr const char *kPattern = "dddd-dd-dd";
+    static constexpr size_t kSize = 10;
+    static constexpr int kHour = -1, kMinute = -1, kSecond = -1;
+};
+
+template <DateTimeLayout layout>
+constexpr int MonthOffset() {
+    return layout == DateTimeLayout::kDateTime2 ? 4 : 5;
+}
+
+template <DateTimeLayout layout>
+constexpr int DayOffset() {
+    return layout == DateTimeLayout::kDateTime2 ? 6 : 8;
+}
+
+inline uint32_t DigitAt(const char *p) {
+    return static_cast<uint32_t>(static_cast<unsigned char>(*p)) - '0';
+}
+
+inline int Read2(const char *p) { return static_cast<int>(DigitAt(p) * 10 + DigitAt(p + 1)); }
+
+inline int Read4(const char *p) {
+    return static_cast<int>(DigitAt(p) * 1000 + DigitAt(p + 1) * 100 + DigitAt(p + 2) * 10 +
+                            DigitAt(p + 3));
+}
+
+inline void Write2(char *p, int v) {
+    p[0] = static_cast<char>('0' + v / 10);
+    p[1] = static_cast<char>('0' + v % 10);
+}
+
+inline void Write4(char *p, int v) {
+    Write2(p, v / 100);
+    Write2(p + 2, v % 100);
+}
+
+// the ranges strptime accepts, so a match here equals its result
+inline bool InRange(const CivilFields &f) {
+    return static_cast<unsigned>(f.month - 1) < 12 && static_cast<unsigned>(f.day - 1) < 31 &&
+           static_cast<unsigned>(f.hour) < 24 && static_cast<unsigned>(f.minute) < 60 &&
+           static_cast<unsigned>(f.second) < 62;
+}
+
+// 8 pattern bytes from offset as a little endian word: the expected char for literals,
+// '0' for digits when digit is false; 0x76 for digits, 0x7f for literals when true
+template <DateTimeLayout layout>
+constexpr uint64_t PatternWord(size_t offset, bool digit) {
+    uint64_t word = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        char c = LayoutTraits<layout>::kPattern[offset + i];
+        uint64_t byte = digit ? (c == 'd' ? 0x76 : 0x7f) : (c == 'd' ? '0' : c);
+        word |= byte << (8 * i);
+    }
+    return word;
+}
+
+// xor with the pattern maps digits to 0..9 and matching literals to 0, then adding
+// 0x76 / 0x7f to the low 7 bits sets the high bit of every byte out of that range
+template <DateTimeLayout layout, size_t offset>
+inline uint64_t MismatchAt(const char *p) {
+    constexpr uint64_t kExpect = PatternWord<layout>(offset, false);
+    constexpr uint64_t kBias = PatternWord<layout>(offset, true);
+    uint64_t word;
+    std::memcpy(&word, p + offset, sizeof(word));
+    word ^= kExpect;
+    return (((word & 0x7f7f7f7f7f7f7f7fULL) + kBias) | word) & 0x8080808080808080ULL;
+}
+
+// exact match of the layout, no surrounding blanks or trailing chars
+template <DateTimeLayout layout>
+inline bool ParseLayout(const char *p, size_t n, CivilFields *f) {
+    using Traits = LayoutTraits<layout>;
+    static_assert(Traits::kSize >= 8 && Traits::kSize <= 24, "layout must fit 1 to 3 words");
+    if (n != Traits::kSize) {
+        return false;
+    }
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    // the last word may overlap its predecessor
+    uint64_t bad = MismatchAt<layout, 0>(p) | MismatchAt<layout, Traits::kSize - 8>(p);
+    if constexpr (Traits::kSize > 16) {
+        bad |= MismatchAt<layout, 8>(p);
+    }
+#else
+    uint32_t bad = 0;
+    for (size_t i = 0; i < Traits::kSize; ++i) {
+        if (Traits::kPattern[i] == 'd') {
+            bad |= DigitAt(p + i) > 9;
+        } else {
+            bad |= p[i] != Traits::kPattern[i];
+        }
+    }
+#endif
+    if (bad) {
+        return false;
+    }
+    f->year = Read4(p);
+    f->month = Read2(p + MonthOffset<layout>());
+    f->day = Read2(p + DayOffset<layout>());
+    f->hour = Traits::kHour < 0 ? 0 : Read2(p + Traits::kHour);
+    f->minute = Traits::kMinute < 0 ? 0 : Read2(p + Traits::kMinute);
+    f->second = Traits::kSecond < 0 ? 0 : Read2(p + Traits::kSecond);
+    return InRange(*f);
+}
+
+// strftime prints %Y unpadded, so only 4 digit years take the fast path
+inline bool Formattable(const CivilFields &f) {
+    return f.year >= 1000 && f.year <= 9999 && static_cast<unsigned>(f.month) < 100 &&
+           static_cast<unsigned>(f.day) < 100 && static_cast<unsigned>(f.hour) < 100 &&
+           static_cast<unsigned>(f.minute) < 100 && static_cast<unsigned>(f.second) < 100;
+}
+
+// out must hold LayoutTraits<layout>::kSize chars, f must be Formattable
+template <DateTimeLayout layout>
+inline void FormatLayout(const CivilFields &f, char *out) {
+    using Traits = LayoutTraits<layout>;
+    for (size_t i = 0; i < Traits::kSize; ++i) {
+        out[i] = Traits::kPattern[i];
+    }
+    Write4(out, f.year);
+    Write2(out + MonthOffset<layout>(), f.month);
+    Write2(out + DayOffset<layout>(), f.day);
+    if (Traits::kHour >= 0) Write2(out + Traits::kHour, f.hour);
+    if (Traits::kMinute >= 0) Write2(out + Traits::kMinute, f.minute);
+    if (Traits::kSecond >= 0) Write2(out + Traits::kSecond, f.second);
+}
+
+}  // namespace internal
+}  // namespace time
+}  // namespace alpheratz
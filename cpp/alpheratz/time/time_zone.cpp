@@ -0,0 +1,127 @@
+#include <absl/container/flat_hash_map.h>
+#include <absl/time/civil_time.h>
+#include <alpheratz/time/time_zone.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace alpheratz {
+namespace time {
+
+namespace {
+
+CivilTime FromAbsl(const absl::CivilSecond &cs) {
+    return CivilTime{cs.year(), cs.month(), cs.day(), cs.hour(), cs.minute(), cs.second()};
+}
+
+}  // namespace
+
+TimeZoneCache::TimeZoneCache(absl::TimeZone tz)
+    : name_(tz.name()),
+      tz_(tz),
+      initial_offset_(tz.At(absl::UnixEpoch()).offset),
+      table_end_(SecondsFromCivil(kTableEndYear, 1, 1, 0, 0, 0)) {
+    const absl::Time end = absl::FromUnixSeconds(table_end_);
+    absl::Time t = absl::InfinitePast();
+    absl::TimeZone::CivilTransition trans;
+    bool first = true;
+    int32_t previous = initial_offset_;
+    while (tz_.NextTransition(t, &trans)) {
+        absl::Time instant = tz_.At(trans.to).trans;
+        if (instant >= end || instant <= t) {
+            break;
+        }
+        if (first) {
+            previous = initial_offset_ = tz_.At(instant - absl::Seconds(1)).offset;
+            first = false;
+        }
+        int32_t offset = tz_.At(instant).offset;
+        int64_t epoch = absl::ToUnixSeconds(instant);
+        transitions_.push_back(Transition{epoch, epoch + std::max(previous, offset), offset});
+        previous = offset;
+        t = instant;
+    }
+}
+
+const TimeZoneCache &TimeZoneCache::Local() {
+    static const TimeZoneCache local(absl::LocalTimeZone());
+    return local;
+}
+
+const TimeZoneCache &TimeZoneCache::Utc() {
+    static const TimeZoneCache utc(absl::UTCTimeZone());
+    return utc;
+}
+
+absl::StatusOr<const TimeZoneCache *> TimeZoneCache::Load(absl::string_view name) {
+    static std::mutex mutex;
+    // never destroyed, a zone may be used by threads still running at exit
+    static auto &zones = *new absl::flat_hash_map<std::string, std::unique_ptr<TimeZoneCache>>();
+    std::string key(name.data(), name.size());
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = zones.find(key);
+    if (it != zones.end()) {
+        return it->second.get();
+    }
+    absl::TimeZone tz;
+    if (!absl::LoadTimeZone(key, &tz)) {
+        return absl::NotFoundError("unknown time zone: " + key);
+    }
+    auto &zone = zones[key];
+    zone = std::make_unique<TimeZoneCache>(tz);
+    return zone.get();
+}
+
+int TimeZoneCache::OffsetAt(int64_t epoch) const {
+    if (epoch >= table_end_) {
+        return tz_.At(absl::FromUnixSeconds(epoch)).offset;
+    }
+    auto it = std::upper_bound(
+        transitions_.begin(), transitions_.end(), epoch,
+        [](int64_t value, const Transition &transition) { return value < transition.epoch; });
+    return it == transitions_.begin() ? initial_offset_ : std::prev(it)->offset;
+}
+
+CivilTime TimeZoneCache::ToCivil(int64_t epoch) const {
+    if (epoch >= table_end_) {
+        return FromAbsl(tz_.At(absl::FromUnixSeconds(epoch)).cs);
+    }
+    return CivilFromSeconds(epoch + OffsetAt(epoch));
+}
+
+int64_t TimeZoneCache::ToEpoch(const CivilTime &civil) const {
+    int64_t local = SecondsFromCivil(civil.year, civil.month, civil.day, civil.hour,
+                                     civil.minute, civil.second);
+    LocalRange range = RangeOf(local);
+    if (range.Contains(local)) {
+        return local - range.offset;
+    }
+    absl::CivilSecond cs(civil.year, civil.month, civil.day, civil.hour, civil.minute,
+                         civil.second);
+    return absl::ToUnixSeconds(tz_.At(cs).pre);
+}
+
+TimeZoneCache::LocalRange TimeZoneCache::RangeOf(int64_t local) const {
+    // offsets stay below a day, so a result near the table end may lie past it
+    const int64_t end = table_end_ - 2 * kSecondsPerDay;
+    if (local >= end) {
+        return LocalRange{local, local, 0};
+    }
+    auto it = std::upper_bound(
+        transitions_.begin(), transitions_.end(), local,
+        [](int64_t value, const Transition &transition) { return value < transition.local; });
+    LocalRange range{std::numeric_limits<int64_t>::min(), end, initial_offset_};
+    if (it != transitions_.begin()) {
+        range.begin = std::prev(it)->local;
+        range.offset = std::prev(it)->offset;
+    }
+    if (it != transitions_.end()) {
+        range.end = std::min(end, it->local);
+    }
+    return range;
+}
+
+}  // namespace time
+}  // namespace alpheratz
@@ -0,0 +1,141 @@
+#pragma once
+// @author all3n
+// compressed uint32_t set with array, bitset and run containers
+#include <absl/status/status.h>
+#include <absl/status/statusor.h>
+#include <absl/strings/string_view.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alpheratz {
+namespace bitmap {
+
+/**
+ * values are grouped by their high 16 bits, each group is a container of the low 16
+ * bits: a sorted array up to 4096 values, a 8 KiB bitset above that, or sorted runs
+ * after RunOptimize when those are smaller. set operations work container by container;
+ * bitset against bitset runs 256 bits at a time with avx2 when the cpu has it. a run
+ * container that is changed turns back into an array or bitset.
+ *
+ * Serialize writes a layout in native byte order that Map can use in place: a header,
+ * a 16 byte descriptor per container and the containers 8 byte aligned, so opening a
+ * bitmap in a mapped file copies none of it. checking the containers still reads all of
+ * it, Map of trusted data skips that. not thread safe for writers, const methods may
+ * run concurrently
+ */
+class RoaringBitmap {
+   public:
+    RoaringBitmap();
+    ~RoaringBitmap();
+    RoaringBitmap(const RoaringBitmap &other);
+    RoaringBitmap(RoaringBitmap &&other) noexcept;
+    RoaringBitmap &operator=(const RoaringBitmap &other);
+    RoaringBitmap &operator=(RoaringBitmap &&other) noexcept;
+
+    static RoaringBitmap Of(const std::vector<uint32_t> &values);
+
+    void Add(uint32_t value);
+    // fastest when values are sorted
+    void AddMany(const uint32_t *values, size_t count);
+    // every value in [begin, end)
+    void AddRange(uint64_t begin, uint64_t end);
+    // false when value was not in the set
+    bool Remove(uint32_t value);
+    bool Contains(uint32_t value) const;
+    void Clear();
+
+    uint64_t Cardinality() const;
+    bool Empty() const;
+    // containers that store runs where that takes less memory, true when any changed
+    bool RunOptimize();
+    size_t BytesUsed() const;
+
+    RoaringBitmap &operator&=(const RoaringBitmap &other);
+    RoaringBitmap &operator|=(const RoaringBitmap &other);
+    RoaringBitmap &operator^=(const RoaringBitmap &other);
+    // values of this set that are not in other
+    RoaringBitmap &operator-=(const RoaringBitmap &other);
+    // size of the intersection without building it
+    uint64_t AndCardinality(const RoaringBitmap &other) const;
+    // same values, whatever the containers
+    bool operator==(const RoaringBitmap &other) const;
+    bool operator!=(const RoaringBitmap &other) const { return !(*this == other); }
+
+    std::vector<uint32_t> ToVector() const;
+
+    // ascending values. invalidated by changes to the bitmap
+    class Iterator {
+       public:
+        explicit Iterator(const RoaringBitmap *bitmap);
+
+        void SeekToFirst() { Seek(0); }
+        // the first value not less than target
+        void Seek(uint32_t target);
+        bool Valid() const { return valid_; }
+        void Next();
+        uint32_t Value() const { return value_; }
+
+       private:
+        // the first value of container index_ not less than low, on to later
+        // containers when it has none
+        void Load(uint32_t low);
+
+        const RoaringBitmap *bitmap_;
+        size_t index_ = 0;
+        // array index or run index of value_
+        size_t pos_ = 0;
+        uint32_t value_ = 0;
+        bool valid_ = false;
+    };
+
+    size_t SerializedSize() const;
+    void Serialize(std::string *out) const;
+    // a copy of serialized data, checked before use
+    static absl::StatusOr<RoaringBitmap> Deserialize(absl::string_view data);
+    // like Deserialize, but containers read straight from data until they are changed.
+    // data must stay valid and unchanged while the bitmap or a copy of it uses it. it
+    // is copied when not 8 byte aligned, as an offset into a mapping usually is.
+    // without verify only the header and descriptors are checked, so opening touches
+    // neither the containers nor their pages; for data this library wrote, damaged
+    // containers are undefined behaviour
+    static absl::StatusOr<RoaringBitmap> Map(absl::string_view data, bool verify = true);
+
+    // Serialize in a zstd frame, for cold storage
+    absl::Status SerializeCompressed(std::vector<uint8_t> *out) const;
+    static absl::StatusOr<RoaringBitmap> DeserializeCompressed(std::vector<uint8_t> &in);
+
+   private:
+    struct Container;
+    enum class Op { kAnd, kOr, kXor, kAndNot };
+
+    static absl::StatusOr<RoaringBitmap> Parse(absl::string_view data, bool map,
+                                               bool verify);
+
+    // index of the first container whose key is not less than key
+    size_t LowerBound(uint16_t key) const;
+    // the container of key, an empty one is added when there is none
+    Container &Get(uint16_t key);
+    void Erase(size_t index);
+    // a op b, the containers kept from a are moved when a is an rvalue
+    template <typename Left>
+    static RoaringBitmap Apply(Left &&a, const RoaringBitmap &b, Op op);
+
+    friend RoaringBitmap operator&(const RoaringBitmap &a, const RoaringBitmap &b);
+    friend RoaringBitmap operator|(const RoaringBitmap &a, const RoaringBitmap &b);
+    friend RoaringBitmap operator^(const RoaringBitmap &a, const RoaringBitmap &b);
+    friend RoaringBitmap operator-(const RoaringBitmap &a, const RoaringBitmap &b);
+
+    std::vector<uint16_t> keys_;
+    std::vector<Container> containers_;
+};
+
+RoaringBitmap operator&(const RoaringBitmap &a, const RoaringBitmap &b);
+RoaringBitmap operator|(const RoaringBitmap &a, const RoaringBitmap &b);
+RoaringBitmap operator^(const RoaringBitmap &a, const RoaringBitmap &b);
+RoaringBitmap operator-(const RoaringBitmap &a, const RoaringBitmap &b);
+
+}  // namespace bitmap
+}  // namespace alpheratz
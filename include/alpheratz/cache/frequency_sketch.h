@@ -0,0 +1,45 @@
+#pragma once
+// @author all3n
+// count-min sketch of 4 bit counters that ages, the TinyLFU popularity estimate
+#include <alpheratz/common/macro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace alpheratz {
+namespace cache {
+
+/**
+ * four rows of 4 bit counters, an estimate is the smallest counter of a key. after ten
+ * increments per counter of a row every counter is halved, so the sketch forgets old
+ * popularity and stays within the 0..15 a counter holds. not thread safe
+ */
+class FrequencySketch {
+   public:
+    // sized for about capacity distinct keys
+    explicit FrequencySketch(size_t capacity);
+
+    void Increment(uint64_t hash);
+    // 0..15
+    uint32_t Estimate(uint64_t hash) const;
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(FrequencySketch);
+
+    static constexpr int kRows = 4;
+    static constexpr size_t kCountersPerWord = 16;
+
+    size_t Index(uint64_t hash, int row) const;
+    void Halve();
+
+    // row r uses words [r * row_words_, (r + 1) * row_words_)
+    std::vector<uint64_t> table_;
+    size_t row_words_;
+    int width_bits_;
+    size_t additions_{0};
+    size_t sample_size_;
+};
+
+}  // namespace cache
+}  // namespace alpheratz
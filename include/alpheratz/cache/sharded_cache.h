@@ -0,0 +1,403 @@
+#pragma once
+// @author all3n
+// concurrent cache split into independently locked shards, LRU or W-TinyLFU
+#include <absl/container/flat_hash_map.h>
+#include <alpheratz/cache/frequency_sketch.h>
+#include <alpheratz/common/macro.h>
+#include <alpheratz/concurrent/event_count.h>
+#include <alpheratz/hash/murmurhash3.h>
+#include <alpheratz/time/coarse_clock.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace alpheratz {
+namespace cache {
+
+enum class CachePolicy {
+    // evict the least recently used entry
+    kLru,
+    // a small LRU window in front of a segmented LRU. an entry leaving the window only
+    // replaces the oldest entry of the main part when the frequency sketch says it is
+    // used more often, so a popular working set survives scans that flush a plain LRU.
+    // a shard bound of one entry or byte leaves no room for a window, those run as kLru
+    kTinyLfu,
+};
+
+struct CacheOptions {
+    // rounded up to a power of two
+    size_t shards = 16;
+    // bounds of the whole cache, split evenly over the shards. 0 is unbounded
+    size_t max_entries = 0;
+    size_t max_bytes = 0;
+    // entries expire this long after their Put, on CoarseClock::MonotonicMillis. expired
+    // entries are dropped when read or evicted. 0 never expires
+    int64_t ttl_ms = 0;
+    CachePolicy policy = CachePolicy::kLru;
+};
+
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t puts = 0;
+    // dropped to stay within the bounds, including entries TinyLFU did not admit
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// MurmurHash64 of the key, byte wise for integers, enums, float and double
+template <typename Key>
+struct CacheKeyHash {
+    static_assert(std::is_integral<Key>::value || std::is_enum<Key>::value ||
+                      std::is_same<Key, float>::value || std::is_same<Key, double>::value,
+                  "pass ShardedCache a hash for this key type");
+    uint64_t operator()(const Key &key) const {
+        Key normal = key;
+        if constexpr (std::is_floating_point<Key>::value) {
+            // -0.0 equals 0.0, so it has to land on the same shard
+            if (normal == 0) normal = 0;
+        }
+        return static_cast<uint64_t>(hash::MurmurHash64(&normal, sizeof(normal), 0));
+    }
+};
+
+template <>
+struct CacheKeyHash<std::string> {
+    uint64_t operator()(const std::string &key) const {
+        return static_cast<uint64_t>(
+            hash::MurmurHash64(key.data(), static_cast<int>(key.size()), 0));
+    }
+};
+
+// heap memory owned by a key or value, counted by the default weigher
+template <typename T>
+size_t HeapBytes(const T &) {
+    return 0;
+}
+inline size_t HeapBytes(const std::string &value) { return value.capacity(); }
+template <typename T>
+size_t HeapBytes(const std::vector<T> &value) {
+    return value.capacity() * sizeof(T);
+}
+
+/**
+ * a key hashes to one shard, each shard is a hash map plus recency lists behind its own
+ * mutex, so threads touching different shards never contend. values are shared_ptrs: a
+ * value handed out by Get stays valid after it is evicted or replaced
+ */
+template <typename Key, typename Value, typename Hash = CacheKeyHash<Key>>
+class ShardedCache {
+   public:
+    using ValuePtr = std::shared_ptr<const Value>;
+    // bytes an entry counts against max_bytes
+    using Weigher = std::function<size_t(const Key &, const Value &)>;
+
+    explicit ShardedCache(const CacheOptions &options = {}, Weigher weigher = nullptr)
+        : options_(options), weigher_(std::move(weigher)) {
+        size_t shards = 1;
+        while (shards < options.shards) shards <<= 1;
+        mask_ = shards - 1;
+        // per shard, rounded up so small bounds still leave every shard room
+        total_ = {(options.max_entries + shards - 1) / shards,
+                  (options.max_bytes + shards - 1) / shards};
+        // a window of at least 1 would leave nothing to the main part, 0 being unbounded
+        bool tiny_lfu = options.policy == CachePolicy::kTinyLfu && total_.entries != 1 &&
+                        total_.bytes != 1;
+        if (tiny_lfu) {
+            // about 1% window, the main part 20% probation and 80% protected
+            window_ = {Share(total_.entries, 100), Share(total_.bytes, 100)};
+            main_ = {total_.entries - window_.entries, total_.bytes - window_.bytes};
+            protected_ = {main_.entries * 4 / 5, main_.bytes * 4 / 5};
+        }
+        size_t sketch_size = total_.entries > 0 ? total_.entries : 4096;
+        for (size_t i = 0; i < shards; ++i) {
+            shards_.emplace_back(new Shard());
+            if (tiny_lfu) {
+                shards_.back()->sketch.reset(new FrequencySketch(sketch_size));
+            }
+        }
+        if (!weigher_) {
+            weigher_ = [](const Key &key, const Value &value) {
+                return sizeof(Key) + sizeof(Value) + HeapBytes(key) + HeapBytes(value);
+            };
+        }
+    }
+
+    // null on a miss or an expired entry
+    ValuePtr Get(const Key &key) {
+        uint64_t hash = hash_(key);
+        Shard &shard = ShardFor(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.sketch) shard.sketch->Increment(hash);
+        auto found = shard.index.find(key);
+        if (found == shard.index.end()) {
+            ++shard.stats.misses;
+            return nullptr;
+        }
+        auto it = found->second;
+        if (Expired(*it)) {
+            Unlink(&shard, it);
+            ++shard.stats.expirations;
+            ++shard.stats.misses;
+            return nullptr;
+        }
+        ++shard.stats.hits;
+        Touch(&shard, it);
+        return it->value;
+    }
+
+    // adds or replaces the entry of key
+    void Put(const Key &key, Value value) {
+        Put(key, std::make_shared<const Value>(std::move(value)));
+    }
+    void Put(const Key &key, ValuePtr value) {
+        uint64_t hash = hash_(key);
+        size_t bytes = weigher_(key, *value);
+        int64_t expire_at = options_.ttl_ms > 0 ? Now() + options_.ttl_ms : 0;
+        Shard &shard = ShardFor(hash);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        ++shard.stats.puts;
+        if (shard.sketch) shard.sketch->Increment(hash);
+        auto found = shard.index.find(key);
+        if (found != shard.index.end()) {
+            auto it = found->second;
+            Usage &usage = shard.usage[static_cast<int>(it->region)];
+            usage.bytes = usage.bytes - it->bytes + bytes;
+            it->value = std::move(value);
+            it->bytes = bytes;
+            it->expire_at = expire_at;
+            Touch(&shard, it);
+        } else {
+            Region region = shard.sketch ? Region::kWindow : Region::kProbation;
+            List &list = shard.lists[static_cast<int>(region)];
+            list.push_front(Entry{key, std::move(value), hash, bytes, expire_at, region});
+            shard.index.emplace(key, list.begin());
+            Usage &usage = shard.usage[static_cast<int>(region)];
+            ++usage.entries;
+            usage.bytes += bytes;
+        }
+        if (shard.sketch) {
+            EvictTinyLfu(&shard);
+        } else {
+            EvictLru(&shard);
+        }
+    }
+
+    // the cached value, else load(key) is stored and returned. concurrent misses of one
+    // key may each call load
+    template <typename Load>
+    ValuePtr GetOrLoad(const Key &key, Load &&load) {
+        ValuePtr value = Get(key);
+        if (value == nullptr) {
+            value = std::make_shared<const Value>(load(key));
+            Put(key, value);
+        }
+        return value;
+    }
+
+    bool Erase(const Key &key) {
+        Shard &shard = ShardFor(hash_(key));
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto found = shard.index.find(key);
+        if (found == shard.index.end()) return false;
+        Unlink(&shard, found->second);
+        return true;
+    }
+
+    void Clear() {
+        for (auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->index.clear();
+            for (int i = 0; i < kRegions; ++i) {
+                shard->lists[i].clear();
+                shard->usage[i] = {};
+            }
+        }
+    }
+
+    // summed over the shards, each read under its lock
+    CacheStats Stats() const {
+        CacheStats total;
+        for (auto &shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total.hits += shard->stats.hits;
+            total.misses += shard->stats.misses;
+            total.puts += shard->stats.puts;
+            total.evictions += shard->stats.evictions;
+            total.expirations += shard->stats.expirations;
+            total.entries += shard->index.size();
+            for (int i = 0; i < kRegions; ++i) {
+                total.bytes += shard->usage[i].bytes;
+            }
+        }
+        return total;
+    }
+
+    size_t Size() const { return Stats().entries; }
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(ShardedCache);
+
+    // an LRU cache keeps everything in kProbation
+    enum class Region : int { kWindow, kProbation, kProtected };
+    static constexpr int kRegions = 3;
+
+    struct Entry {
+        Key key;
+        ValuePtr value;
+        uint64_t hash;
+        size_t bytes;
+        int64_t expire_at;
+        Region region;
+    };
+    using List = std::list<Entry>;
+    using Iterator = typename List::iterator;
+
+    struct Usage {
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+    // 0 is unbounded
+    struct Limit {
+        size_t entries = 0;
+        size_t bytes = 0;
+        bool Exceeded(const Usage &usage) const {
+            return (entries > 0 && usage.entries > entries) ||
+                   (bytes > 0 && usage.bytes > bytes);
+        }
+    };
+
+    struct alignas(concurrent::kCacheLineSize) Shard {
+        mutable std::mutex mutex;
+        absl::flat_hash_map<Key, Iterator> index;
+        // most recent first
+        List lists[kRegions];
+        Usage usage[kRegions];
+        std::unique_ptr<FrequencySketch> sketch;
+        CacheStats stats;
+    };
+
+    static size_t Share(size_t total, size_t parts) {
+        return total == 0 ? 0 : std::max<size_t>(total / parts, 1);
+    }
+
+    int64_t Now() const { return time::CoarseClock::Get().MonotonicMillis(); }
+    bool Expired(const Entry &entry) const {
+        return entry.expire_at > 0 && Now() >= entry.expire_at;
+    }
+
+    Shard &ShardFor(uint64_t hash) { return *shards_[hash & mask_]; }
+
+    void Unlink(Shard *shard, Iterator it) {
+        Usage &usage = shard->usage[static_cast<int>(it->region)];
+        --usage.entries;
+        usage.bytes -= it->bytes;
+        shard->index.erase(it->key);
+        shard->lists[static_cast<int>(it->region)].erase(it);
+    }
+
+    void Move(Shard *shard, Iterator it, Region region, bool front = true) {
+        int from = static_cast<int>(it->region);
+        int to = static_cast<int>(region);
+        --shard->usage[from].entries;
+        shard->usage[from].bytes -= it->bytes;
+        ++shard->usage[to].entries;
+        shard->usage[to].bytes += it->bytes;
+        List &list = shard->lists[to];
+        list.splice(front ? list.begin() : list.end(), shard->lists[from], it);
+        it->region = region;
+    }
+
+    Usage MainUsage(const Shard &shard) const {
+        const Usage &probation = shard.usage[static_cast<int>(Region::kProbation)];
+        const Usage &hot = shard.usage[static_cast<int>(Region::kProtected)];
+        return {probation.entries + hot.entries, probation.bytes + hot.bytes};
+    }
+
+    void Touch(Shard *shard, Iterator it) {
+        if (it->region == Region::kProbation && shard->sketch) {
+            // a second hit in the main part, promote and demote the protected overflow
+            Move(shard, it, Region::kProtected);
+            List &hot = shard->lists[static_cast<int>(Region::kProtected)];
+            while (protected_.Exceeded(shard->usage[static_cast<int>(Region::kProtected)]) &&
+                   hot.size() > 1) {
+                Move(shard, std::prev(hot.end()), Region::kProbation);
+            }
+        } else {
+            Move(shard, it, it->region);
+        }
+    }
+
+    void EvictLru(Shard *shard) {
+        List &list = shard->lists[static_cast<int>(Region::kProbation)];
+        while (total_.Exceeded(shard->usage[static_cast<int>(Region::kProbation)]) &&
+               !list.empty()) {
+            Unlink(shard, std::prev(list.end()));
+            ++shard->stats.evictions;
+        }
+    }
+
+    void EvictTinyLfu(Shard *shard) {
+        List &window = shard->lists[static_cast<int>(Region::kWindow)];
+        while (window_.Exceeded(shard->usage[static_cast<int>(Region::kWindow)]) &&
+               !window.empty()) {
+            Iterator candidate = std::prev(window.end());
+            Move(shard, candidate, Region::kProbation);
+            Admit(shard, candidate);
+        }
+        // an entry of the main part that grew on Put
+        List &probation = shard->lists[static_cast<int>(Region::kProbation)];
+        List &hot = shard->lists[static_cast<int>(Region::kProtected)];
+        while (main_.Exceeded(MainUsage(*shard))) {
+            Unlink(shard, std::prev(probation.empty() ? hot.end() : probation.end()));
+            ++shard->stats.evictions;
+        }
+    }
+
+    // candidate just entered probation, it competes with the oldest main entries until
+    // the main part fits again
+    void Admit(Shard *shard, Iterator candidate) {
+        List &probation = shard->lists[static_cast<int>(Region::kProbation)];
+        List &hot = shard->lists[static_cast<int>(Region::kProtected)];
+        while (main_.Exceeded(MainUsage(*shard))) {
+            if (probation.size() == 1 && !hot.empty()) {
+                // only the candidate is on probation, the oldest protected entry is next
+                Move(shard, std::prev(hot.end()), Region::kProbation, false);
+                continue;
+            }
+            Iterator victim = std::prev(probation.end());
+            ++shard->stats.evictions;
+            if (victim == candidate || shard->sketch->Estimate(candidate->hash) <=
+                                           shard->sketch->Estimate(victim->hash)) {
+                Unlink(shard, candidate);
+                return;
+            }
+            Unlink(shard, victim);
+        }
+    }
+
+    CacheOptions options_;
+    Weigher weigher_;
+    Hash hash_;
+    size_t mask_;
+    Limit total_;
+    Limit window_;
+    Limit main_;
+    Limit protected_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace cache
+}  // namespace alpheratz
@@ -1,12 +1,17 @@
 #pragma once
 // @author all3n
 // this file used for get environment value from system
+#include <absl/types/optional.h>
+
 #include <string>
-#include <string_view>
 namespace alpheratz {
 namespace common {
 namespace env {
-std::string_view GetEnv(const std::string &key, const std::string &def);
+// value of key or def, returned by value: a view could dangle into a temporary def
+// or into the environment after setenv
+std::string GetEnv(const std::string &key, const std::string &def);
+// value of key, nullopt when unset
+absl::optional<std::string> LookupEnv(const std::string &key);
 
 }  // namespace env
 }  // namespace common
@@ -0,0 +1,27 @@
+#pragma once
+// @author all3n
+// native GBK / GB18030 to UTF-8 decoder
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+
+#include <string>
+
+namespace alpheratz {
+namespace common {
+namespace locale {
+
+enum class GbkCharset { kGbk, kGb18030 };
+
+/**
+ * same output and accepted input as iconv from the charset to UTF-8. ascii runs are
+ * copied 16 bytes at a time, one and two byte codes go through tables filled from
+ * iconv on first use of the charset; GB18030 four byte codes and anything the tables
+ * do not cover are handed to iconv. out is replaced, on error it holds the text
+ * decoded before the bad bytes
+ */
+absl::Status GbkToUtf8(absl::string_view in, std::string* out,
+                       GbkCharset charset = GbkCharset::kGbk);
+
+}  // namespace locale
+}  // namespace common
+}  // namespace alpheratz
@@ -1,11 +1,76 @@
 #pragma once
+#include <absl/status/status.h>
+#include <absl/status/statusor.h>
+#include <absl/strings/string_view.h>
+#include <alpheratz/io/unique_handle.h>
+#include <iconv.h>
+
+#include <cstddef>
 #include <string>
+#include <utility>
 
 namespace alpheratz {
 namespace common {
 namespace locale {
 int ConvertGbk2Utf8(const std::string& gbk_content, std::string& out);
 
+struct IconvTraits {
+    using value_type = iconv_t;
+    static iconv_t Invalid() { return reinterpret_cast<iconv_t>(-1); }
+    static bool IsValid(iconv_t cd) { return cd != Invalid(); }
+    static void Close(iconv_t cd) { iconv_close(cd); }
+};
+using UniqueIconv = io::UniqueHandle<IconvTraits>;
+
+/**
+ * iconv conversion between any encoding pair, e.g. Transcoder::Create("UTF-8", "GBK").
+ * iconv_t handles come from a per-thread pool and go back to it on destruction, so
+ * creating a Transcoder per call costs no iconv_open once the pool is warm.
+ * input may arrive in chunks: a multibyte sequence cut at the end of a chunk is held
+ * back and completed by the next Update. one object must not be used concurrently.
+ */
+class Transcoder {
+   public:
+    static absl::StatusOr<Transcoder> Create(absl::string_view to, absl::string_view from);
+
+    Transcoder(Transcoder&& other) noexcept;
+    Transcoder& operator=(Transcoder&& other) noexcept;
+    ~Transcoder();
+
+    // convert into out[0, capacity). stops when chunk is used up or out is full, the
+    // caller then passes chunk.substr(*consumed) again. a cut sequence at the end of
+    // chunk counts as consumed. an invalid sequence returns InvalidArgument with
+    // *consumed at its first byte
+    absl::Status Update(absl::string_view chunk, char* out, size_t capacity, size_t* consumed,
+                        size_t* written);
+    // append the whole chunk converted to out
+    absl::Status Update(absl::string_view chunk, std::string* out);
+    // end of input: flush shift state, InvalidArgument if a sequence is still cut.
+    // the transcoder is reset and can start a new stream
+    absl::Status Finish(std::string* out);
+    // drop held bytes and shift state
+    void Reset();
+
+    // one shot Reset, Update, Finish; out is replaced
+    absl::Status Convert(absl::string_view in, std::string* out);
+
+    size_t Pending() const { return pending_size_; }
+
+   private:
+    // longest sequence iconv may leave incomplete, GB18030 and UTF-8 need 4
+    static constexpr size_t kMaxPending = 8;
+
+    Transcoder(std::string key, UniqueIconv cd) : key_(std::move(key)), cd_(std::move(cd)) {}
+
+    absl::Status UpdatePending(absl::string_view chunk, char** out, size_t* out_left,
+                               size_t* consumed);
+
+    std::string key_;
+    UniqueIconv cd_;
+    char pending_[kMaxPending];
+    size_t pending_size_{0};
+};
+
 }  // namespace locale
 }  // namespace common
 }  // namespace alpheratz
@@ -1,6 +1,12 @@
 #pragma once
 #include <absl/status/status.h>
 #include <absl/status/statusor.h>
+#include <absl/strings/string_view.h>
+#include <alpheratz/string/string_map.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
 namespace alpheratz {
 namespace common {
 class ResourceLoader {
@@ -10,11 +16,12 @@ class ResourceLoader {
         return instance;
     }
     absl::Status Load(absl::string_view path);
-    absl::StatusOr<std::vector<uint8_t>*> GetResource(const std::string& path);
+    absl::StatusOr<std::vector<uint8_t>*> GetResource(absl::string_view path);
 
    private:
     ResourceLoader() {}
-    std::unordered_map<std::string, std::vector<uint8_t>> resource_map_;
+    // boxed so the pointers GetResource hands out survive the table growing
+    string::StringMap<std::unique_ptr<std::vector<uint8_t>>> resource_map_;
 };
 
 }  // namespace common
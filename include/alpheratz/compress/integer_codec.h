@@ -0,0 +1,84 @@
+#pragma once
+// @author all3n
+// varint, zigzag, stream vbyte and frame of reference codecs for integer arrays
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alpheratz {
+namespace compress {
+
+// little endian whatever the host
+inline void PutFixed32(std::string *out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out->push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+inline void PutFixed64(std::string *out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out->push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+inline uint32_t GetFixed32(const char *p) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = value << 8 | static_cast<unsigned char>(p[i]);
+    }
+    return value;
+}
+
+inline uint64_t GetFixed64(const char *p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = value << 8 | static_cast<unsigned char>(p[i]);
+    }
+    return value;
+}
+
+// small magnitudes of either sign to small unsigned values: 0, -1, 1, -2 ... to 0, 1, 2, 3
+inline uint64_t ZigZagEncode(int64_t value) {
+    return static_cast<uint64_t>(value) << 1 ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t ZigZagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1 ^ (~(value & 1) + 1));
+}
+
+// leb128, 7 bits a byte low first, 1 to 10 bytes
+size_t VarintLength(uint64_t value);
+void PutVarint(std::string *out, uint64_t value);
+// advances *p past the varint, false on a truncated or overlong one
+bool GetVarint(const char **p, const char *end, uint64_t *value);
+
+/**
+ * the codecs below write a self contained block that the matching Get reads back from
+ * *p, advancing it. Get returns false on damaged input and never reads past end.
+ *
+ * stream vbyte keeps each value in 1 to 4 bytes and all the 2 bit lengths up front, four
+ * to a control byte, so decoding 4 values is a table lookup and one byte shuffle with
+ * ssse3 instead of a branch per byte. with delta the differences between neighbours are
+ * stored and decoding adds them back 4 at a time, which suits sorted ids; any sequence
+ * round trips, unsorted ones just compress worse
+ */
+void PutStreamVByte(std::string *out, const uint32_t *values, size_t count, bool delta = false);
+bool GetStreamVByte(const char **p, const char *end, std::vector<uint32_t> *values,
+                    bool delta = false);
+
+/**
+ * frame of reference: per block of 128 values the minimum and, bit packed, each value
+ * minus it in as many bits as the largest needs. a block of near values costs a few bits
+ * a value whatever their magnitude, equal ones none at all
+ */
+void PutFrameOfReference(std::string *out, const int64_t *values, size_t count);
+bool GetFrameOfReference(const char **p, const char *end, std::vector<int64_t> *values);
+
+// the first value and the frame of reference of the differences, for timestamps and
+// other columns that move in small steps. arithmetic wraps, so every input round trips
+void PutDeltaColumn(std::string *out, const int64_t *values, size_t count);
+bool GetDeltaColumn(const char **p, const char *end, std::vector<int64_t> *values);
+
+}  // namespace compress
+}  // namespace alpheratz
@@ -1,11 +1,33 @@
 #pragma once
 
 #include <absl/status/status.h>
+#include <alpheratz/io/unique_handle.h>
+#include <zstd.h>
+
+#include <cstdint>
+#include <vector>
 namespace alpheratz {
 namespace compress {
 
 absl::Status CompressZstd(std::vector<uint8_t> &in, std::vector<uint8_t> &out);
 absl::Status UnCompressZstd(std::vector<uint8_t> &in, std::vector<uint8_t> &out);
 
+struct ZstdCCtxTraits {
+    using value_type = ZSTD_CCtx *;
+    static constexpr ZSTD_CCtx *Invalid() { return nullptr; }
+    static constexpr bool IsValid(ZSTD_CCtx *cctx) { return cctx != nullptr; }
+    static void Close(ZSTD_CCtx *cctx) { ZSTD_freeCCtx(cctx); }
+};
+
+struct ZstdDCtxTraits {
+    using value_type = ZSTD_DCtx *;
+    static constexpr ZSTD_DCtx *Invalid() { return nullptr; }
+    static constexpr bool IsValid(ZSTD_DCtx *dctx) { return dctx != nullptr; }
+    static void Close(ZSTD_DCtx *dctx) { ZSTD_freeDCtx(dctx); }
+};
+
+using UniqueZstdCCtx = io::UniqueHandle<ZstdCCtxTraits>;
+using UniqueZstdDCtx = io::UniqueHandle<ZstdDCtxTraits>;
+
 }  // namespace compress
 }  // namespace alpheratz
@@ -0,0 +1,120 @@
+#pragma once
+// @author all3n
+// blocking and closing on top of a lock-free queue
+#include <alpheratz/concurrent/event_count.h>
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace alpheratz {
+namespace concurrent {
+
+/**
+ * Derived provides the non-blocking RawPush(T &&), RawPop(T *), RawPushBatch(T *, count)
+ * and RawPopBatch(T *, max), which move an element only when it got a slot. this adds
+ * the public operations: every successful one wakes the threads parked on the other
+ * side, so Try and blocking calls can be mixed freely. Close ends the stream, blocked
+ * producers give up and consumers drain what is left
+ */
+template <typename Derived, typename T>
+class BlockingQueue {
+   public:
+    bool TryPush(T value) {
+        if (!Self()->RawPush(std::move(value))) return false;
+        not_empty_.NotifyAll();
+        return true;
+    }
+    bool TryPop(T *out) {
+        if (!Self()->RawPop(out)) return false;
+        not_full_.NotifyAll();
+        return true;
+    }
+    // moves a prefix of values in, returns its length
+    size_t TryPushBatch(T *values, size_t count) {
+        size_t pushed = Self()->RawPushBatch(values, count);
+        if (pushed > 0) not_empty_.NotifyAll();
+        return pushed;
+    }
+    size_t TryPopBatch(T *out, size_t max) {
+        size_t popped = Self()->RawPopBatch(out, max);
+        if (popped > 0) not_full_.NotifyAll();
+        return popped;
+    }
+
+    // waits for room, false when the queue is closed
+    bool Push(T value) {
+        bool pushed = false;
+        SpinThenPark(&not_full_, [&]() {
+            if (Closed()) return true;
+            pushed = Self()->RawPush(std::move(value));
+            return pushed;
+        });
+        if (pushed) not_empty_.NotifyAll();
+        return pushed;
+    }
+    // waits for an element, false when the queue is closed and drained
+    bool Pop(T *out) {
+        bool popped = false;
+        SpinThenPark(&not_empty_, [&]() {
+            if (Self()->RawPop(out)) return popped = true;
+            if (!Closed()) return false;
+            // pushes before Close are visible after seeing it
+            popped = Self()->RawPop(out);
+            return true;
+        });
+        if (popped) not_full_.NotifyAll();
+        return popped;
+    }
+    // pushes all of values, fewer only when the queue is closed
+    size_t PushBatch(T *values, size_t count) {
+        size_t pushed = 0;
+        while (pushed < count) {
+            size_t n = 0;
+            bool closed = false;
+            SpinThenPark(&not_full_, [&]() {
+                closed = Closed();
+                if (closed) return true;
+                n = Self()->RawPushBatch(values + pushed, count - pushed);
+                return n > 0;
+            });
+            if (closed) break;
+            pushed += n;
+            not_empty_.NotifyAll();
+        }
+        return pushed;
+    }
+    // waits for at least one element, 0 when the queue is closed and drained
+    size_t PopBatch(T *out, size_t max) {
+        size_t popped = 0;
+        SpinThenPark(&not_empty_, [&]() {
+            popped = Self()->RawPopBatch(out, max);
+            if (popped > 0 || !Closed()) return popped > 0;
+            popped = Self()->RawPopBatch(out, max);
+            return true;
+        });
+        if (popped > 0) not_full_.NotifyAll();
+        return popped;
+    }
+
+    void Close() {
+        closed_.store(true, std::memory_order_release);
+        not_full_.NotifyAll();
+        not_empty_.NotifyAll();
+    }
+    bool Closed() const { return closed_.load(std::memory_order_acquire); }
+
+   protected:
+    BlockingQueue() = default;
+    ~BlockingQueue() = default;
+
+   private:
+    Derived *Self() { return static_cast<Derived *>(this); }
+
+    alignas(kCacheLineSize) EventCount not_empty_;
+    alignas(kCacheLineSize) EventCount not_full_;
+    std::atomic<bool> closed_{false};
+};
+
+}  // namespace concurrent
+}  // namespace alpheratz
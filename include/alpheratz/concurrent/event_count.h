@@ -0,0 +1,88 @@
+#pragma once
+// @author all3n
+// spin then futex park for threads waiting on a lock-free structure
+#include <alpheratz/common/macro.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace alpheratz {
+namespace concurrent {
+
+// keeps the indexes of producers and consumers from sharing a line
+constexpr size_t kCacheLineSize = 64;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * lets a thread sleep until a condition it polls may have changed, without a mutex on
+ * the fast path. a waiter registers with PrepareWait, checks its condition once more and
+ * either cancels or sleeps in Wait; whoever changes the condition calls NotifyAll, which
+ * is a fence and a load while nobody waits. sleeping is a futex on linux and a short
+ * sleep loop elsewhere
+ */
+class EventCount {
+   public:
+    EventCount() = default;
+
+    uint32_t PrepareWait() {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        // the caller's recheck must not move above the registration
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return epoch_.load(std::memory_order_acquire);
+    }
+    void CancelWait() { waiters_.fetch_sub(1, std::memory_order_relaxed); }
+    // sleeps until a NotifyAll after the PrepareWait that returned key
+    void Wait(uint32_t key);
+
+    void NotifyAll() {
+        // orders the caller's change before reading waiters_, pairs with PrepareWait
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) > 0) {
+            Wake();
+        }
+    }
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(EventCount);
+
+    void Wake();
+
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> waiters_{0};
+};
+
+// calls attempt until it returns true: spins, then yields, then parks on event
+template <typename Attempt>
+void SpinThenPark(EventCount *event, Attempt &&attempt) {
+    constexpr int kSpins = 128;
+    constexpr int kYields = 16;
+    for (int i = 0; i < kSpins; ++i) {
+        if (attempt()) return;
+        CpuRelax();
+    }
+    for (int i = 0; i < kYields; ++i) {
+        if (attempt()) return;
+        std::this_thread::yield();
+    }
+    while (true) {
+        uint32_t key = event->PrepareWait();
+        if (attempt()) {
+            event->CancelWait();
+            return;
+        }
+        event->Wait(key);
+        if (attempt()) return;
+    }
+}
+
+}  // namespace concurrent
+}  // namespace alpheratz
@@ -0,0 +1,127 @@
+#pragma once
+// @author all3n
+// bounded multi producer multi consumer queue after Dmitry Vyukov
+#include <alpheratz/common/macro.h>
+#include <alpheratz/concurrent/blocking_queue.h>
+#include <alpheratz/concurrent/event_count.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace alpheratz {
+namespace concurrent {
+
+/**
+ * every cell carries a sequence number telling which lap of the ring may use it next:
+ * a producer at position p owns the cell once its sequence is p, a consumer once it is
+ * p + 1. claiming a position is one CAS on the shared index and the element itself is
+ * handed over through the cell, so producers and consumers never share a lock. batch
+ * calls claim a run of ready cells with a single CAS
+ */
+template <typename T>
+class MpmcQueue : public BlockingQueue<MpmcQueue<T>, T> {
+   public:
+    // rounded up to a power of two, at least 2
+    explicit MpmcQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask_ = size - 1;
+        cells_.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    ~MpmcQueue() {
+        size_t end = enqueue_.load(std::memory_order_relaxed);
+        for (size_t pos = dequeue_.load(std::memory_order_relaxed); pos != end; ++pos) {
+            cells_[pos & mask_].Get()->~T();
+        }
+    }
+
+    size_t Capacity() const { return mask_ + 1; }
+    // a racy estimate
+    size_t Size() const {
+        size_t tail = enqueue_.load(std::memory_order_acquire);
+        size_t head = dequeue_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+   private:
+    friend class BlockingQueue<MpmcQueue<T>, T>;
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(MpmcQueue);
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        T *Get() { return reinterpret_cast<T *>(&storage); }
+    };
+
+    // claims up to max cells from index whose sequence is position + lap, returns the
+    // first claimed position and sets claimed, 0 claimed when the ring is full / empty
+    size_t Claim(std::atomic<size_t> *index, size_t lap, size_t max, size_t *claimed) {
+        size_t pos = index->load(std::memory_order_relaxed);
+        while (true) {
+            size_t n = 0;
+            while (n < max &&
+                   cells_[(pos + n) & mask_].sequence.load(std::memory_order_acquire) ==
+                       pos + n + lap) {
+                ++n;
+            }
+            if (n == 0) {
+                size_t seq = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(seq - (pos + lap)) < 0) {
+                    // the cell is a lap behind: full for producers, empty for consumers
+                    *claimed = 0;
+                    return pos;
+                }
+                // another thread took pos
+                pos = index->load(std::memory_order_relaxed);
+                continue;
+            }
+            if (index->compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                *claimed = n;
+                return pos;
+            }
+        }
+    }
+
+    bool RawPush(T &&value) { return RawPushBatch(&value, 1) == 1; }
+    size_t RawPushBatch(T *values, size_t count) {
+        if (count == 0) return 0;
+        size_t n;
+        size_t pos = Claim(&enqueue_, 0, count, &n);
+        for (size_t i = 0; i < n; ++i) {
+            Cell &cell = cells_[(pos + i) & mask_];
+            new (cell.Get()) T(std::move(values[i]));
+            cell.sequence.store(pos + i + 1, std::memory_order_release);
+        }
+        return n;
+    }
+    bool RawPop(T *out) { return RawPopBatch(out, 1) == 1; }
+    size_t RawPopBatch(T *out, size_t max) {
+        if (max == 0) return 0;
+        size_t n;
+        size_t pos = Claim(&dequeue_, 1, max, &n);
+        for (size_t i = 0; i < n; ++i) {
+            Cell &cell = cells_[(pos + i) & mask_];
+            out[i] = std::move(*cell.Get());
+            cell.Get()->~T();
+            // free for the producer one lap later
+            cell.sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+        }
+        return n;
+    }
+
+    size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(kCacheLineSize) std::atomic<size_t> enqueue_{0};
+    alignas(kCacheLineSize) std::atomic<size_t> dequeue_{0};
+};
+
+}  // namespace concurrent
+}  // namespace alpheratz
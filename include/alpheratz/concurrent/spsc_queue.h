@@ -0,0 +1,122 @@
+#pragma once
+// @author all3n
+// bounded single producer single consumer ring
+#include <alpheratz/common/macro.h>
+#include <alpheratz/concurrent/blocking_queue.h>
+#include <alpheratz/concurrent/event_count.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace alpheratz {
+namespace concurrent {
+
+/**
+ * exactly one thread pushes and one thread pops. each side keeps a cached copy of the
+ * other side's index and only reads the shared one when the cache says full or empty,
+ * so in steady state a push or pop touches no line the other thread writes
+ */
+template <typename T>
+class SpscQueue : public BlockingQueue<SpscQueue<T>, T> {
+   public:
+    // rounded up to a power of two
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        mask_ = size - 1;
+        slots_.reset(new Slot[size]);
+    }
+    ~SpscQueue() {
+        for (size_t i = head_.load(std::memory_order_relaxed);
+             i != tail_.load(std::memory_order_relaxed); ++i) {
+            At(i)->~T();
+        }
+    }
+
+    size_t Capacity() const { return mask_ + 1; }
+    // exact only from the producer or the consumer thread
+    size_t Size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+   private:
+    friend class BlockingQueue<SpscQueue<T>, T>;
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(SpscQueue);
+
+    using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    T *At(size_t index) const { return reinterpret_cast<T *>(&slots_[index & mask_]); }
+
+    // producer: room for up to want elements, reloads head only when the cache is short
+    size_t Room(size_t tail, size_t want) {
+        size_t room = Capacity() - (tail - head_cache_);
+        if (room < want) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            room = Capacity() - (tail - head_cache_);
+        }
+        return room;
+    }
+    // consumer: elements ready, up to want
+    size_t Ready(size_t head, size_t want) {
+        size_t ready = tail_cache_ - head;
+        if (ready < want) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            ready = tail_cache_ - head;
+        }
+        return ready;
+    }
+
+    bool RawPush(T &&value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (Room(tail, 1) == 0) return false;
+        new (At(tail)) T(std::move(value));
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    size_t RawPushBatch(T *values, size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t n = std::min(count, Room(tail, count));
+        for (size_t i = 0; i < n; ++i) {
+            new (At(tail + i)) T(std::move(values[i]));
+        }
+        if (n > 0) tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+    bool RawPop(T *out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (Ready(head, 1) == 0) return false;
+        T *slot = At(head);
+        *out = std::move(*slot);
+        slot->~T();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    size_t RawPopBatch(T *out, size_t max) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t n = std::min(max, Ready(head, max));
+        for (size_t i = 0; i < n; ++i) {
+            T *slot = At(head + i);
+            out[i] = std::move(*slot);
+            slot->~T();
+        }
+        if (n > 0) head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    // producer side
+    alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+    size_t head_cache_{0};
+    // consumer side
+    alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+    size_t tail_cache_{0};
+};
+
+}  // namespace concurrent
+}  // namespace alpheratz
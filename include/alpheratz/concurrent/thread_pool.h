@@ -0,0 +1,186 @@
+#pragma once
+// @author all3n
+// work stealing thread pool, the shared executor of the library
+#include <alpheratz/common/macro.h>
+#include <alpheratz/concurrent/work_stealing_deque.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace alpheratz {
+namespace concurrent {
+
+struct ThreadPoolOptions {
+    // 0 uses std::thread::hardware_concurrency
+    size_t threads = 0;
+    // pin worker i to cpus[i % cpus.size()]
+    std::vector<int> cpus;
+    // when cpus is empty and this is set, workers may run on any cpu of that numa node
+    int numa_node = -1;
+    // workers are named "<name>-<index>", cut to the 15 chars linux keeps
+    std::string name = "alpheratz";
+};
+
+/**
+ * every worker owns a Chase-Lev deque. tasks submitted from a worker go to its own
+ * deque and run newest first, which keeps recursive work cache warm; tasks from other
+ * threads go to a shared queue. an idle worker pops its deque, then the shared queue,
+ * then steals the oldest task of another worker, and parks when all are empty.
+ * ParallelFor and ParallelReduce let the calling thread work too, and while it waits it
+ * runs other tasks instead of blocking, so nested parallel calls from inside tasks do
+ * not deadlock the pool
+ */
+class ThreadPool {
+   public:
+    // pool shared by the library, sized to the machine
+    static ThreadPool &Get();
+
+    explicit ThreadPool(const ThreadPoolOptions &options = {});
+    // runs the tasks still queued, then joins the workers
+    ~ThreadPool();
+
+    size_t Size() const { return workers_.size(); }
+    // index of the calling worker of this pool, -1 on other threads
+    int CurrentWorker() const;
+
+    // fire and forget, an exception thrown by task terminates
+    void Execute(std::function<void()> task);
+
+    template <typename F, typename... Args>
+    auto Submit(F &&f, Args &&...args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using Result = std::invoke_result_t<F, Args...>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        std::future<Result> future = task->get_future();
+        Execute([task]() { (*task)(); });
+        return future;
+    }
+
+    // fn(i) for every i in [begin, end), at least grain indexes per task. returns when
+    // all are done, the first exception thrown by fn is rethrown here
+    template <typename Fn>
+    void ParallelFor(size_t begin, size_t end, Fn &&fn, size_t grain = 1) {
+        ForChunks(begin, end, grain, [&fn](size_t, size_t chunk_begin, size_t chunk_end) {
+            for (size_t i = chunk_begin; i < chunk_end; ++i) {
+                fn(i);
+            }
+        });
+    }
+
+    // combine(...combine(combine(init, map(b0, e0)), map(b1, e1))..., map(bn, en)) over
+    // consecutive chunks of [begin, end), combined in order so combine only needs to be
+    // associative
+    template <typename T, typename Map, typename Combine>
+    T ParallelReduce(size_t begin, size_t end, T init, Map &&map, Combine &&combine,
+                     size_t grain = 1) {
+        std::vector<T> partials(ChunkCount(begin, end, grain), init);
+        ForChunks(begin, end, grain,
+                  [&partials, &map](size_t chunk, size_t chunk_begin, size_t chunk_end) {
+                      partials[chunk] = map(chunk_begin, chunk_end);
+                  });
+        T result = std::move(init);
+        for (auto &partial : partials) {
+            result = combine(std::move(result), std::move(partial));
+        }
+        return result;
+    }
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+
+    using Task = std::function<void()>;
+
+    struct Worker {
+        WorkStealingDeque<Task *> deque;
+        std::thread thread;
+    };
+
+    // chunks per worker, small enough to balance uneven work
+    static constexpr size_t kChunksPerWorker = 4;
+
+    size_t ChunkCount(size_t begin, size_t end, size_t grain) const {
+        if (end <= begin) return 0;
+        grain = std::max<size_t>(grain, 1);
+        return std::min((end - begin + grain - 1) / grain, Size() * kChunksPerWorker);
+    }
+
+    // body(chunk, chunk_begin, chunk_end) over ChunkCount chunks of about equal size
+    template <typename Body>
+    void ForChunks(size_t begin, size_t end, size_t grain, const Body &body) {
+        size_t chunks = ChunkCount(begin, end, grain);
+        if (chunks == 0) return;
+        size_t n = end - begin;
+        struct State {
+            std::atomic<size_t> next{0};
+            std::atomic<size_t> running{0};
+            std::mutex mutex;
+            std::exception_ptr error;
+        } state;
+        auto drain = [&]() {
+            size_t chunk;
+            while ((chunk = state.next.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+                try {
+                    body(chunk, begin + n * chunk / chunks, begin + n * (chunk + 1) / chunks);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(state.mutex);
+                    if (!state.error) state.error = std::current_exception();
+                }
+            }
+        };
+        size_t helpers = std::min(chunks - 1, Size());
+        state.running.store(helpers, std::memory_order_relaxed);
+        for (size_t i = 0; i < helpers; ++i) {
+            Execute([&]() {
+                drain();
+                state.running.fetch_sub(1, std::memory_order_release);
+            });
+        }
+        drain();
+        // helpers may still sit in a queue, run tasks until all of them finished
+        while (state.running.load(std::memory_order_acquire) > 0) {
+            if (!RunOne(CurrentWorker())) {
+                std::this_thread::yield();
+            }
+        }
+        if (state.error) {
+            std::rethrow_exception(state.error);
+        }
+    }
+
+    void Schedule(Task *task);
+    // run one task from the deque of self, the shared queue or a victim
+    bool RunOne(int self);
+    Task *Take(int self);
+    void Run(size_t index);
+    void Pin(size_t index, const ThreadPoolOptions &options);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    std::mutex shared_mutex_;
+    std::deque<Task *> shared_;
+    std::atomic<size_t> shared_size_{0};
+
+    // parking: producers bump epoch_ and wake a sleeper if there is one
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+    std::atomic<uint64_t> epoch_{0};
+    std::atomic<int> sleepers_{0};
+    std::atomic<bool> stop_{false};
+};
+
+}  // namespace concurrent
+}  // namespace alpheratz
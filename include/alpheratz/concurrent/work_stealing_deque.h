@@ -0,0 +1,129 @@
+#pragma once
+// @author all3n
+// Chase-Lev work stealing deque
+#include <alpheratz/common/macro.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace alpheratz {
+namespace concurrent {
+
+/**
+ * one owner thread pushes and pops at the bottom, any thread steals from the top.
+ * follows Le, Pop, Cohen and Nardelli, "Correct and Efficient Work-Stealing for Weak
+ * Memory Models", with seq_cst operations in place of the fences so race detectors
+ * follow it. the ring grows on demand, retired rings live until the deque is destroyed
+ * because a thief may still read from one
+ */
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "elements are copied as atomics");
+
+   public:
+    explicit WorkStealingDeque(size_t capacity = 256) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        rings_.emplace_back(new Ring(size));
+        ring_.store(rings_.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner only
+    void Push(T value) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        Ring *ring = ring_.load(std::memory_order_relaxed);
+        if (bottom - top >= ring->Capacity()) {
+            ring = Grow(ring, top, bottom);
+        }
+        ring->Put(bottom, value);
+        bottom_.store(bottom + 1, std::memory_order_release);
+    }
+
+    // owner only, newest first
+    bool Pop(T *out) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring *ring = ring_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_seq_cst);
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        *out = ring->Get(bottom);
+        if (top == bottom) {
+            // last element, race the thieves for it
+            bool won = top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                    std::memory_order_relaxed);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // any thread, oldest first. false when empty or another thread won the element
+    bool Steal(T *out) {
+        int64_t top = top_.load(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_seq_cst);
+        if (top >= bottom) {
+            return false;
+        }
+        T value = ring_.load(std::memory_order_acquire)->Get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return false;
+        }
+        *out = value;
+        return true;
+    }
+
+    // a racy estimate, exact only when no other thread touches the deque
+    size_t Size() const {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        return bottom > top ? static_cast<size_t>(bottom - top) : 0;
+    }
+    bool Empty() const { return Size() == 0; }
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+
+    class Ring {
+       public:
+        explicit Ring(size_t capacity)
+            : mask_(static_cast<int64_t>(capacity) - 1), slots_(new std::atomic<T>[capacity]) {}
+        int64_t Capacity() const { return mask_ + 1; }
+        T Get(int64_t index) const { return slots_[index & mask_].load(std::memory_order_relaxed); }
+        void Put(int64_t index, T value) {
+            slots_[index & mask_].store(value, std::memory_order_relaxed);
+        }
+
+       private:
+        int64_t mask_;
+        std::unique_ptr<std::atomic<T>[]> slots_;
+    };
+
+    Ring *Grow(Ring *ring, int64_t top, int64_t bottom) {
+        Ring *bigger = new Ring(static_cast<size_t>(ring->Capacity()) * 2);
+        for (int64_t i = top; i < bottom; ++i) {
+            bigger->Put(i, ring->Get(i));
+        }
+        rings_.emplace_back(bigger);
+        ring_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    // top and bottom on their own cache lines, thieves hammer top
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    alignas(64) std::atomic<Ring *> ring_{nullptr};
+    // owner only
+    std::vector<std::unique_ptr<Ring>> rings_;
+};
+
+}  // namespace concurrent
+}  // namespace alpheratz
@@ -0,0 +1,78 @@
+#pragma once
+// @author all3n
+// publication of immutable values, readers hold what they loaded
+#include <alpheratz/common/macro.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace alpheratz {
+namespace conf {
+
+/**
+ * holds the current version of an immutable value.
+ * Load() returns a reference to the current value, it stays alive for as long as the
+ * caller holds it however many values are published meanwhile. every thread caches the
+ * last value it loaded next to its version number: a load that finds the version
+ * unchanged is an atomic read and a reference count increment, only the first load
+ * after a Publish takes the mutex. the price is that a thread keeps the value it loaded
+ * last alive until its next load of a newer one, or until it exits
+ */
+template <typename T>
+class AtomicSnapshot {
+   public:
+    AtomicSnapshot() : id_(NextId()) {}
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(AtomicSnapshot);
+
+    // nullptr before the first Publish
+    std::shared_ptr<const T> Load() const {
+        uint64_t version = version_.load(std::memory_order_acquire);
+        Cached &cached = Slot();
+        if (cached.owner != id_ || cached.version != version) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cached.owner = id_;
+            cached.version = version_.load(std::memory_order_relaxed);
+            cached.value = current_;
+        }
+        return cached.value;
+    }
+
+    // returns the replaced value
+    std::shared_ptr<const T> Publish(std::shared_ptr<const T> value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_.swap(value);
+        version_.fetch_add(1, std::memory_order_release);
+        return value;
+    }
+
+   private:
+    struct Cached {
+        // id of the AtomicSnapshot the value came from, ids are never reused
+        uint64_t owner = 0;
+        uint64_t version = 0;
+        std::shared_ptr<const T> value;
+    };
+    // cache entries per thread, snapshots whose ids collide just load under the mutex
+    static constexpr size_t kSlots = 4;
+
+    static uint64_t NextId() {
+        static std::atomic<uint64_t> next{1};
+        return next.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Cached &Slot() const {
+        thread_local Cached slots[kSlots];
+        return slots[id_ % kSlots];
+    }
+
+    const uint64_t id_;
+    mutable std::mutex mutex_;
+    std::atomic<uint64_t> version_{0};
+    std::shared_ptr<const T> current_;
+};
+
+}  // namespace conf
+}  // namespace alpheratz
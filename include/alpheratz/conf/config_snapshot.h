@@ -0,0 +1,151 @@
+#pragma once
+// @author all3n
+// immutable flat config table: path -> typed value, for hot path reads
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/string_view.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace alpheratz {
+namespace conf {
+
+using ConfigScalar = std::variant<std::monostate, bool, int64_t, double, std::string>;
+using ConfigArray = std::vector<ConfigScalar>;
+// std::monostate means the key exists but holds no value (yaml null)
+using ConfigValue = std::variant<std::monostate, bool, int64_t, double, std::string, ConfigArray>;
+
+// type plain text (ini value, env var) as int, double in plain decimal or exponent form,
+// bool (true/false) or string
+ConfigValue ParseConfigText(absl::string_view text);
+
+/**
+ * resolved key of a ConfigSnapshot, get it once by ConfigSnapshot::Find
+ * and read by index without hashing or allocation
+ */
+class ConfigHandle {
+   public:
+    ConfigHandle() = default;
+    bool IsValid() const { return index_ != kInvalidIndex; }
+    uint32_t Index() const { return index_; }
+
+   private:
+    friend class ConfigSnapshot;
+    friend class LayeredConfig;
+    static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+    explicit ConfigHandle(uint32_t index) : index_(index) {}
+    uint32_t index_{kInvalidIndex};
+};
+
+/**
+ * compiled, immutable view of a config tree.
+ * nested keys are joined by '.', sequence items by their index: "group.list.0.name"
+ */
+class ConfigSnapshot {
+   public:
+    class Builder {
+       public:
+        // set value of path, a later Set of the same path overrides the former one
+        Builder &Set(absl::string_view path, ConfigValue value);
+        // reserve path with no value, keeps its index stable
+        uint32_t Reserve(absl::string_view path);
+        size_t Size() const { return paths_.size(); }
+        std::shared_ptr<const ConfigSnapshot> Build(uint64_t version = 0);
+
+       private:
+        std::vector<std::string> paths_;
+        std::vector<ConfigValue> values_;
+        absl::flat_hash_map<std::string, uint32_t> index_;
+    };
+
+    ConfigHandle Find(absl::string_view path) const {
+        auto it = index_.find(path);
+        if (it == index_.end()) {
+            return ConfigHandle();
+        }
+        return ConfigHandle(it->second);
+    }
+
+    // key is present and holds a value
+    bool Has(ConfigHandle handle) const {
+        return handle.index_ < values_.size() &&
+               !std::holds_alternative<std::monostate>(values_[handle.index_]);
+    }
+
+    const ConfigValue &Value(ConfigHandle handle) const {
+        if (handle.index_ >= values_.size()) {
+            return EmptyValue();
+        }
+        return values_[handle.index_];
+    }
+
+    // exact type access, nullptr when missing or of another type
+    template <typename T>
+    const T *GetIf(ConfigHandle handle) const {
+        return std::get_if<T>(&Value(handle));
+    }
+
+    // typed read with numeric coercion (int <-> double, int -> bool)
+    template <typename T>
+    T Get(ConfigHandle handle, T def = T()) const {
+        return Convert<T>(Value(handle), std::move(def));
+    }
+
+    template <typename T>
+    T Get(absl::string_view path, T def = T()) const {
+        return Get<T>(Find(path), std::move(def));
+    }
+
+    // string read without copy, the view lives as long as the snapshot
+    absl::string_view GetString(ConfigHandle handle, absl::string_view def = "") const {
+        const std::string *value = GetIf<std::string>(handle);
+        return value == nullptr ? def : absl::string_view(*value);
+    }
+
+    size_t Size() const { return values_.size(); }
+    const std::string &PathAt(size_t index) const { return paths_[index]; }
+    const ConfigValue &ValueAt(size_t index) const { return values_[index]; }
+    uint64_t Version() const { return version_; }
+
+    // paths added, removed or changed from before to after, before may be nullptr
+    static std::vector<std::string> ChangedPaths(const ConfigSnapshot *before,
+                                                 const ConfigSnapshot &after);
+
+   private:
+    ConfigSnapshot() = default;
+
+    static const ConfigValue &EmptyValue() {
+        static const ConfigValue empty;
+        return empty;
+    }
+
+    template <typename T>
+    static T Convert(const ConfigValue &value, T def) {
+        if constexpr (std::is_same_v<T, bool>) {
+            if (auto v = std::get_if<bool>(&value)) return *v;
+            if (auto v = std::get_if<int64_t>(&value)) return *v != 0;
+            return def;
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            if (auto v = std::get_if<int64_t>(&value)) return static_cast<T>(*v);
+            if (auto v = std::get_if<double>(&value)) return static_cast<T>(*v);
+            if (auto v = std::get_if<bool>(&value)) return static_cast<T>(*v);
+            return def;
+        } else {
+            if (auto v = std::get_if<T>(&value)) return *v;
+            return def;
+        }
+    }
+
+    uint64_t version_{0};
+    std::vector<std::string> paths_;
+    std::vector<ConfigValue> values_;
+    absl::flat_hash_map<std::string, uint32_t> index_;
+};
+
+}  // namespace conf
+}  // namespace alpheratz
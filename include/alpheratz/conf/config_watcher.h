@@ -0,0 +1,62 @@
+#pragma once
+// @author all3n
+// watch config files by inotify and run reload callbacks on a background thread
+#include <absl/status/status.h>
+#include <absl/status/statusor.h>
+#include <absl/strings/string_view.h>
+#include <alpheratz/common/macro.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace alpheratz {
+namespace conf {
+
+class ConfigWatcher {
+   public:
+    using Callback = std::function<void()>;
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(ConfigWatcher);
+
+    static ConfigWatcher& Get() {
+        static ConfigWatcher instance;
+        return instance;
+    }
+    ~ConfigWatcher();
+
+    /**
+     * call callback after filename is rewritten or replaced by rename,
+     * the parent directory is watched so atomic "write tmp + mv" updates are seen.
+     * return token for Unwatch
+     */
+    absl::StatusOr<uint64_t> Watch(absl::string_view filename, Callback callback);
+    // after return the callback of token is not running and will not be called again
+    void Unwatch(uint64_t token);
+
+   private:
+    struct WatchEntry {
+        int wd;
+        std::string name;
+        Callback callback;
+    };
+
+    ConfigWatcher() {}
+    absl::Status Start();
+    void Run();
+
+    int inotify_fd_{-1};
+    int wake_fd_{-1};
+    uint64_t next_token_{0};
+    std::mutex mutex_;
+    // held while callbacks run, so Unwatch can wait for a running one
+    std::mutex callback_mutex_;
+    std::map<uint64_t, WatchEntry> watches_;
+    std::map<int, int> wd_refs_;
+    std::thread thread_;
+};
+
+}  // namespace conf
+}  // namespace alpheratz
@@ -1,10 +1,20 @@
 #pragma once
+#include <absl/container/flat_hash_map.h>
+
 #include <cassert>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <iterator>
+#include <limits>
 #include <list>
-#include <map>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 /**
  * <pre>
@@ -108,6 +118,19 @@ class XiniNodeT {
         return std::string("");
     }
 
+    /**********************************************************/
+    /**
+     * @brief 修剪字符串视图前后端的字符集（不产生拷贝）。
+     */
+    static std::string_view TrimXview(std::string_view xstr, const char *xchars = kXcharsTrim) {
+        std::string_view::size_type st_pos = xstr.find_first_not_of(xchars);
+        if (std::string_view::npos != st_pos) {
+            return xstr.substr(st_pos, xstr.find_last_not_of(xchars) - st_pos + 1);
+        }
+
+        return std::string_view();
+    }
+
     /**********************************************************/
     /**
      * @brief 修剪字符串前端的字符集。
@@ -175,6 +198,32 @@ class XiniNodeT {
         }
     };
 
+    /**
+     * @struct XstrIhashT
+     * @brief  忽略大小写的字符串哈希（FNV-1a），用于 节点映射表。
+     */
+    struct XstrIhashT {
+        size_t operator()(const std::string &xstr) const {
+            uint64_t xu64_hash = 14695981039346656037ULL;
+            for (char xchar : xstr) {
+                if ((xchar >= 'A') && (xchar <= 'Z')) xchar -= ('A' - 'a');
+                xu64_hash = (xu64_hash ^ static_cast<unsigned char>(xchar)) * 1099511628211ULL;
+            }
+            return static_cast<size_t>(xu64_hash);
+        }
+    };
+
+    /**
+     * @struct XstrIeqT
+     * @brief  忽略大小写的字符串相等比较。
+     */
+    struct XstrIeqT {
+        bool operator()(const std::string &xstr_left, const std::string &xstr_right) const {
+            return (xstr_left.size() == xstr_right.size()) &&
+                   (0 == XstrIcmp(xstr_left.c_str(), xstr_right.c_str()));
+        }
+    };
+
     // constructor/destructor
 
     XiniNodeT(int xini_ntype, XiniNodeT *xowner_ptr)
@@ -276,8 +325,8 @@ class XiniNillineT : public XiniNodeT {
      *  操作成功，返回的 空行节点；若失败，则返回 nullptr 。
      */
     static XiniNodeT *try_create(const std::string &xstr_line, XiniNodeT *xowner_ptr) {
-        assert(is_xtrim(xstr_line));
-        assert(is_sline(xstr_line));
+        assert(IsXtrim(xstr_line));
+        assert(IsSline(xstr_line));
 
         if (!xstr_line.empty()) {
             return nullptr;
@@ -331,8 +380,8 @@ class XiniCommentT : public XiniNodeT {
      *  操作成功，返回的 注释节点；若失败，则返回 nullptr 。
      */
     static XiniNodeT *try_create(const std::string &xstr_line, XiniNodeT *xowner_ptr) {
-        assert(is_xtrim(xstr_line));
-        assert(is_sline(xstr_line));
+        assert(IsXtrim(xstr_line));
+        assert(IsSline(xstr_line));
 
         if (xstr_line.empty() || ((';' != xstr_line.at(0)) && ('#' != xstr_line.at(0)))) {
             return nullptr;
@@ -391,7 +440,7 @@ class XiniKeyvalueT : public XiniNodeT {
      *  待检查的 键名，其已经被 trim_xstr() 修剪过前后端的空白字符。
      */
     static bool CheckKname(const std::string &xstr_name) {
-        assert(is_xtrim(xstr_name));
+        assert(IsXtrim(xstr_name));
 
         if (xstr_name.empty()) {
             return false;
@@ -421,8 +470,8 @@ class XiniKeyvalueT : public XiniNodeT {
      *  操作成功，返回的 键值节点；若失败，则返回 nullptr 。
      */
     static XiniNodeT *try_create(const std::string &xstr_line, XiniNodeT *xowner_ptr) {
-        assert(is_xtrim(xstr_line));
-        assert(is_sline(xstr_line));
+        assert(IsXtrim(xstr_line));
+        assert(IsSline(xstr_line));
 
         if (xstr_line.empty()) {
             return nullptr;
@@ -445,7 +494,7 @@ class XiniKeyvalueT : public XiniNodeT {
         auto *xnode_ptr = new XiniKeyvalueT(xowner_ptr);
 
         xnode_ptr->m_xstr_kname = xstr_kname;
-        xnode_ptr->m_xstr_value = TrimXstr(xstr_line.substr(st_eq + 1));
+        xnode_ptr->AssignValue(TrimXstr(xstr_line.substr(st_eq + 1)));
 
         //======================================
 
@@ -470,6 +519,36 @@ class XiniKeyvalueT : public XiniNodeT {
 
     // template<> functions, for operators
    protected:
+    /**********************************************************/
+    /**
+     * @brief 从 解析缓存 读取数值（与 istream >> 的规则一致：只解析数值前缀，
+     *        超出 NumberType 范围时失败）。
+     *
+     * @return 键值 是否可以转换为 NumberType 。
+     */
+    template <typename NumberType>
+    bool ReadNumb(NumberType &numb) const {
+        if constexpr (std::is_floating_point_v<NumberType>) {
+            if (0 == (m_xcache_flags & kXcacheFloat)) return false;
+            if (std::fabs(m_xcache_ldbl) > std::numeric_limits<NumberType>::max()) return false;
+            numb = static_cast<NumberType>(m_xcache_ldbl);
+        } else if constexpr (std::is_signed_v<NumberType>) {
+            if (0 == (m_xcache_flags & kXcacheSigned)) return false;
+            if ((m_xcache_sll < std::numeric_limits<NumberType>::min()) ||
+                (m_xcache_sll > std::numeric_limits<NumberType>::max()))
+                return false;
+            numb = static_cast<NumberType>(m_xcache_sll);
+        } else {
+            if (0 == (m_xcache_flags & kXcacheUnsigned)) return false;
+            if (m_xcache_ull > std::numeric_limits<NumberType>::max()) return false;
+            // 与 istream 一致，负数按无符号类型回绕
+            numb = static_cast<NumberType>(m_xcache_ull);
+            if (0 != (m_xcache_flags & kXcacheNegative))
+                numb = static_cast<NumberType>(NumberType(0) - numb);
+        }
+        return true;
+    }
+
     /**********************************************************/
     /**
      * @brief 数值的读操作。
@@ -477,9 +556,7 @@ class XiniKeyvalueT : public XiniNodeT {
     template <typename NumberType>
     NumberType GetNumb() const {
         NumberType numb;
-        std::istringstream istr(m_xstr_value);
-        istr >> numb;
-        if (istr.fail()) return static_cast<NumberType>(0);
+        if (!ReadNumb(numb)) return static_cast<NumberType>(0);
         return numb;
     }
 
@@ -489,12 +566,8 @@ class XiniKeyvalueT : public XiniNodeT {
      */
     template <typename NumberType>
     NumberType GetNumb(NumberType x_default) const {
-        if (Empty()) return x_default;
-
         NumberType numb;
-        std::istringstream istr(m_xstr_value);
-        istr >> numb;
-        if (istr.fail()) return x_default;
+        if (!ReadNumb(numb)) return x_default;
         return numb;
     }
 
@@ -504,10 +577,15 @@ class XiniKeyvalueT : public XiniNodeT {
      */
     template <typename NumberType>
     void SetNumb(NumberType x_value) {
-        std::ostringstream ostr;
-        ostr << x_value;
-        assert(!ostr.fail());
-        InvkSetValue(ostr.str());
+        if constexpr (std::is_floating_point_v<NumberType>) {
+            // 与 ostream 的默认精度一致
+            SetNumb(x_value, 6);
+        } else {
+            char xbuf[32];
+            std::to_chars_result xret = std::to_chars(xbuf, xbuf + sizeof(xbuf), x_value);
+            assert(std::errc() == xret.ec);
+            InvkSetValue(std::string(xbuf, xret.ptr));
+        }
     }
 
     /**********************************************************/
@@ -516,11 +594,22 @@ class XiniKeyvalueT : public XiniNodeT {
      */
     template <typename NumberType>
     void SetNumb(NumberType x_value, std::streamsize x_precision) {
-        std::ostringstream ostr;
-        ostr.precision(x_precision);
-        ostr << x_value;
-        assert(!ostr.fail());
-        InvkSetValue(ostr.str());
+        if constexpr (std::is_floating_point_v<NumberType>) {
+            char xbuf[64];
+#if defined(__cpp_lib_to_chars)
+            std::to_chars_result xret = std::to_chars(xbuf, xbuf + sizeof(xbuf), x_value,
+                                                      std::chars_format::general,
+                                                      static_cast<int>(x_precision));
+            assert(std::errc() == xret.ec);
+            InvkSetValue(std::string(xbuf, xret.ptr));
+#else
+            int xit_len = std::snprintf(xbuf, sizeof(xbuf), "%.*Lg", static_cast<int>(x_precision),
+                                        static_cast<long double>(x_value));
+            InvkSetValue(std::string(xbuf, static_cast<size_t>(xit_len)));
+#endif
+        } else {
+            SetNumb(x_value);
+        }
     }
 
     /**********************************************************/
@@ -529,15 +618,8 @@ class XiniKeyvalueT : public XiniNodeT {
      */
     template <typename NumberType>
     NumberType TryNumb(NumberType x_default) {
-        if (Empty()) {
-            SetNumb(x_default);
-            return x_default;
-        }
-
         NumberType numb;
-        std::istringstream istr(m_xstr_value);
-        istr >> numb;
-        if (istr.fail()) {
+        if (!ReadNumb(numb)) {
             SetNumb(x_default);
             return x_default;
         }
@@ -551,15 +633,8 @@ class XiniKeyvalueT : public XiniNodeT {
      */
     template <typename NumberType>
     NumberType TryNumb(NumberType x_default, std::streamsize x_precision) {
-        if (Empty()) {
-            SetNumb(x_default, x_precision);
-            return x_default;
-        }
-
         NumberType numb;
-        std::istringstream istr(m_xstr_value);
-        istr >> numb;
-        if (istr.fail()) {
+        if (!ReadNumb(numb)) {
             SetNumb(x_default, x_precision);
             return x_default;
         }
@@ -575,21 +650,14 @@ class XiniKeyvalueT : public XiniNodeT {
         //======================================
         // 按 字符串 解析
 
-        if (Empty()) {
-            InvkSetValue(std::string(x_default ? "true" : "false"));
-            return x_default;
-        }
-
-        if (0 == XstrIcmp(m_xstr_value.c_str(), "true")) return true;
-        if (0 == XstrIcmp(m_xstr_value.c_str(), "false")) return false;
+        if (0 != (m_xcache_flags & kXcacheTrue)) return true;
+        if (0 != (m_xcache_flags & kXcacheFalse)) return false;
 
         //======================================
         // 按 整数值 解析
 
         long numb;
-        std::istringstream istr(m_xstr_value);
-        istr >> numb;
-        if (istr.fail()) {
+        if (!ReadNumb(numb)) {
             InvkSetValue(std::string(x_default ? "true" : "false"));
             return x_default;
         }
@@ -608,8 +676,8 @@ class XiniKeyvalueT : public XiniNodeT {
     operator const char *() const { return m_xstr_value.c_str(); }
 
     operator bool() const {
-        if (0 == XstrIcmp(m_xstr_value.c_str(), "true")) return true;
-        if (0 == XstrIcmp(m_xstr_value.c_str(), "false")) return false;
+        if (0 != (m_xcache_flags & kXcacheTrue)) return true;
+        if (0 != (m_xcache_flags & kXcacheFalse)) return false;
         return (0L != GetNumb<long>());
     }
 
@@ -634,8 +702,8 @@ class XiniKeyvalueT : public XiniNodeT {
     }
 
     bool operator()(bool x_default) const {
-        if (0 == XstrIcmp(m_xstr_value.c_str(), "true")) return true;
-        if (0 == XstrIcmp(m_xstr_value.c_str(), "false")) return false;
+        if (0 != (m_xcache_flags & kXcacheTrue)) return true;
+        if (0 != (m_xcache_flags & kXcacheFalse)) return false;
         return (0 != GetNumb<int>(x_default ? 1 : 0));
     }
 
@@ -812,13 +880,75 @@ class XiniKeyvalueT : public XiniNodeT {
      */
     void InvkSetValue(const std::string &xstr_value) {
         if (xstr_value != m_xstr_value) {
-            m_xstr_value = xstr_value;
+            AssignValue(xstr_value);
             SetDirty(true);
         }
     }
 
-    std::string m_xstr_kname;  ///< 键名
-    std::string m_xstr_value;  ///< 键值
+    /**********************************************************/
+    /**
+     * @brief 写入键值，并同步更新 解析缓存，读操作不再重复解析字符串。
+     */
+    void AssignValue(std::string xstr_value) {
+        m_xstr_value = std::move(xstr_value);
+        m_xcache_flags = 0;
+
+        const char *xsz_first = m_xstr_value.data();
+        const char *xsz_last = xsz_first + m_xstr_value.size();
+        if (xsz_first == xsz_last) return;
+
+        if (0 == XstrIcmp(xsz_first, "true")) m_xcache_flags |= kXcacheTrue;
+        if (0 == XstrIcmp(xsz_first, "false")) m_xcache_flags |= kXcacheFalse;
+
+        // from_chars 不接受前导 '+'，istream 接受
+        if ('+' == *xsz_first) ++xsz_first;
+        const char *xsz_digit = xsz_first;
+        if ((xsz_digit < xsz_last) && ('-' == *xsz_digit) && (xsz_first == m_xstr_value.data())) {
+            ++xsz_digit;
+        }
+        if (xsz_digit == xsz_last) return;
+
+        if ((*xsz_digit >= '0') && (*xsz_digit <= '9')) {
+            if (std::errc() == std::from_chars(xsz_first, xsz_last, m_xcache_sll).ec) {
+                m_xcache_flags |= kXcacheSigned;
+            }
+            if (std::errc() == std::from_chars(xsz_digit, xsz_last, m_xcache_ull).ec) {
+                m_xcache_flags |= kXcacheUnsigned;
+                if (xsz_digit != xsz_first) m_xcache_flags |= kXcacheNegative;
+            }
+        }
+
+        if (((*xsz_digit >= '0') && (*xsz_digit <= '9')) || ('.' == *xsz_digit)) {
+#if defined(__cpp_lib_to_chars)
+            if (std::errc() == std::from_chars(xsz_first, xsz_last, m_xcache_ldbl).ec) {
+                m_xcache_flags |= kXcacheFloat;
+            }
+#else
+            char *xsz_end = nullptr;
+            m_xcache_ldbl = std::strtold(xsz_first, &xsz_end);
+            if ((xsz_end != xsz_first) && std::isfinite(m_xcache_ldbl)) {
+                m_xcache_flags |= kXcacheFloat;
+            }
+#endif
+        }
+    }
+
+    /** 解析缓存 的标识位 */
+    enum : uint8_t {
+        kXcacheSigned = 0x01,    ///< m_xcache_sll 有效
+        kXcacheUnsigned = 0x02,  ///< m_xcache_ull 有效
+        kXcacheNegative = 0x04,  ///< m_xcache_ull 为负数的绝对值
+        kXcacheFloat = 0x08,     ///< m_xcache_ldbl 有效
+        kXcacheTrue = 0x10,      ///< 键值为 "true"（忽略大小写）
+        kXcacheFalse = 0x20,     ///< 键值为 "false"（忽略大小写）
+    };
+
+    std::string m_xstr_kname;          ///< 键名
+    std::string m_xstr_value;          ///< 键值
+    uint8_t m_xcache_flags = 0;        ///< 解析缓存 的标识位
+    long long m_xcache_sll = 0;        ///< 有符号整数 解析缓存
+    unsigned long long m_xcache_ull = 0;  ///< 无符号整数 解析缓存
+    long double m_xcache_ldbl = 0;     ///< 浮点数 解析缓存
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -835,7 +965,7 @@ class XiniSectionT : public XiniNodeT {
     // common data types
    protected:
     typedef std::list<XiniNodeT *> xlst_node_t;
-    typedef std::map<std::string, XiniKeyvalueT *, XstrIcmpT> xmap_ndkv_t;
+    typedef absl::flat_hash_map<std::string, XiniKeyvalueT *, XstrIhashT, XstrIeqT> xmap_ndkv_t;
 
    public:
     typedef xlst_node_t::iterator iterator;
@@ -860,7 +990,7 @@ class XiniSectionT : public XiniNodeT {
      *  trim_sname() 修剪过前后端多余的字符。
      */
     static inline bool check_sname(const std::string &xstr_name) {
-        assert(is_xtrim(xstr_name));
+        assert(IsXtrim(xstr_name));
         return IsSline(xstr_name);
     }
 
@@ -869,8 +999,8 @@ class XiniSectionT : public XiniNodeT {
      * @brief 尝试使用字符串直接创建并初始化 xini_section_t 对象。
      */
     static XiniNodeT *try_create(const std::string &xstr_line, XiniNodeT *xowner_ptr) {
-        assert(is_xtrim(xstr_line));
-        assert(is_sline(xstr_line));
+        assert(IsXtrim(xstr_line));
+        assert(IsSline(xstr_line));
 
         //======================================
 
@@ -946,7 +1076,7 @@ class XiniSectionT : public XiniNodeT {
      * @note  该接口仅由 xini_keyvalue_t::set_key() 调用。
      */
     virtual bool RenameNsub(XiniNodeT *xnsub_ptr, const std::string &xstr_name) {
-        assert(XINI_NTYPE_KEYVALUE == xnsub_ptr->ntype());
+        assert(kXiniNtypeKeyvalue == xnsub_ptr->Ntype());
 
         return rename_knode(static_cast<XiniKeyvalueT *>(xnsub_ptr), xstr_name);
     }
@@ -961,7 +1091,7 @@ class XiniSectionT : public XiniNodeT {
         //======================================
 
         std::string xstr_nkey = TrimXstr(xstr_key);
-        assert(xini_keyvalue_t::check_kname(xstr_nkey));
+        assert(XiniKeyvalueT::CheckKname(xstr_nkey));
 
         //======================================
 
@@ -1350,7 +1480,8 @@ class XiniFileT : public XiniNodeT {
     // common data types
    protected:
     typedef std::list<XiniSectionT *> xlst_section_t;
-    typedef std::map<std::string, XiniSectionT *, XstrIcmpT> xmap_section_t;
+    typedef absl::flat_hash_map<std::string, XiniSectionT *, XstrIhashT, XstrIeqT>
+        xmap_section_t;
 
    public:
     typedef xlst_section_t::iterator iterator;
@@ -1360,24 +1491,49 @@ class XiniFileT : public XiniNodeT {
    protected:
     /**********************************************************/
     /**
-     * @brief 依据给定的 INI 文本行，创建相应的节点。
+     * @brief 依据给定的 INI 文本行（已修剪前后端空白字符），创建相应的节点。
+     * @note  按行首字符一次判定节点类型，与 各节点类 try_create() 的判定规则一致，
+     *        但不再逐个类型试探创建，也不产生中间字符串。
      */
-    static XiniNodeT *make_node(const std::string &xstr_line, XiniFileT *xowner_ptr) {
-        XiniNodeT *xnode_ptr = nullptr;
+    static XiniNodeT *make_node(std::string_view xstr_line, XiniFileT *xowner_ptr) {
+        // 空行
+        if (xstr_line.empty()) {
+            return new XiniNillineT(xowner_ptr);
+        }
+
+        // 注释
+        if ((';' == xstr_line[0]) || ('#' == xstr_line[0])) {
+            auto *xnode_ptr = new XiniCommentT(xowner_ptr);
+            xnode_ptr->m_xstr_text_.assign(xstr_line.data(), xstr_line.size());
+            return xnode_ptr;
+        }
 
-#define XTRY_CREATE(nptr, node, owner)             \
-    do {                                           \
-        nptr = node::try_create(xstr_line, owner); \
-        if (nullptr != nptr) return nptr;          \
-    } while (0)
+        // 分节（无 ']' 结尾时，继续按 键值 解析）
+        if ('[' == xstr_line[0]) {
+            std::string_view::size_type st_pos = xstr_line.find(']', 1);
+            if (std::string_view::npos != st_pos) {
+                auto *xnode_ptr = new XiniSectionT(xowner_ptr);
+                xnode_ptr->m_xstr_name = std::string(TrimXview(xstr_line.substr(1, st_pos - 1)));
+                // 自身节点作为占位行，参看 XiniSectionT::try_create()
+                xnode_ptr->m_xlst_node.push_back(xnode_ptr);
+                return xnode_ptr;
+            }
+        }
 
-        XTRY_CREATE(xnode_ptr, XiniNillineT, xowner_ptr);
-        XTRY_CREATE(xnode_ptr, XiniCommentT, xowner_ptr);
-        XTRY_CREATE(xnode_ptr, XiniSectionT, xowner_ptr);
-        XTRY_CREATE(xnode_ptr, XiniKeyvalueT, xowner_ptr);
+        // 键值
+        std::string_view::size_type st_eq = xstr_line.find('=');
+        if ((0 == st_eq) || (std::string_view::npos == st_eq)) {
+            return nullptr;
+        }
 
-#undef XTRY_CREATE
+        std::string xstr_kname(TrimXview(xstr_line.substr(0, st_eq)));
+        if (!XiniKeyvalueT::CheckKname(xstr_kname)) {
+            return nullptr;
+        }
 
+        auto *xnode_ptr = new XiniKeyvalueT(xowner_ptr);
+        xnode_ptr->m_xstr_kname = std::move(xstr_kname);
+        xnode_ptr->AssignValue(std::string(TrimXview(xstr_line.substr(st_eq + 1))));
         return xnode_ptr;
     }
 
@@ -1431,7 +1587,7 @@ class XiniFileT : public XiniNodeT {
      * @note  该接口仅由 xini_section_t::set_name() 调用。
      */
     bool RenameNsub(XiniNodeT *xnsub_ptr, const std::string &xstr_name) override {
-        assert(XINI_NTYPE_SECTION == xnsub_ptr->ntype());
+        assert(kXiniNtypeSection == xnsub_ptr->Ntype());
 
         return RenameSect(static_cast<XiniSectionT *>(xnsub_ptr), xstr_name);
     }
@@ -1443,6 +1599,16 @@ class XiniFileT : public XiniNodeT {
      * @brief 从 输出流 构建 xini_file_t 内容。
      */
     XiniFileT &operator<<(std::istream &istr) {
+        std::string xstr_text((std::istreambuf_iterator<char>(istr)),
+                              std::istreambuf_iterator<char>());
+        return Parse(xstr_text);
+    }
+
+    /**********************************************************/
+    /**
+     * @brief 从 文本缓存 构建 xini_file_t 内容（单遍扫描，逐行只判定一次节点类型）。
+     */
+    XiniFileT &Parse(std::string_view xstr_text) {
         //======================================
 
         // 记录当前操作的分节
@@ -1453,7 +1619,7 @@ class XiniFileT : public XiniNodeT {
             xsect_ptr = new XiniSectionT(this);
             m_xlst_sect_.push_back(xsect_ptr);
 
-            assert(m_xmap_sect.empty());
+            assert(m_xmap_sect_.empty());
             m_xmap_sect_.insert(std::make_pair(std::string(""), xsect_ptr));
         } else {
             // 取尾部分节作为当前操作的 分节 节点
@@ -1467,17 +1633,21 @@ class XiniFileT : public XiniNodeT {
 
         //======================================
 
-        // 逐行解析 INI 文件，构建节点表
-        while (!istr.eof()) {
+        // 逐行解析 INI 文本，构建节点表
+        std::string_view::size_type st_pos = 0;
+        while (st_pos < xstr_text.size()) {
             //======================================
-            // 读取文本行
+            // 截取文本行
+
+            std::string_view::size_type st_end = xstr_text.find('\n', st_pos);
+            bool xbt_last = (std::string_view::npos == st_end);
+            if (xbt_last) st_end = xstr_text.size();
 
-            std::string xstr_line;
-            std::getline(istr, xstr_line);
-            xstr_line = TrimXstr(xstr_line);
+            std::string_view xstr_line = TrimXview(xstr_text.substr(st_pos, st_end - st_pos));
+            st_pos = st_end + 1;
 
             // 最后一个空行不放到节点表中，避免文件关闭时 持续增加 尾部空行
-            if (istr.eof() && xstr_line.empty()) {
+            if (xbt_last && xstr_line.empty()) {
                 break;
             }
 
@@ -1526,7 +1696,7 @@ class XiniFileT : public XiniNodeT {
         //======================================
 
         std::string xstr_name = XiniSectionT::trim_sname(xstr_sect);
-        assert(xini_section_t::check_sname(xstr_name));
+        assert(XiniSectionT::check_sname(xstr_name));
 
         //======================================
 
@@ -1579,24 +1749,35 @@ class XiniFileT : public XiniNodeT {
             return false;
         }
 
-        // 打开文件
-        std::ifstream xfile_reader(xstr_filepath.c_str());
+        // 打开文件，一次读入整个文件内容
+        std::ifstream xfile_reader(xstr_filepath.c_str(), std::ios_base::binary);
         if (!xfile_reader.is_open()) {
             return false;
         }
 
+        xfile_reader.seekg(0, std::ios_base::end);
+        std::streamoff xst_size = xfile_reader.tellg();
+        xfile_reader.seekg(0, std::ios_base::beg);
+
+        std::string xstr_text;
+        if (xst_size > 0) {
+            xstr_text.resize(static_cast<size_t>(xst_size));
+            xfile_reader.read(&xstr_text[0], xst_size);
+            xstr_text.resize(static_cast<size_t>(xfile_reader.gcount()));
+        }
+
         // 跳过字符流的头部编码信息（如 utf-8 的 bom 标识）
-        while (!xfile_reader.eof()) {
-            int xchar = xfile_reader.get();
+        size_t xst_head = 0;
+        while (xst_head < xstr_text.size()) {
+            int xchar = static_cast<unsigned char>(xstr_text[xst_head]);
             if (std::iscntrl(xchar) || std::isprint(xchar)) {
-                xfile_reader.putback(static_cast<char>(xchar));
                 break;
             }
-
-            m_xstr_head_.push_back(static_cast<char>(xchar));
+            ++xst_head;
         }
+        m_xstr_head_.assign(xstr_text, 0, xst_head);
 
-        *this << xfile_reader;
+        Parse(std::string_view(xstr_text).substr(xst_head));
         SetDirty(false);
 
         return true;
@@ -0,0 +1,22 @@
+#pragma once
+// @author all3n
+// compile XiniFileT content to ConfigSnapshot, keys are "section.key"
+#include <absl/status/statusor.h>
+#include <alpheratz/conf/config_snapshot.h>
+#include <alpheratz/conf/ini_conf.h>
+
+#include <memory>
+#include <string>
+
+namespace alpheratz {
+namespace conf {
+
+// values are typed by ParseConfigText, keys of the unnamed
+// leading section have no section prefix
+std::shared_ptr<const ConfigSnapshot> CompileIni(const XiniFileT &ini, uint64_t version = 0);
+// parser for ReloadableConfig
+absl::StatusOr<std::shared_ptr<const ConfigSnapshot>> LoadIniSnapshot(const std::string &path,
+                                                                      uint64_t version);
+
+}  // namespace conf
+}  // namespace alpheratz
@@ -0,0 +1,88 @@
+#pragma once
+// @author all3n
+// one flat config table over defaults, config files and environment
+#include <absl/container/flat_hash_map.h>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include <alpheratz/common/macro.h>
+#include <alpheratz/conf/atomic_snapshot.h>
+#include <alpheratz/conf/config_snapshot.h>
+#include <alpheratz/conf/reloadable_config.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace alpheratz {
+namespace conf {
+
+/**
+ * precedence: env > files (the later added wins) > defaults.
+ * Build() merges every layer into one ConfigSnapshot whose index of a key is its
+ * interned id, so a handle from Handle() stays valid across rebuilds and reads
+ * are a single array access. Version() changes on each Build, cache derived
+ * values by it.
+ */
+class LayeredConfig {
+   public:
+    using Source = std::function<std::shared_ptr<const ConfigSnapshot>()>;
+
+    LayeredConfig() = default;
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(LayeredConfig);
+
+    void SetDefault(absl::string_view key, ConfigValue value);
+    // fixed file layer, e.g. YamlConfig::Get().Snapshot()
+    void AddFile(std::shared_ptr<const ConfigSnapshot> snapshot);
+    // live file layer, its latest snapshot is read on every Build;
+    // config must outlive this object
+    void AddFile(const ReloadableConfig &config);
+    // env name of key "server.port" is prefix + "SERVER_PORT"
+    void SetEnvPrefix(absl::string_view prefix);
+    void BindEnv(absl::string_view key, absl::string_view env_name);
+
+    // intern key, a key unknown to all layers reads as missing
+    ConfigHandle Handle(absl::string_view key);
+
+    // merge all layers and publish a new version
+    absl::Status Build();
+
+    // nullptr before the first Build, valid while held, see AtomicSnapshot::Load. the
+    // getters below load it on every call, hold one for a batch of reads
+    std::shared_ptr<const ConfigSnapshot> Snapshot() const { return snapshot_.Load(); }
+    uint64_t Version() const {
+        auto current = Snapshot();
+        return current == nullptr ? 0 : current->Version();
+    }
+
+    template <typename T>
+    T Get(ConfigHandle handle, T def = T()) const {
+        auto current = Snapshot();
+        return current == nullptr ? def : current->Get<T>(handle, std::move(def));
+    }
+    // a copy, the snapshot may be replaced once this returns. for a view hold Snapshot()
+    std::string GetString(ConfigHandle handle, absl::string_view def = "") const {
+        auto current = Snapshot();
+        return std::string(current == nullptr ? def : current->GetString(handle, def));
+    }
+
+   private:
+    uint32_t Intern(absl::string_view key);
+    std::string EnvName(const std::string &key) const;
+
+    std::mutex mutex_;
+    std::vector<std::string> keys_;
+    absl::flat_hash_map<std::string, uint32_t> ids_;
+    std::vector<std::pair<uint32_t, ConfigValue>> defaults_;
+    std::vector<Source> files_;
+    std::string env_prefix_;
+    bool env_prefix_set_{false};
+    std::vector<std::pair<uint32_t, std::string>> env_bindings_;
+    uint64_t version_{0};
+    AtomicSnapshot<ConfigSnapshot> snapshot_;
+};
+
+}  // namespace conf
+}  // namespace alpheratz
@@ -0,0 +1,78 @@
+#pragma once
+// @author all3n
+// config file compiled to ConfigSnapshot, reloaded in background and published atomically
+#include <absl/status/status.h>
+#include <absl/status/statusor.h>
+#include <absl/strings/string_view.h>
+#include <alpheratz/common/macro.h>
+#include <alpheratz/conf/atomic_snapshot.h>
+#include <alpheratz/conf/config_snapshot.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace alpheratz {
+namespace conf {
+
+class ReloadableConfig {
+   public:
+    using Parser = std::function<absl::StatusOr<std::shared_ptr<const ConfigSnapshot>>(
+        const std::string &path, uint64_t version)>;
+    using Validator = std::function<absl::Status(const ConfigSnapshot &)>;
+    using Listener = std::function<void(const ConfigSnapshot &)>;
+    using Compiler = std::function<std::shared_ptr<const ConfigSnapshot>(uint64_t version)>;
+
+    explicit ReloadableConfig(Parser parser);
+    ~ReloadableConfig();
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(ReloadableConfig);
+
+    // bind to path and load it, an enabled hot reload follows the new path
+    absl::Status Load(absl::string_view path);
+    // like Load, for a caller that has parsed path already: the first snapshot comes from
+    // compile, reloads use the parser
+    absl::Status Load(absl::string_view path, const Compiler &compile);
+    // parse, validate and publish the bound file, the current snapshot is kept on error
+    absl::Status Reload();
+    // Reload every time the bound file is rewritten
+    absl::Status EnableHotReload();
+    void DisableHotReload();
+
+    // checked before publish, a failed check rejects the new snapshot
+    void SetValidator(Validator validator);
+    // listener runs on the reloading thread when key or a key below it changed, after
+    // the reload released its lock, so it may call back into this config. listeners of
+    // racing reloads may run concurrently or out of order, ConfigSnapshot::Version()
+    // tells which is newer
+    uint64_t Subscribe(absl::string_view key, Listener listener);
+    void Unsubscribe(uint64_t id);
+
+    // the current snapshot, valid while held, see AtomicSnapshot::Load
+    std::shared_ptr<const ConfigSnapshot> Snapshot() const { return snapshot_.Load(); }
+
+   private:
+    // set path_, an enabled hot reload follows it
+    absl::Status Bind(absl::string_view path);
+    // lock holds reload_mutex_, it is released before listeners run
+    absl::Status Publish(std::shared_ptr<const ConfigSnapshot> snapshot,
+                         std::unique_lock<std::mutex> *lock);
+
+    Parser parser_;
+    Validator validator_;
+    std::string path_;
+    uint64_t version_{0};
+    uint64_t watch_token_{0};
+    bool hot_reload_{false};
+    // serialize load, reload and publish
+    std::mutex reload_mutex_;
+    std::mutex listener_mutex_;
+    uint64_t next_listener_{0};
+    std::map<uint64_t, std::pair<std::string, Listener>> listeners_;
+    AtomicSnapshot<ConfigSnapshot> snapshot_;
+};
+
+}  // namespace conf
+}  // namespace alpheratz
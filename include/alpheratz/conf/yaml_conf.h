@@ -4,9 +4,13 @@
 #include <absl/strings/str_cat.h>
 #include <absl/strings/string_view.h>
 #include <alpheratz/common/macro.h>
+#include <alpheratz/conf/config_snapshot.h>
+#include <alpheratz/conf/reloadable_config.h>
 #include <glog/logging.h>
 #include <yaml-cpp/yaml.h>
 
+#include <memory>
+
 namespace alpheratz {
 namespace conf {
 class YamlConfig {
@@ -49,9 +53,33 @@ class YamlConfig {
         return absl::nullopt;
     }
 
+    /**
+     * flat typed view of the loaded file, prefer it over node lookups on hot paths.
+     * after hot reload only snapshots see new values, the node tree above keeps
+     * the content of the last Load
+     */
+    std::shared_ptr<const ConfigSnapshot> Snapshot() const { return reloadable_.Snapshot(); }
+
+    absl::Status EnableHotReload() { return reloadable_.EnableHotReload(); }
+    void SetValidator(ReloadableConfig::Validator validator) {
+        reloadable_.SetValidator(std::move(validator));
+    }
+    uint64_t Subscribe(absl::string_view key, ReloadableConfig::Listener listener) {
+        return reloadable_.Subscribe(key, std::move(listener));
+    }
+    void Unsubscribe(uint64_t id) { reloadable_.Unsubscribe(id); }
+
+    // flatten yaml tree to snapshot, scalars are typed as int, double, bool or string
+    static std::shared_ptr<const ConfigSnapshot> Compile(const YAML::Node& root,
+                                                         uint64_t version = 0);
+    // parser for ReloadableConfig
+    static absl::StatusOr<std::shared_ptr<const ConfigSnapshot>> LoadSnapshot(
+        const std::string& filename, uint64_t version);
+
    private:
-    YamlConfig() {}
+    YamlConfig() : reloadable_(&YamlConfig::LoadSnapshot) {}
     YAML::Node root_;
+    ReloadableConfig reloadable_;
     bool initialized_{false};
 };
 
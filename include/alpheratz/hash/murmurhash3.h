@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 namespace alpheratz {
 namespace hash {
@@ -9,6 +10,8 @@ int32_t MurmurHash32(const std::string &str);
 int32_t MurmurHash32(const std::string &str, uint32_t seed);
 int64_t MurmurHash64(const std::string &str);
 int64_t MurmurHash64(const std::string &str, uint32_t seed);
+// same value as MurmurHash64 of a string holding those len bytes
+int64_t MurmurHash64(const void *key, int len, uint32_t seed);
 
 }  // namespace hash
 }  // namespace alpheratz
@@ -0,0 +1,73 @@
+#pragma once
+// @author all3n
+// asynchronous positional reads and writes, io_uring when built with liburing
+#include <absl/status/statusor.h>
+#include <alpheratz/common/macro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace alpheratz {
+namespace io {
+
+enum class IoKind { kRead, kWrite };
+
+struct IoOp {
+    IoKind kind = IoKind::kRead;
+    int fd = -1;
+    // read into or write from, must stay valid until done runs
+    void *buffer = nullptr;
+    size_t size = 0;
+    uint64_t offset = 0;
+    // bytes transferred, fewer than size only when a read reaches the end of file.
+    // runs on an engine thread, so it should hand work off rather than block
+    std::function<void(absl::StatusOr<size_t>)> done;
+};
+
+struct AsyncIoOptions {
+    // io_uring submission queue entries
+    unsigned queue_depth = 256;
+    // workers of the thread pool fallback
+    size_t threads = 4;
+    // use the thread pool even where io_uring works
+    bool force_threads = false;
+};
+
+/**
+ * with ALPHERATZ_HAVE_LIBURING a batch of ops is queued on an io_uring and submitted
+ * with one syscall, a reaper thread runs the callbacks. without it, or when the kernel
+ * refuses io_uring, ops run as blocking pread / pwrite on a small thread pool. short
+ * transfers are resumed until the op is complete, end of file or an error
+ */
+class AsyncIo {
+   public:
+    class Backend;
+
+    // engine shared by the library, created with default options on first use
+    static AsyncIo &Get();
+
+    explicit AsyncIo(const AsyncIoOptions &options = {});
+    // waits for ops in flight
+    ~AsyncIo();
+
+    void Submit(std::vector<IoOp> ops);
+    std::future<absl::StatusOr<size_t>> Read(int fd, void *buffer, size_t size,
+                                             uint64_t offset);
+    std::future<absl::StatusOr<size_t>> Write(int fd, const void *buffer, size_t size,
+                                              uint64_t offset);
+
+    // "io_uring" or "threads"
+    const char *BackendName() const;
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(AsyncIo);
+
+    std::unique_ptr<Backend> backend_;
+};
+
+}  // namespace io
+}  // namespace alpheratz
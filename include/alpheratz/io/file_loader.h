@@ -1,4 +1,5 @@
 #pragma once
+#include <absl/status/status.h>
 #include <absl/strings/string_view.h>
 
 #include <functional>
@@ -10,5 +11,11 @@ void LoadFile(absl::string_view filename,
               std::function<void(const std::string &, uint32_t)> &callback,
               absl::string_view exclude);
 
+// LoadFile for text that must be utf-8: lines are validated before the callback, the
+// first invalid one stops the load with InvalidArgument naming its line and offset
+absl::Status LoadUtf8File(absl::string_view filename,
+                          const std::function<void(const std::string &, uint32_t)> &callback,
+                          absl::string_view exclude = "");
+
 }  // namespace io
 }  // namespace alpheratz
@@ -0,0 +1,113 @@
+#pragma once
+// @author all3n
+// read, decompress, split and process a text file on overlapping stages
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include <absl/types/span.h>
+#include <alpheratz/common/macro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace alpheratz {
+namespace concurrent {
+class ThreadPool;
+}  // namespace concurrent
+namespace io {
+
+enum class PipelineSource {
+    // read(2) into owned blocks
+    kRead,
+    // map the file, an uncompressed file then reaches the callback without a copy
+    kMmap,
+};
+
+enum class PipelineCompression {
+    kNone,
+    kZstd,
+    // zstd when the file starts with the zstd frame magic
+    kAuto,
+};
+
+struct PipelineOptions {
+    PipelineSource source = PipelineSource::kRead;
+    PipelineCompression compression = PipelineCompression::kAuto;
+    // bytes per block read from the file and per block of decompressed text
+    size_t block_size = 1 << 20;
+    // elements between two stages. a full link blocks the stage before it, so at most
+    // about queue_depth blocks or batches per link are in memory
+    size_t queue_depth = 8;
+    size_t lines_per_batch = 4096;
+    // when set, lines are also cut into fields on it, as string::Split does
+    std::string delimiter;
+};
+
+// lines handed to the callback. the views stay valid until the callback returns
+struct LineBatch {
+    // file line number of lines[0], from 0
+    uint64_t first_line = 0;
+    // without the '\n', every line of the file including empty ones
+    std::vector<absl::string_view> lines;
+
+    // fields of lines[i], empty unless PipelineOptions::delimiter is set
+    absl::Span<const absl::string_view> Fields(size_t i) const {
+        if (field_begin.empty()) return {};
+        return absl::MakeConstSpan(fields.data() + field_begin[i],
+                                   field_begin[i + 1] - field_begin[i]);
+    }
+
+    std::vector<absl::string_view> fields;
+    std::vector<uint32_t> field_begin;
+    // storage the views point into
+    std::vector<std::shared_ptr<const std::string>> blocks;
+    std::deque<std::string> stitched;
+};
+
+struct StageStats {
+    std::string name;
+    // blocks or batches the stage took in
+    uint64_t items = 0;
+    // bytes it took in
+    uint64_t bytes = 0;
+    // time spent on its own work and time blocked on the stages around it
+    uint64_t busy_ns = 0;
+    uint64_t wait_ns = 0;
+};
+
+/**
+ * every stage runs on a worker of its own and hands its output to the next one through
+ * a bounded SpscQueue: read -> decompress -> split -> fields -> the callback on the
+ * calling thread. the workers belong to a pool the pipeline keeps across runs.
+ * decompress and fields only run when needed. the slowest stage sets the pace, the stats
+ * show which one it is: its wait_ns stays low while the others wait
+ */
+class LinePipeline {
+   public:
+    using Callback = std::function<void(const LineBatch &)>;
+
+    explicit LinePipeline(const PipelineOptions &options = {});
+    ~LinePipeline();
+
+    // batches arrive in file order. the first error of any stage stops the run and is
+    // returned, batches already in flight are dropped
+    absl::Status Run(absl::string_view path, const Callback &callback);
+
+    // counters of the last Run, one entry per stage that ran
+    const std::vector<StageStats> &Stats() const { return stats_; }
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(LinePipeline);
+
+    PipelineOptions options_;
+    std::vector<StageStats> stats_;
+    // stays separate from the shared pool, the stages block on each other
+    std::unique_ptr<concurrent::ThreadPool> pool_;
+};
+
+}  // namespace io
+}  // namespace alpheratz
@@ -1,4 +1,5 @@
 #pragma once
+#include <alpheratz/io/unique_handle.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -6,27 +7,15 @@
 
 namespace alpheratz {
 namespace io {
-template <typename ResourceType, typename DeleterType>
-class ResourceGuard {
-   public:
-    ResourceGuard(ResourceType resource, DeleterType deleter)
-        : resource_(resource), deleter_(deleter) {}
-
-    ~ResourceGuard() {
-        if (resource_) deleter_(resource_);
-    }
-
-   private:
-    ResourceType resource_;
-    DeleterType deleter_;
-};
 
 void SocketDeleter(int fd);
 void FileDeleter(std::FILE *file);
-using socket_guard = ResourceGuard<int, decltype(&SocketDeleter)>;
-using file_guard = ResourceGuard<std::FILE *, decltype(&FileDeleter)>;
-#define SOCKET_GUARD(s) resource_guard<int, decltype(&socket_deleter)>(s, socket_deleter);
-#define FILE_GUARD(s) resource_guard<std::FILE *, decltype(&file_deleter)>(s, file_deleter);
+// kept for existing callers, new code uses UniqueFd / UniqueFile directly
+using socket_guard = UniqueFd;
+using file_guard = UniqueFile;
+// SOCKET_GUARD(fd) closes fd at the end of the enclosing scope
+#define SOCKET_GUARD(s) ::alpheratz::io::socket_guard s##_guard(s)
+#define FILE_GUARD(s) ::alpheratz::io::file_guard s##_guard(s)
 
 }  // namespace io
 }  // namespace alpheratz
@@ -0,0 +1,136 @@
+#pragma once
+// @author all3n
+// immutable sorted key value table, built offline and served from a read only mapping
+#include <absl/status/status.h>
+#include <absl/status/statusor.h>
+#include <absl/strings/string_view.h>
+#include <alpheratz/common/macro.h>
+#include <alpheratz/io/unique_handle.h>
+#include <alpheratz/io/writer.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace alpheratz {
+namespace io {
+
+/**
+ * layout: data blocks, the sparse index, the index offsets and a fixed footer.
+ * a data block holds entries in key order, each key stored as the length it shares with
+ * the key before it plus the rest, so sorted dictionaries with long common prefixes
+ * shrink a lot. every block starts with a whole key. the index keeps the first key and
+ * the place of every block, the offsets array lets a reader binary search it in place
+ */
+struct SortedTableOptions {
+    // a block is closed once it reaches this many bytes
+    size_t block_size = 4096;
+    // BuildSortedTable: key and value are split at the first delimiter, a line without
+    // one is a key with an empty value. lines starting with exclude are skipped
+    std::string delimiter = "\t";
+    std::string exclude;
+};
+
+class SortedTableBuilder {
+   public:
+    static absl::StatusOr<std::unique_ptr<SortedTableBuilder>> Create(
+        absl::string_view path, const SortedTableOptions &options = {});
+
+    // keys must be strictly increasing in byte order
+    absl::Status Add(absl::string_view key, absl::string_view value);
+    // writes the index and footer and closes the file
+    absl::Status Finish();
+
+    uint64_t Entries() const { return entries_; }
+
+   private:
+    SortedTableBuilder(std::unique_ptr<Writer> writer, const SortedTableOptions &options);
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(SortedTableBuilder);
+
+    absl::Status FlushBlock();
+
+    std::unique_ptr<Writer> writer_;
+    size_t block_size_;
+    std::string block_;
+    std::string last_key_;
+    uint64_t entries_{0};
+    uint64_t block_entries_{0};
+    // first key and offset of every written block
+    std::string index_;
+    std::vector<uint64_t> index_offsets_;
+    bool finished_{false};
+};
+
+// compiles a text dictionary, "key<delimiter>value" per line, into a table. the input
+// may be zstd compressed and need not be sorted, the last line of a repeated key wins
+absl::Status BuildSortedTable(absl::string_view text_path, absl::string_view table_path,
+                              const SortedTableOptions &options = {});
+
+/**
+ * lookups decode straight from the mapping, a table costs no heap beyond this object
+ * and processes mapping the same file share its pages. values returned are views into
+ * the mapping and stay valid while the table lives. thread safe, an Iterator is not
+ */
+class SortedTable {
+   public:
+    static absl::StatusOr<std::unique_ptr<SortedTable>> Open(absl::string_view path);
+
+    bool Find(absl::string_view key, absl::string_view *value) const;
+    // fn(key, value) for the keys starting with prefix in order, until fn returns false
+    void ScanPrefix(absl::string_view prefix,
+                    const std::function<bool(absl::string_view, absl::string_view)> &fn) const;
+
+    uint64_t Entries() const { return entries_; }
+
+    class Iterator {
+       public:
+        explicit Iterator(const SortedTable *table) : table_(table) {}
+
+        void SeekToFirst();
+        // the first key not less than target
+        void Seek(absl::string_view target);
+        bool Valid() const { return valid_; }
+        void Next();
+
+        // the key is rebuilt in the iterator, valid until it moves
+        absl::string_view Key() const { return key_; }
+        absl::string_view Value() const { return value_; }
+
+       private:
+        bool LoadBlock(uint64_t block);
+        // decodes the entry at pos_, moving to the next block at the end of one
+        void ParseNext();
+
+        const SortedTable *table_;
+        uint64_t block_ = 0;
+        const char *pos_ = nullptr;
+        const char *end_ = nullptr;
+        std::string key_;
+        absl::string_view value_;
+        bool valid_ = false;
+    };
+
+   private:
+    SortedTable() = default;
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(SortedTable);
+
+    // first key of a block and where its data is
+    bool IndexEntry(uint64_t block, absl::string_view *first_key, uint64_t *offset,
+                    uint64_t *size) const;
+    // the last block whose first key is not greater than key, 0 when there is none
+    uint64_t FindBlock(absl::string_view key) const;
+
+    UniqueFd fd_;
+    UniqueMmap map_;
+    const char *data_ = nullptr;
+    uint64_t size_ = 0;
+    uint64_t offsets_offset_ = 0;
+    uint64_t blocks_ = 0;
+    uint64_t entries_ = 0;
+};
+
+}  // namespace io
+}  // namespace alpheratz
@@ -0,0 +1,97 @@
+#pragma once
+// @author all3n
+// move-only owner of a handle whose close function and invalid value are traits
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <utility>
+
+namespace alpheratz {
+namespace io {
+
+/**
+ * Traits provides
+ *   using value_type = ...;
+ *   static value_type Invalid();
+ *   static bool IsValid(value_type);
+ *   static void Close(value_type);
+ * all static, so a UniqueHandle is exactly as large as the handle, costs nothing to
+ * move and can live in containers
+ */
+template <typename Traits>
+class UniqueHandle {
+   public:
+    using value_type = typename Traits::value_type;
+
+    UniqueHandle() noexcept : value_(Traits::Invalid()) {}
+    explicit UniqueHandle(value_type value) noexcept : value_(value) {}
+    UniqueHandle(UniqueHandle &&other) noexcept : value_(other.Release()) {}
+    UniqueHandle &operator=(UniqueHandle &&other) noexcept {
+        Reset(other.Release());
+        return *this;
+    }
+    UniqueHandle(const UniqueHandle &) = delete;
+    UniqueHandle &operator=(const UniqueHandle &) = delete;
+    ~UniqueHandle() { Reset(); }
+
+    value_type Get() const noexcept { return value_; }
+    bool Valid() const noexcept { return Traits::IsValid(value_); }
+    explicit operator bool() const noexcept { return Valid(); }
+
+    // give up ownership without closing
+    value_type Release() noexcept {
+        value_type value = value_;
+        value_ = Traits::Invalid();
+        return value;
+    }
+    // close the owned handle, if any, and take value
+    void Reset(value_type value = Traits::Invalid()) noexcept {
+        value_type old = value_;
+        value_ = value;
+        if (Traits::IsValid(old)) {
+            Traits::Close(old);
+        }
+    }
+    void Swap(UniqueHandle &other) noexcept { std::swap(value_, other.value_); }
+
+   private:
+    value_type value_;
+};
+
+struct FdTraits {
+    using value_type = int;
+    static constexpr int Invalid() { return -1; }
+    static constexpr bool IsValid(int fd) { return fd >= 0; }
+    static void Close(int fd) { ::close(fd); }
+};
+
+struct FileTraits {
+    using value_type = std::FILE *;
+    static constexpr std::FILE *Invalid() { return nullptr; }
+    static constexpr bool IsValid(std::FILE *file) { return file != nullptr; }
+    static void Close(std::FILE *file) { std::fclose(file); }
+};
+
+struct MappedRegion {
+    void *data;
+    size_t size;
+};
+
+struct MmapTraits {
+    using value_type = MappedRegion;
+    static MappedRegion Invalid() { return {MAP_FAILED, 0}; }
+    static bool IsValid(MappedRegion region) { return region.data != MAP_FAILED; }
+    static void Close(MappedRegion region) { ::munmap(region.data, region.size); }
+};
+
+using UniqueFd = UniqueHandle<FdTraits>;
+using UniqueFile = UniqueHandle<FileTraits>;
+using UniqueMmap = UniqueHandle<MmapTraits>;
+
+static_assert(sizeof(UniqueFd) == sizeof(int), "UniqueFd must be as large as an fd");
+static_assert(sizeof(UniqueFile) == sizeof(std::FILE *), "UniqueFile must be a pointer");
+
+}  // namespace io
+}  // namespace alpheratz
@@ -0,0 +1,108 @@
+#pragma once
+// @author all3n
+// buffered file writer with writev batching, streaming zstd, fsync policy and O_DIRECT
+#include <absl/status/status.h>
+#include <absl/status/statusor.h>
+#include <absl/strings/string_view.h>
+#include <alpheratz/common/macro.h>
+#include <alpheratz/compress/zstd.h>
+#include <alpheratz/io/unique_handle.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace alpheratz {
+namespace io {
+
+enum class SyncPolicy {
+    // leave write back to the kernel
+    kNone,
+    // once in Close
+    kOnClose,
+    // after every Flush and in Close
+    kOnFlush,
+};
+
+struct WriterOptions {
+    // rounded up to a multiple of Writer::kAlignment
+    size_t buffer_size = 1 << 20;
+    bool append = false;
+    mode_t mode = 0644;
+    // bypass the page cache. when the file system refuses O_DIRECT, or an appended file
+    // does not end on an aligned offset, the writer silently uses the page cache
+    bool direct = false;
+    // compress the stream into one zstd frame, level 0 is zstd's default
+    bool zstd = false;
+    int zstd_level = 0;
+    SyncPolicy sync = SyncPolicy::kNone;
+    // fdatasync instead of fsync, skips metadata that is not needed to read the data
+    bool sync_data_only = true;
+    // also sync whenever this many bytes reached the file since the last sync, 0 never
+    uint64_t sync_bytes = 0;
+};
+
+/**
+ * appends go into one aligned buffer and reach the file in buffer sized writes. an
+ * append that does not fit is sent together with the buffered bytes in a single writev,
+ * without copying it. in direct mode only whole blocks are written until Close, which
+ * writes the tail through the page cache. not thread safe
+ */
+class Writer {
+   public:
+    static constexpr size_t kAlignment = 4096;
+
+    static absl::StatusOr<std::unique_ptr<Writer>> Open(absl::string_view path,
+                                                        const WriterOptions &options = {});
+    // closes, errors are lost, call Close to see them
+    ~Writer();
+
+    absl::Status Append(absl::string_view data);
+    // gather several pieces, e.g. a header and a payload, into one call
+    absl::Status Append(const absl::string_view *parts, size_t count);
+    // hand the buffered bytes to the kernel, ends a zstd block so everything written so
+    // far can be decompressed. syncs under SyncPolicy::kOnFlush
+    absl::Status Flush();
+    // Flush plus fsync / fdatasync
+    absl::Status Sync();
+    // flush, end the zstd frame, sync per policy and close the fd. later calls are no-ops
+    absl::Status Close();
+
+    // bytes passed to Append, before compression
+    uint64_t BytesAppended() const { return appended_; }
+    // bytes that reached the file
+    uint64_t BytesWritten() const { return written_; }
+    bool Direct() const { return direct_; }
+
+   private:
+    Writer(UniqueFd fd, char *buffer, size_t capacity, bool direct, const WriterOptions &options);
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(Writer);
+
+    absl::Status AppendRaw(const absl::string_view *parts, size_t count);
+    absl::Status AppendCompressed(absl::string_view data);
+    // run the zstd stream with the given end directive until it is done with input
+    absl::Status Compress(absl::string_view data, int directive);
+    // write the buffer, in direct mode only the whole blocks of it unless all is set
+    absl::Status WriteBuffer(bool all);
+    absl::Status WriteAll(struct iovec *iov, int count);
+    absl::Status Written(size_t size);
+    absl::Status SyncFd();
+
+    UniqueFd fd_;
+    char *buffer_;
+    size_t capacity_;
+    size_t used_{0};
+    bool direct_;
+    compress::UniqueZstdCCtx zstd_;
+    SyncPolicy sync_;
+    bool sync_data_only_;
+    uint64_t sync_bytes_;
+    uint64_t unsynced_{0};
+    uint64_t appended_{0};
+    uint64_t written_{0};
+};
+
+}  // namespace io
+}  // namespace alpheratz
@@ -1,5 +1,8 @@
 #pragma once
-#include <unordered_map>
+#include <absl/container/flat_hash_map.h>
+
+#include <cstddef>
+#include <cstdint>
 namespace alpheratz {
 namespace alloc {
 constexpr int kBlockSize = 4 * 1024;  // 512k
@@ -25,7 +28,7 @@ class MemoryManagerAllocator {
    private:
     MemoryManagerAllocator() {}
     int block_size_{kBlockSize};
-    std::unordered_map<uint32_t, StflyMemBlock> blocks_;
+    absl::flat_hash_map<uint32_t, StflyMemBlock> blocks_;
     int block_count_{0};
 };
 }  // namespace alloc
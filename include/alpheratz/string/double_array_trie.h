@@ -0,0 +1,112 @@
+#pragma once
+// @author all3n
+// double-array trie with exact, prefix and aho-corasick matching over utf-8 text
+#include <absl/status/status.h>
+#include <absl/status/statusor.h>
+#include <absl/strings/string_view.h>
+#include <alpheratz/common/macro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace alpheratz {
+namespace string {
+
+struct TrieMatch {
+    // byte offset and length of the key in the scanned text
+    size_t begin;
+    size_t length;
+    uint32_t value;
+};
+
+struct TrieFileOptions {
+    // the key of a line ends at the first delimiter, its value is the index LoadFile gives
+    // the line. lines starting with exclude are skipped
+    std::string delimiter = "\t";
+    std::string exclude;
+};
+
+/**
+ * a byte trie packed into one array: the child of state s on byte c is t = base[s] + c
+ * when check[t] == s, so a step is two loads and a compare whatever the fan out. next to
+ * them a state keeps its aho-corasick failure link and the nearest key on that chain, so
+ * Scan finds all keys in a text in one pass. keys and text are plain bytes; for valid
+ * utf-8 every match starts and ends on a code point boundary, as no key can start with
+ * a continuation byte. immutable once built and thread safe
+ */
+class DoubleArrayTrie {
+   public:
+    static constexpr uint32_t kNotFound = UINT32_MAX;
+
+    // keys must not be empty and values not kNotFound. keys need not be sorted, the last
+    // value of a repeated key wins
+    static absl::StatusOr<std::unique_ptr<DoubleArrayTrie>> Build(
+        std::vector<std::pair<std::string, uint32_t>> entries);
+    // keys from a utf-8 text file read with LoadUtf8File, see TrieFileOptions
+    static absl::StatusOr<std::unique_ptr<DoubleArrayTrie>> BuildFromFile(
+        absl::string_view path, const TrieFileOptions &options = {});
+    // reads what Serialize or Save wrote, the input is checked before it is trusted
+    static absl::StatusOr<std::unique_ptr<DoubleArrayTrie>> Deserialize(absl::string_view data);
+    static absl::StatusOr<std::unique_ptr<DoubleArrayTrie>> Load(absl::string_view path);
+
+    void Serialize(std::string *out) const;
+    absl::Status Save(absl::string_view path) const;
+
+    // value of key, kNotFound when it is not in the trie
+    uint32_t Find(absl::string_view key) const;
+    // length of the longest key that is a prefix of text and its value, 0 when none is
+    size_t LongestPrefix(absl::string_view text, uint32_t *value) const;
+    // fn(length, value) for every key that is a prefix of text, shortest first
+    void CommonPrefixes(absl::string_view text,
+                        const std::function<void(size_t, uint32_t)> &fn) const;
+    // every occurrence of every key, overlaps included, in order of their end. keys
+    // ending at the same byte come longest first
+    void Scan(absl::string_view text, const std::function<void(const TrieMatch &)> &fn) const;
+    // leftmost longest matches that do not overlap: at each position the longest key
+    // wins and scanning goes on after it, positions without one skip a code point
+    std::vector<TrieMatch> ScanLongest(absl::string_view text) const;
+
+    size_t Size() const { return keys_; }
+    // array slots, used and free
+    size_t Slots() const { return nodes_.size(); }
+    size_t BytesUsed() const;
+
+   private:
+    // what a scan reads per byte in one place
+    struct Node {
+        uint32_t base;
+        uint32_t check;
+        // state of the longest proper suffix of this state's key, the root is 0
+        uint32_t fail;
+        // this state when it ends a key, else the nearest one on the failure chain, 0
+        // when there is none
+        uint32_t report;
+    };
+    class Builder;
+
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+    DoubleArrayTrie() = default;
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(DoubleArrayTrie);
+
+    // child of state on byte, kEmpty when there is none
+    uint32_t Child(uint32_t state, uint8_t byte) const {
+        size_t next = static_cast<size_t>(nodes_[state].base) + byte;
+        return next < nodes_.size() && nodes_[next].check == state ? static_cast<uint32_t>(next)
+                                                                   : kEmpty;
+    }
+
+    std::vector<Node> nodes_;
+    // value and key length of states that end a key, only read on a match
+    std::vector<uint32_t> value_;
+    std::vector<uint32_t> length_;
+    size_t keys_ = 0;
+};
+
+}  // namespace string
+}  // namespace alpheratz
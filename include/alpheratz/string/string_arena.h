@@ -0,0 +1,44 @@
+#pragma once
+// @author all3n
+// bump allocator for many small strings that live and die together
+#include <absl/strings/string_view.h>
+#include <alpheratz/common/macro.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace alpheratz {
+namespace string {
+
+/**
+ * copies go one after another into large blocks, so a million keys cost a handful of
+ * allocations and sit next to each other in memory. nothing is freed before Clear or
+ * destruction, views returned by Copy stay valid until then. not thread safe
+ */
+class StringArena {
+   public:
+    explicit StringArena(size_t block_size = 64 << 10);
+
+    absl::string_view Copy(absl::string_view value);
+    // size bytes without alignment
+    char *Allocate(size_t size);
+    void Clear();
+
+    // bytes handed out and bytes held in blocks
+    size_t BytesUsed() const { return used_; }
+    size_t BytesReserved() const { return reserved_; }
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(StringArena);
+
+    size_t block_size_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    char *next_{nullptr};
+    size_t left_{0};
+    size_t used_{0};
+    size_t reserved_{0};
+};
+
+}  // namespace string
+}  // namespace alpheratz
@@ -0,0 +1,80 @@
+#pragma once
+// @author all3n
+// maps strings to dense uint32_t ids and back, lock-free for strings already known
+#include <absl/strings/string_view.h>
+#include <alpheratz/common/macro.h>
+#include <alpheratz/string/string_arena.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace alpheratz {
+namespace string {
+
+/**
+ * ids count up from 0 in the order strings were first interned and never change. the
+ * bytes live in a StringArena, so views from Name stay valid as long as the interner.
+ * Find, Name and Intern of a known string read an open addressing table of atomic slots
+ * without a lock; only a new string takes the mutex to copy itself in and publish its
+ * slot. a grown table replaces the old one, which is kept for readers still probing it
+ */
+class StringInterner {
+   public:
+    static constexpr uint32_t kNotFound = UINT32_MAX;
+
+    // interner shared by the process
+    static StringInterner &Get();
+
+    explicit StringInterner(size_t expected = 1024);
+    ~StringInterner();
+
+    uint32_t Intern(absl::string_view value);
+    // id of value, kNotFound when it was never interned
+    uint32_t Find(absl::string_view value) const;
+    // value of an id from Intern or Find, empty for other ids
+    absl::string_view Name(uint32_t id) const;
+
+    size_t Size() const { return size_.load(std::memory_order_acquire); }
+    // arena bytes of the strings
+    size_t BytesUsed() const;
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(StringInterner);
+
+    // a slot is the high half of the hash and id + 1, 0 when empty
+    struct Table {
+        explicit Table(size_t capacity);
+        size_t mask;
+        std::unique_ptr<std::atomic<uint64_t>[]> slots;
+    };
+    struct Entry {
+        const char *data;
+        uint32_t size;
+    };
+
+    // names are kept in chunks that double in size and never move: chunk k holds
+    // kFirstChunk << k ids
+    static constexpr int kFirstChunkBits = 10;
+    static constexpr int kChunks = 32 - kFirstChunkBits + 1;
+
+    static uint64_t Hash(absl::string_view value);
+    uint32_t Probe(const Table &table, absl::string_view value, uint64_t hash) const;
+    Entry *At(uint32_t id) const;
+    void Grow();
+
+    std::atomic<Table *> table_;
+    std::atomic<Entry *> chunks_[kChunks] = {};
+    std::atomic<size_t> size_{0};
+
+    // writers only
+    mutable std::mutex mutex_;
+    StringArena arena_;
+    std::vector<std::unique_ptr<Table>> tables_;
+};
+
+}  // namespace string
+}  // namespace alpheratz
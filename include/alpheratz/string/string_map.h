@@ -0,0 +1,83 @@
+#pragma once
+// @author all3n
+// swiss table maps keyed by strings, looked up by absl::string_view without a copy
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/string_view.h>
+#include <alpheratz/common/macro.h>
+#include <alpheratz/string/string_arena.h>
+
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace alpheratz {
+namespace string {
+
+/**
+ * open addressing with a byte of hash per slot: a probe compares 16 control bytes with
+ * one SSE2 instruction and only touches keys whose 7 hash bits match. std::string keys
+ * are found by absl::string_view, const char * or std::string alike. values move when
+ * the table grows, keep them behind a pointer when their address must stay fixed
+ */
+template <typename V>
+using StringMap = absl::flat_hash_map<std::string, V>;
+
+/**
+ * a StringMap whose keys live in a StringArena the map owns: no allocation per key and
+ * the key bytes sit together instead of in one heap block each. erased keys keep their
+ * arena bytes until clear, so it suits dictionaries that are built once and read often
+ */
+template <typename V>
+class ArenaStringMap {
+   public:
+    using Map = absl::flat_hash_map<absl::string_view, V>;
+    using value_type = typename Map::value_type;
+    using iterator = typename Map::iterator;
+    using const_iterator = typename Map::const_iterator;
+
+    explicit ArenaStringMap(size_t arena_block_size = 64 << 10) : arena_(arena_block_size) {}
+
+    // the key is copied into the arena only when it is inserted
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(absl::string_view key, Args &&...args) {
+        bool inserted = false;
+        iterator it = map_.lazy_emplace(key, [&](const typename Map::constructor &construct) {
+            inserted = true;
+            construct(std::piecewise_construct, std::forward_as_tuple(arena_.Copy(key)),
+                      std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+        return {it, inserted};
+    }
+    V &operator[](absl::string_view key) { return try_emplace(key).first->second; }
+
+    iterator find(absl::string_view key) { return map_.find(key); }
+    const_iterator find(absl::string_view key) const { return map_.find(key); }
+    bool contains(absl::string_view key) const { return map_.contains(key); }
+    size_t erase(absl::string_view key) { return map_.erase(key); }
+    void erase(iterator it) { map_.erase(it); }
+
+    size_t size() const { return map_.size(); }
+    bool empty() const { return map_.empty(); }
+    void reserve(size_t count) { map_.reserve(count); }
+    void clear() {
+        map_.clear();
+        arena_.Clear();
+    }
+
+    iterator begin() { return map_.begin(); }
+    iterator end() { return map_.end(); }
+    const_iterator begin() const { return map_.begin(); }
+    const_iterator end() const { return map_.end(); }
+
+    const StringArena &arena() const { return arena_; }
+
+   private:
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(ArenaStringMap);
+
+    StringArena arena_;
+    Map map_;
+};
+
+}  // namespace string
+}  // namespace alpheratz
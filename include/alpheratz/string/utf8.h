@@ -0,0 +1,34 @@
+#pragma once
+// @author all3n
+// utf-8 validation, counting and conversion to and from utf-16 / utf-32
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace alpheratz {
+namespace string {
+
+/**
+ * offset of the first byte of the first ill-formed sequence, in.size() when in is
+ * valid utf-8. overlong forms, surrogates, code points past U+10FFFF and sequences cut
+ * at the end are all ill-formed. checked 64 bytes at a time with ssse3 when the cpu
+ * has it, pure ascii blocks are skipped after one test
+ */
+size_t FindInvalidUtf8(absl::string_view in);
+inline bool IsValidUtf8(absl::string_view in) { return FindInvalidUtf8(in) == in.size(); }
+
+// code points in valid utf-8, i.e. the bytes that are not continuation bytes
+size_t CountCodePoints(absl::string_view in);
+
+// out is replaced. invalid input returns InvalidArgument with the offset and leaves out
+// empty, utf-16 / utf-32 input is invalid on lone surrogates and values past U+10FFFF
+absl::Status Utf8ToUtf16(absl::string_view in, std::u16string *out);
+absl::Status Utf8ToUtf32(absl::string_view in, std::u32string *out);
+absl::Status Utf16ToUtf8(std::u16string_view in, std::string *out);
+absl::Status Utf32ToUtf8(std::u32string_view in, std::string *out);
+
+}  // namespace string
+}  // namespace alpheratz
@@ -0,0 +1,31 @@
+#pragma once
+// @author all3n
+// parse a column of fixed layout timestamps into epoch values
+#include <absl/strings/string_view.h>
+#include <alpheratz/time/datetime.h>
+#include <alpheratz/time/time_zone.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace alpheratz {
+namespace time {
+
+enum class TimeUnit { kSeconds, kMillis };
+
+// words of the error bitmap for n rows
+inline size_t ErrorBitmapWords(size_t n) { return (n + 63) / 64; }
+
+/**
+ * row i must match layout exactly, optionally followed by '.' and 1 to 9 fraction
+ * digits (kept to the millisecond for kMillis, dropped for kSeconds); fields are read
+ * as civil time in tz. out[i] is the epoch value, or 0 with bit i of errors set when
+ * the row does not match. errors holds ErrorBitmapWords(n) words and may be nullptr.
+ * return the number of failed rows
+ */
+size_t ParseTimestamps(const absl::string_view *rows, size_t n, DateTimeLayout layout,
+                       TimeUnit unit, int64_t *out, uint64_t *errors,
+                       const TimeZoneCache &tz = TimeZoneCache::Local());
+
+}  // namespace time
+}  // namespace alpheratz
@@ -0,0 +1,74 @@
+#pragma once
+// @author all3n
+// proleptic gregorian calendar arithmetic, no timezone and no libc
+#include <cstdint>
+
+namespace alpheratz {
+namespace time {
+
+constexpr int64_t kSecondsPerDay = 86400;
+
+struct CivilTime {
+    int64_t year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    int second;
+};
+
+// floor division, C++ rounds toward zero
+constexpr int64_t FloorDiv(int64_t a, int64_t b) {
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+// days since 1970-01-01 of a valid date (month 1..12, day 1..31). years count from march
+// in 400 year eras of 146097 days, so february ends a year and leap days need no branch
+constexpr int64_t DaysFromCivil(int64_t year, int month, int day) {
+    year -= month <= 2;
+    const int64_t era = FloorDiv(year, 400);
+    const int64_t yoe = year - era * 400;
+    const int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// inverse of DaysFromCivil, hour, minute and second are left 0
+constexpr CivilTime CivilFromDays(int64_t days) {
+    days += 719468;
+    const int64_t era = FloorDiv(days, 146097);
+    const int64_t doe = days - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    const int day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    const int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    return CivilTime{yoe + era * 400 + (month <= 2), month, day, 0, 0, 0};
+}
+
+// seconds since epoch of a civil time read as UTC; fields out of range carry over
+// like mktime does, e.g. month 13 is january of the next year
+constexpr int64_t SecondsFromCivil(int64_t year, int64_t month, int64_t day, int64_t hour,
+                                   int64_t minute, int64_t second) {
+    year += FloorDiv(month - 1, 12);
+    month -= FloorDiv(month - 1, 12) * 12;
+    return (DaysFromCivil(year, static_cast<int>(month), 1) + day - 1) * kSecondsPerDay +
+           hour * 3600 + minute * 60 + second;
+}
+
+constexpr CivilTime CivilFromSeconds(int64_t seconds) {
+    const int64_t days = FloorDiv(seconds, kSecondsPerDay);
+    const int64_t rest = seconds - days * kSecondsPerDay;
+    CivilTime civil = CivilFromDays(days);
+    civil.hour = static_cast<int>(rest / 3600);
+    civil.minute = static_cast<int>(rest / 60 % 60);
+    civil.second = static_cast<int>(rest % 60);
+    return civil;
+}
+
+static_assert(DaysFromCivil(1970, 1, 1) == 0, "epoch");
+static_assert(DaysFromCivil(2000, 3, 1) == 11017, "leap year");
+static_assert(CivilFromDays(-1).year == 1969 && CivilFromDays(-1).day == 31, "before epoch");
+
+}  // namespace time
+}  // namespace alpheratz
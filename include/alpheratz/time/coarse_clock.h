@@ -0,0 +1,73 @@
+#pragma once
+// @author all3n
+// cached clock for hot paths, read without locks or syscalls
+#include <absl/status/status.h>
+#include <alpheratz/common/macro.h>
+#include <alpheratz/time/time_zone.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace alpheratz {
+namespace time {
+
+/**
+ * while started, a ticker thread publishes wall and monotonic millis plus the local
+ * time text of the current second every interval, readers copy them out of a seqlock.
+ * when stopped, reads go to CLOCK_REALTIME_COARSE / CLOCK_MONOTONIC_COARSE, which
+ * the vDSO answers without a syscall, and the text is cached per thread and second.
+ * either way values lag real time by up to one interval or kernel tick.
+ */
+class CoarseClock {
+   public:
+    // "YYYY-MM-DD HH:MM:SS", DATETIME_FORMAT
+    static constexpr size_t kTextSize = 19;
+
+    static CoarseClock &Get();
+    ~CoarseClock();
+
+    // text is formatted in tz, which must outlive the ticker
+    absl::Status Start(std::chrono::milliseconds interval = std::chrono::milliseconds(1),
+                       const TimeZoneCache &tz = TimeZoneCache::Local());
+    void Stop();
+    bool Running() const { return running_.load(std::memory_order_acquire); }
+
+    int64_t NowMillis() const;
+    int64_t NowSeconds() const { return NowMillis() / 1000; }
+    // for intervals and ttl, unaffected by wall clock steps
+    int64_t MonotonicMillis() const;
+    // write kTextSize chars of the local time of NowSeconds(), no terminating '\0'
+    void NowText(char *buf) const;
+    std::string NowText() const;
+
+   private:
+    CoarseClock() = default;
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(CoarseClock);
+
+    static constexpr size_t kTextWords = (kTextSize + 7) / 8;
+
+    void Run(std::chrono::milliseconds interval, const TimeZoneCache *tz);
+    void Tick(const TimeZoneCache &tz, int64_t *formatted);
+
+    std::atomic<int64_t> millis_{0};
+    std::atomic<int64_t> monotonic_{0};
+    // seqlock over text_: odd while the ticker writes, words are atomics so a torn read
+    // is defined behaviour and simply retried
+    std::atomic<uint64_t> sequence_{0};
+    std::atomic<uint64_t> text_[kTextWords] = {};
+    std::atomic<bool> running_{false};
+
+    std::mutex mutex_;
+    std::condition_variable stop_cv_;
+    bool stop_{false};
+    std::thread thread_;
+};
+
+}  // namespace time
+}  // namespace alpheratz
@@ -1,4 +1,8 @@
 #pragma once
+#include <absl/strings/string_view.h>
+#include <alpheratz/time/time_zone.h>
+
+#include <cstddef>
 #include <ctime>
 #include <string>
 namespace alpheratz {
@@ -8,18 +12,15 @@ namespace time {
 #define DATETIME_FORMAT2 "%Y%m%d%H%M%S"
 #define DATE_FORMAT "%Y-%m-%d"
 
+// the fixed formats above, parsed and formatted by specialized digit kernels
+enum class DateTimeLayout { kDateTime, kDateTime2, kDate };
+
 class DateTime {
    public:
-    DateTime() {
-        time_t t = std::time(nullptr);
-        struct tm *now = localtime(&t);
-        year_ = now->tm_year + 1900;
-        month_ = now->tm_mon + 1;
-        day_ = now->tm_mday;
-        hour_ = now->tm_hour;
-        minute_ = now->tm_min;
-        second_ = now->tm_sec;
-    }
+    // now in local time, from CoarseClock
+    DateTime();
+
+    explicit DateTime(time_t timestamp, const TimeZoneCache &tz = TimeZoneCache::Local());
 
     DateTime(int year, int month, int day, int hour, int minute, int second)
         : year_(year), month_(month), day_(day), hour_(hour), minute_(minute), second_(second) {}
@@ -36,7 +37,10 @@ class DateTime {
 
     int GetSecond() const { return second_; }
 
-    time_t GetTimestamp() const;
+    time_t GetTimestamp() const { return GetTimestamp(TimeZoneCache::Local()); }
+
+    // fields read as civil time in tz, see TimeZoneCache::ToEpoch
+    time_t GetTimestamp(const TimeZoneCache &tz) const;
 
     void SetYear(int year) { this->year_ = year; }
 
@@ -50,10 +54,24 @@ class DateTime {
 
     void SetSecond(int second) { this->second_ = second; }
 
+    // fixed formats and formats of only %Y %m %d %H %M %S %% are handled without
+    // strftime/strptime, anything else falls back to them
     std::string ToString(const std::string &format = DATETIME_FORMAT) const;
 
     static DateTime Parse(const std::string &str, const std::string &format = DATETIME_FORMAT);
 
+    // layout chosen at compile time, e.g. dt.ToString<DateTimeLayout::kDate>()
+    template <DateTimeLayout layout>
+    std::string ToString() const;
+    // write without the terminating '\0', return the length or 0 if buf is too small
+    template <DateTimeLayout layout>
+    size_t Format(char *buf, size_t size) const;
+    template <DateTimeLayout layout>
+    static DateTime Parse(absl::string_view str);
+    // return false and leave *dt untouched if str does not match the layout exactly
+    template <DateTimeLayout layout>
+    static bool TryParse(absl::string_view str, DateTime *dt);
+
    private:
     int year_;
     int month_;
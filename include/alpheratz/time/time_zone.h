@@ -0,0 +1,73 @@
+#pragma once
+// @author all3n
+// utc offset table of a timezone, lock-free civil <-> epoch conversion
+#include <absl/status/statusor.h>
+#include <absl/strings/string_view.h>
+#include <absl/time/time.h>
+#include <alpheratz/common/macro.h>
+#include <alpheratz/time/civil.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace alpheratz {
+namespace time {
+
+/**
+ * transitions of the zone up to kTableEndYear are copied out of absl::TimeZone into a
+ * sorted table at construction, later conversions only binary search it; times past
+ * the table go to absl::TimeZone, which is thread-safe as well.
+ * unlike mktime/localtime the zone is read once, a later change of TZ is not seen.
+ */
+class TimeZoneCache {
+   public:
+    static constexpr int kTableEndYear = 2200;
+
+    // local seconds [begin, end) that all convert with the same offset
+    struct LocalRange {
+        int64_t begin;
+        int64_t end;
+        int32_t offset;
+
+        bool Contains(int64_t local) const { return local >= begin && local < end; }
+    };
+
+    explicit TimeZoneCache(absl::TimeZone tz);
+    ALPHERATZ_DISALLOW_COPY_AND_ASSIGN(TimeZoneCache);
+
+    // zone of TZ or /etc/localtime, loaded on first use
+    static const TimeZoneCache &Local();
+    static const TimeZoneCache &Utc();
+    // by IANA name, e.g. "Asia/Shanghai"; loaded once and kept for the process lifetime
+    static absl::StatusOr<const TimeZoneCache *> Load(absl::string_view name);
+
+    const std::string &Name() const { return name_; }
+    // seconds east of UTC at epoch
+    int OffsetAt(int64_t epoch) const;
+    CivilTime ToCivil(int64_t epoch) const;
+    // fields out of range carry over like mktime; a skipped local time is read with the
+    // offset before the gap (02:30 in a 02:00 -> 03:00 gap is 03:30), a repeated one
+    // yields the earlier instant
+    int64_t ToEpoch(const CivilTime &civil) const;
+    // range around local, a civil time as SecondsFromCivil; empty past the table.
+    // lets a caller converting runs of close times skip the lookup: epoch = local - offset
+    LocalRange RangeOf(int64_t local) const;
+
+   private:
+    struct Transition {
+        int64_t epoch;  // first second with offset
+        // local time from which ToEpoch uses offset, the later local time of the change
+        int64_t local;
+        int32_t offset;
+    };
+
+    std::string name_;
+    absl::TimeZone tz_;
+    int32_t initial_offset_;
+    int64_t table_end_;
+    std::vector<Transition> transitions_;
+};
+
+}  // namespace time
+}  // namespace alpheratz
@@ -0,0 +1,256 @@
+#include <gtest/gtest.h>
+#include <alpheratz/bitmap/roaring_bitmap.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using alpheratz::bitmap::RoaringBitmap;
+
+namespace {
+
+// allocations of a bitset container's words
+std::atomic<int> bitset_allocations{0};
+
+std::vector<uint32_t> Sorted(const std::set<uint32_t> &values) {
+    return std::vector<uint32_t>(values.begin(), values.end());
+}
+
+// sparse values, a dense block and long runs, so every container type shows up
+std::set<uint32_t> RandomSet(std::mt19937 *rng) {
+    std::set<uint32_t> values;
+    for (int i = 0; i < 3000; ++i) values.insert((*rng)() % (1u << 22));
+    uint32_t dense = ((*rng)() % 64) << 16;
+    for (int i = 0; i < 30000; ++i) values.insert(dense + (*rng)() % 65536);
+    for (int r = 0; r < 20; ++r) {
+        uint32_t start = (*rng)() % (1u << 22);
+        for (uint32_t v = start; v < start + (*rng)() % 3000; ++v) values.insert(v);
+    }
+    values.insert(UINT32_MAX);
+    return values;
+}
+
+}  // namespace
+
+__attribute__((noinline)) void *operator new(size_t size) {
+    if (size == 8192) ++bitset_allocations;
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+// out of line, so callers do not see new and free paired
+__attribute__((noinline)) void operator delete(void *p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+TEST(TestBitmap, TestAddRemove) {
+    RoaringBitmap bitmap;
+    EXPECT_TRUE(bitmap.Empty());
+    bitmap.Add(5);
+    bitmap.Add(1u << 20);
+    bitmap.Add(5);
+    bitmap.Add(UINT32_MAX);
+    EXPECT_EQ(bitmap.Cardinality(), 3u);
+    EXPECT_TRUE(bitmap.Contains(5));
+    EXPECT_TRUE(bitmap.Contains(UINT32_MAX));
+    EXPECT_FALSE(bitmap.Contains(6));
+    EXPECT_TRUE(bitmap.Remove(5));
+    EXPECT_FALSE(bitmap.Remove(5));
+    EXPECT_EQ(bitmap.ToVector(), (std::vector<uint32_t>{1u << 20, UINT32_MAX}));
+
+    // an array grows into a bitset past 4096 values and shrinks back
+    RoaringBitmap dense;
+    for (uint32_t v = 0; v < 10000; v += 2) dense.Add(v);
+    EXPECT_EQ(dense.Cardinality(), 5000u);
+    size_t bitset_bytes = dense.BytesUsed();
+    EXPECT_GE(bitset_bytes, 8192u);
+    for (uint32_t v = 0; v < 4000; v += 2) dense.Remove(v);
+    EXPECT_EQ(dense.Cardinality(), 3000u);
+    EXPECT_FALSE(dense.Contains(100));
+    EXPECT_TRUE(dense.Contains(9998));
+
+    RoaringBitmap range;
+    range.AddRange(100, 200000);
+    range.AddRange(5, 7);
+    range.AddRange(10, 10);
+    EXPECT_EQ(range.Cardinality(), 200000u - 100 + 2);
+    EXPECT_TRUE(range.Contains(65536 * 2));
+    EXPECT_FALSE(range.Contains(200000));
+    EXPECT_LT(range.BytesUsed(), 8192u * 2 + 1024);
+    range.Remove(70000);
+    EXPECT_FALSE(range.Contains(70000));
+    EXPECT_EQ(range.Cardinality(), 200000u - 100 + 1);
+
+    std::vector<uint32_t> sorted = {1, 2, 3, 70000, 70001};
+    RoaringBitmap many = RoaringBitmap::Of(sorted);
+    EXPECT_EQ(many.ToVector(), sorted);
+    many.Clear();
+    EXPECT_TRUE(many.Empty());
+}
+
+TEST(TestBitmap, TestIterator) {
+    std::mt19937 rng(3);
+    std::set<uint32_t> values = RandomSet(&rng);
+    RoaringBitmap bitmap = RoaringBitmap::Of(Sorted(values));
+    for (int optimized = 0; optimized < 2; ++optimized) {
+        std::vector<uint32_t> seen;
+        for (RoaringBitmap::Iterator it(&bitmap); it.Valid(); it.Next()) {
+            seen.push_back(it.Value());
+        }
+        EXPECT_EQ(seen, Sorted(values));
+        EXPECT_EQ(bitmap.ToVector(), Sorted(values));
+        RoaringBitmap::Iterator it(&bitmap);
+        for (int i = 0; i < 1000; ++i) {
+            uint32_t target = rng() % (1u << 22);
+            it.Seek(target);
+            auto expected = values.lower_bound(target);
+            ASSERT_TRUE(it.Valid());
+            EXPECT_EQ(it.Value(), *expected);
+        }
+        it.Seek(UINT32_MAX);
+        ASSERT_TRUE(it.Valid());
+        it.Next();
+        EXPECT_FALSE(it.Valid());
+        EXPECT_TRUE(bitmap.RunOptimize() || optimized == 1);
+    }
+}
+
+TEST(TestBitmap, TestSetOperations) {
+    std::mt19937 rng(11);
+    for (int round = 0; round < 8; ++round) {
+        std::set<uint32_t> sa = RandomSet(&rng), sb = RandomSet(&rng);
+        RoaringBitmap a = RoaringBitmap::Of(Sorted(sa)), b = RoaringBitmap::Of(Sorted(sb));
+        // mixes run containers into either side
+        if (round & 1) a.RunOptimize();
+        if (round & 2) b.RunOptimize();
+        if (round & 4) b.AddRange(0, 1u << 17);
+        if (round & 4) {
+            for (uint32_t v = 0; v < (1u << 17); ++v) sb.insert(v);
+        }
+        std::vector<uint32_t> expected;
+        std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                              std::back_inserter(expected));
+        EXPECT_EQ((a & b).ToVector(), expected);
+        EXPECT_EQ(a.AndCardinality(b), expected.size());
+        expected.clear();
+        std::set_union(sa.begin(), sa.end(), sb.begin(), sb.end(), std::back_inserter(expected));
+        EXPECT_EQ((a | b).ToVector(), expected);
+        EXPECT_EQ((a | b).Cardinality(), expected.size());
+        expected.clear();
+        std::set_symmetric_difference(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                                      std::back_inserter(expected));
+        EXPECT_EQ((a ^ b).ToVector(), expected);
+        expected.clear();
+        std::set_difference(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                            std::back_inserter(expected));
+        EXPECT_EQ((a - b).ToVector(), expected);
+
+        EXPECT_TRUE((a ^ b) == ((a | b) - (a & b)));
+        EXPECT_TRUE((a - a).Empty());
+        RoaringBitmap c = a;
+        c &= c;
+        EXPECT_TRUE(c == a);
+        c.Add(UINT32_MAX - 1);
+        EXPECT_TRUE(c != a);
+    }
+}
+
+TEST(TestBitmap, TestInPlaceKeepsContainers) {
+    // bitsets in containers of their own, b overlaps a in one of them
+    RoaringBitmap a, b;
+    for (uint32_t key = 0; key < 16; ++key) {
+        for (uint32_t low = 0; low < 65536; low += 3) a.Add(key << 16 | low);
+    }
+    for (uint32_t low = 1; low < 65536; low += 3) b.Add(low);
+    uint64_t cardinality = a.Cardinality();
+    bitset_allocations = 0;
+    a |= b;
+    // only the container shared with b gets new words, the other 15 are moved
+    EXPECT_EQ(bitset_allocations.load(), 1);
+    EXPECT_EQ(a.Cardinality(), cardinality + b.Cardinality());
+    bitset_allocations = 0;
+    a -= b;
+    EXPECT_EQ(bitset_allocations.load(), 1);
+    EXPECT_EQ(a.Cardinality(), cardinality);
+    bitset_allocations = 0;
+    RoaringBitmap c = a | b;
+    EXPECT_EQ(bitset_allocations.load(), 16);
+}
+
+TEST(TestBitmap, TestSerialize) {
+    std::mt19937 rng(5);
+    std::set<uint32_t> values = RandomSet(&rng);
+    RoaringBitmap bitmap = RoaringBitmap::Of(Sorted(values));
+    bitmap.RunOptimize();
+    std::string data;
+    bitmap.Serialize(&data);
+    EXPECT_EQ(data.size(), bitmap.SerializedSize());
+
+    auto copy = RoaringBitmap::Deserialize(data);
+    ASSERT_TRUE(copy.ok()) << copy.status();
+    EXPECT_TRUE(*copy == bitmap);
+
+    // mapped containers read the buffer in place and copy themselves when changed
+    std::unique_ptr<uint64_t[]> aligned(new uint64_t[data.size() / 8 + 1]);
+    std::memcpy(aligned.get(), data.data(), data.size());
+    absl::string_view view(reinterpret_cast<const char *>(aligned.get()), data.size());
+    auto mapped = RoaringBitmap::Map(view);
+    ASSERT_TRUE(mapped.ok()) << mapped.status();
+    EXPECT_EQ(mapped->ToVector(), Sorted(values));
+    EXPECT_LT(mapped->BytesUsed(), bitmap.BytesUsed());
+    RoaringBitmap changed = *mapped;
+    for (uint32_t v : values) {
+        if (v % 3 == 0) changed.Remove(v);
+    }
+    changed.Add(7);
+    EXPECT_EQ(std::memcmp(aligned.get(), data.data(), data.size()), 0);
+    EXPECT_TRUE(*mapped == bitmap);
+    EXPECT_TRUE(changed.Contains(7));
+    EXPECT_EQ((changed & *mapped).Cardinality(), changed.Cardinality() - !values.count(7));
+
+    auto trusted = RoaringBitmap::Map(view, false);
+    ASSERT_TRUE(trusted.ok()) << trusted.status();
+    EXPECT_TRUE(*trusted == bitmap);
+    // the descriptors are still checked against the size of data
+    EXPECT_FALSE(RoaringBitmap::Map(view.substr(0, view.size() - 8), false).ok());
+
+    // an unaligned view is copied
+    std::string shifted = " " + data;
+    auto unaligned = RoaringBitmap::Map(absl::string_view(shifted).substr(1));
+    ASSERT_TRUE(unaligned.ok());
+    EXPECT_TRUE(*unaligned == bitmap);
+
+    std::vector<uint8_t> compressed;
+    ASSERT_TRUE(bitmap.SerializeCompressed(&compressed).ok());
+    EXPECT_LT(compressed.size(), data.size());
+    auto restored = RoaringBitmap::DeserializeCompressed(compressed);
+    ASSERT_TRUE(restored.ok()) << restored.status();
+    EXPECT_TRUE(*restored == bitmap);
+
+    std::string empty;
+    RoaringBitmap().Serialize(&empty);
+    auto none = RoaringBitmap::Deserialize(empty);
+    ASSERT_TRUE(none.ok());
+    EXPECT_TRUE(none->Empty());
+
+    // damaged input is refused or at least safe to use
+    EXPECT_FALSE(RoaringBitmap::Deserialize(data.substr(0, data.size() - 8)).ok());
+    EXPECT_FALSE(RoaringBitmap::Deserialize("not a bitmap").ok());
+    for (int i = 0; i < 300; ++i) {
+        std::string damaged = data;
+        damaged[rng() % damaged.size()] ^= static_cast<char>(1 + rng() % 255);
+        auto loaded = RoaringBitmap::Deserialize(damaged);
+        if (loaded.ok()) {
+            EXPECT_EQ(loaded->ToVector().size(), loaded->Cardinality());
+            (*loaded & bitmap).Cardinality();
+        }
+    }
+}
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <alpheratz/cache/frequency_sketch.h>
+#include <alpheratz/cache/sharded_cache.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace alpheratz::cache;
+
+TEST(TestCache, TestFrequencySketch) {
+    FrequencySketch sketch(1024);
+    CacheKeyHash<int> hash;
+    for (int i = 0; i < 10; ++i) {
+        sketch.Increment(hash(1));
+    }
+    sketch.Increment(hash(2));
+    EXPECT_EQ(sketch.Estimate(hash(1)), 10u);
+    EXPECT_GE(sketch.Estimate(hash(2)), 1u);
+    EXPECT_LT(sketch.Estimate(hash(2)), 10u);
+    // counters saturate at 15 and age by halving
+    for (int i = 0; i < 100000; ++i) {
+        sketch.Increment(hash(3));
+        sketch.Increment(hash(i + 100));
+    }
+    EXPECT_LE(sketch.Estimate(hash(3)), 15u);
+    EXPECT_LT(sketch.Estimate(hash(1)), 10u);
+}
+
+TEST(TestCache, TestLru) {
+    CacheOptions options;
+    options.shards = 1;
+    options.max_entries = 3;
+    ShardedCache<std::string, int> cache(options);
+    EXPECT_EQ(cache.Get("a"), nullptr);
+    cache.Put("a", 1);
+    cache.Put("b", 2);
+    cache.Put("c", 3);
+    ASSERT_NE(cache.Get("a"), nullptr);
+    // b is the least recently used now
+    cache.Put("d", 4);
+    EXPECT_EQ(cache.Get("b"), nullptr);
+    EXPECT_EQ(*cache.Get("a"), 1);
+    EXPECT_EQ(*cache.Get("d"), 4);
+    cache.Put("a", 10);
+    EXPECT_EQ(*cache.Get("a"), 10);
+    EXPECT_TRUE(cache.Erase("a"));
+    EXPECT_FALSE(cache.Erase("a"));
+
+    CacheStats stats = cache.Stats();
+    EXPECT_EQ(stats.hits, 4u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.puts, 5u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.entries, 2u);
+    cache.Clear();
+    EXPECT_EQ(cache.Size(), 0u);
+}
+
+TEST(TestCache, TestBytes) {
+    CacheOptions options;
+    options.shards = 1;
+    options.max_bytes = 1000;
+    ShardedCache<int, std::string> cache(
+        options, [](const int &, const std::string &value) { return value.size(); });
+    for (int i = 0; i < 10; ++i) {
+        cache.Put(i, std::string(300, 'x'));
+    }
+    CacheStats stats = cache.Stats();
+    EXPECT_EQ(stats.entries, 3u);
+    EXPECT_EQ(stats.bytes, 900u);
+    EXPECT_NE(cache.Get(9), nullptr);
+    // a value kept by a reader outlives its eviction
+    auto kept = cache.Get(9);
+    cache.Put(100, std::string(1000, 'y'));
+    EXPECT_EQ(cache.Get(9), nullptr);
+    EXPECT_EQ(kept->size(), 300u);
+    // larger than the whole cache
+    cache.Put(101, std::string(2000, 'z'));
+    EXPECT_EQ(cache.Get(101), nullptr);
+    EXPECT_EQ(cache.Stats().bytes, 0u);
+}
+
+TEST(TestCache, TestTtl) {
+    CacheOptions options;
+    options.ttl_ms = 30;
+    ShardedCache<int, int> cache(options);
+    cache.Put(1, 1);
+    EXPECT_NE(cache.Get(1), nullptr);
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    EXPECT_EQ(cache.Get(1), nullptr);
+    EXPECT_EQ(cache.Stats().expirations, 1u);
+    int loads = 0;
+    auto load = [&loads](int key) {
+        ++loads;
+        return key * 2;
+    };
+    EXPECT_EQ(*cache.GetOrLoad(2, load), 4);
+    EXPECT_EQ(*cache.GetOrLoad(2, load), 4);
+    EXPECT_EQ(loads, 1);
+}
+
+// a hot set is read again and again while a scan of keys seen once streams through
+double HotHitRate(CachePolicy policy) {
+    CacheOptions options;
+    options.shards = 4;
+    options.max_entries = 1000;
+    options.policy = policy;
+    ShardedCache<int, int> cache(options);
+    int hits = 0, reads = 0;
+    int scan = 1000000;
+    for (int round = 0; round < 50; ++round) {
+        for (int key = 0; key < 500; ++key) {
+            ++reads;
+            if (cache.Get(key) != nullptr) {
+                ++hits;
+            } else {
+                cache.Put(key, key);
+            }
+        }
+        for (int i = 0; i < 2000; ++i, ++scan) {
+            if (cache.Get(scan) == nullptr) cache.Put(scan, scan);
+        }
+    }
+    EXPECT_LE(cache.Size(), 1000u);
+    return static_cast<double>(hits) / reads;
+}
+
+TEST(TestCache, TestTinyLfuScanResistance) {
+    double lru = HotHitRate(CachePolicy::kLru);
+    double tiny_lfu = HotHitRate(CachePolicy::kTinyLfu);
+    EXPECT_LT(lru, 0.1);
+    EXPECT_GT(tiny_lfu, 0.8);
+}
+
+TEST(TestCache, TestTinyLfuTinyShards) {
+    // one entry per shard has no room for a window next to the main part
+    for (size_t shards : {size_t(1), size_t(64)}) {
+        CacheOptions options;
+        options.shards = shards;
+        options.max_entries = shards == 1 ? 1 : 50;
+        options.policy = CachePolicy::kTinyLfu;
+        ShardedCache<int, int> cache(options);
+        for (int i = 0; i < 100000; ++i) {
+            cache.Put(i, i);
+        }
+        EXPECT_LE(cache.Size(), shards);
+        EXPECT_NE(cache.Get(99999), nullptr);
+    }
+    CacheOptions options;
+    options.shards = 1;
+    options.max_bytes = 1;
+    options.policy = CachePolicy::kTinyLfu;
+    ShardedCache<int, int> cache(options, [](const int &, const int &) { return 1; });
+    for (int i = 0; i < 1000; ++i) {
+        cache.Put(i, i);
+    }
+    EXPECT_EQ(cache.Size(), 1u);
+}
+
+TEST(TestCache, TestFloatKeys) {
+    CacheOptions options;
+    options.shards = 64;
+    ShardedCache<double, int> cache(options);
+    cache.Put(0.0, 1);
+    ASSERT_NE(cache.Get(-0.0), nullptr);
+    EXPECT_EQ(*cache.Get(-0.0), 1);
+    cache.Put(-0.0, 2);
+    EXPECT_EQ(cache.Size(), 1u);
+    EXPECT_EQ(*cache.Get(0.0), 2);
+    EXPECT_EQ(CacheKeyHash<float>()(-0.0f), CacheKeyHash<float>()(0.0f));
+}
+
+TEST(TestCache, TestConcurrent) {
+    for (auto policy : {CachePolicy::kLru, CachePolicy::kTinyLfu}) {
+        CacheOptions options;
+        options.max_entries = 512;
+        options.policy = policy;
+        ShardedCache<std::string, std::string> cache(options);
+        std::atomic<int> wrong{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < 20000; ++i) {
+                    std::string key = std::to_string((i * 7 + t) % 2000);
+                    auto value = cache.Get(key);
+                    if (value == nullptr) {
+                        cache.Put(key, "v" + key);
+                    } else if (*value != "v" + key) {
+                        ++wrong;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(wrong.load(), 0);
+        CacheStats stats = cache.Stats();
+        EXPECT_EQ(stats.hits + stats.misses, 80000u);
+        EXPECT_LE(stats.entries, 512u + 16u);
+    }
+}
@@ -0,0 +1,287 @@
+#include <gtest/gtest.h>
+#include <alpheratz/concurrent/mpmc_queue.h>
+#include <alpheratz/concurrent/spsc_queue.h>
+#include <alpheratz/concurrent/thread_pool.h>
+#include <alpheratz/concurrent/work_stealing_deque.h>
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace alpheratz::concurrent;
+
+TEST(TestConcurrent, TestDequeOwner) {
+    WorkStealingDeque<int> deque(2);
+    int value;
+    EXPECT_FALSE(deque.Pop(&value));
+    for (int i = 0; i < 100; ++i) {
+        deque.Push(i);
+    }
+    EXPECT_EQ(deque.Size(), 100u);
+    // the owner pops newest first, thieves take the oldest
+    ASSERT_TRUE(deque.Pop(&value));
+    EXPECT_EQ(value, 99);
+    ASSERT_TRUE(deque.Steal(&value));
+    EXPECT_EQ(value, 0);
+    EXPECT_EQ(deque.Size(), 98u);
+}
+
+TEST(TestConcurrent, TestDequeSteal) {
+    const int kItems = 200000;
+    WorkStealingDeque<int> deque(4);
+    std::atomic<bool> done{false};
+    std::vector<std::atomic<int>> seen(kItems);
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; ++t) {
+        thieves.emplace_back([&]() {
+            int value;
+            while (!done.load()) {
+                if (deque.Steal(&value)) seen[value].fetch_add(1);
+            }
+            while (deque.Steal(&value)) seen[value].fetch_add(1);
+        });
+    }
+    int value;
+    for (int i = 0; i < kItems; ++i) {
+        deque.Push(i);
+        if (i % 3 == 0 && deque.Pop(&value)) seen[value].fetch_add(1);
+    }
+    while (deque.Pop(&value)) seen[value].fetch_add(1);
+    done.store(true);
+    for (auto &thief : thieves) {
+        thief.join();
+    }
+    for (int i = 0; i < kItems; ++i) {
+        ASSERT_EQ(seen[i].load(), 1) << i;
+    }
+}
+
+TEST(TestConcurrent, TestSubmit) {
+    ThreadPoolOptions options;
+    options.threads = 4;
+    ThreadPool pool(options);
+    EXPECT_EQ(pool.Size(), 4u);
+    EXPECT_EQ(pool.CurrentWorker(), -1);
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.Submit([](int x) { return x * 2; }, i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(futures[i].get(), i * 2);
+    }
+    auto worker = pool.Submit([&pool]() { return pool.CurrentWorker(); });
+    int index = worker.get();
+    EXPECT_GE(index, 0);
+    EXPECT_LT(index, 4);
+
+    auto failed = pool.Submit([]() -> int { throw std::runtime_error("boom"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+TEST(TestConcurrent, TestDrainOnDestroy) {
+    std::atomic<int> count{0};
+    {
+        ThreadPoolOptions options;
+        options.threads = 2;
+        ThreadPool pool(options);
+        for (int i = 0; i < 500; ++i) {
+            pool.Execute([&count, &pool]() {
+                // tasks scheduled by tasks run too
+                pool.Execute([&count]() { count.fetch_add(1); });
+                count.fetch_add(1);
+            });
+        }
+    }
+    EXPECT_EQ(count.load(), 1000);
+}
+
+TEST(TestConcurrent, TestParallelFor) {
+    ThreadPool &pool = ThreadPool::Get();
+    for (size_t n : {0, 1, 7, 1000, 100003}) {
+        std::vector<std::atomic<int>> hits(n);
+        pool.ParallelFor(0, n, [&hits](size_t i) { hits[i].fetch_add(1); }, 16);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(hits[i].load(), 1) << n << " " << i;
+        }
+    }
+    std::vector<int> offset(10, 0);
+    pool.ParallelFor(5, 10, [&offset](size_t i) { offset[i] = 1; });
+    EXPECT_EQ(std::accumulate(offset.begin(), offset.begin() + 5, 0), 0);
+    EXPECT_EQ(std::accumulate(offset.begin() + 5, offset.end(), 0), 5);
+}
+
+TEST(TestConcurrent, TestParallelReduce) {
+    ThreadPool &pool = ThreadPool::Get();
+    uint64_t sum = pool.ParallelReduce(
+        1, 1000001, uint64_t(0),
+        [](size_t begin, size_t end) {
+            uint64_t partial = 0;
+            for (size_t i = begin; i < end; ++i) partial += i;
+            return partial;
+        },
+        [](uint64_t a, uint64_t b) { return a + b; }, 1024);
+    EXPECT_EQ(sum, 500000500000ull);
+    // partials are combined in order
+    std::string joined = pool.ParallelReduce(
+        0, 26, std::string(),
+        [](size_t begin, size_t end) {
+            std::string part;
+            for (size_t i = begin; i < end; ++i) part += static_cast<char>('a' + i);
+            return part;
+        },
+        [](std::string a, std::string b) { return a + b; });
+    EXPECT_EQ(joined, "abcdefghijklmnopqrstuvwxyz");
+}
+
+TEST(TestConcurrent, TestNestedParallelFor) {
+    ThreadPoolOptions options;
+    options.threads = 2;
+    ThreadPool pool(options);
+    std::atomic<int> count{0};
+    // every outer task blocks on an inner loop, with two workers this only finishes
+    // because waiting callers run tasks themselves
+    pool.ParallelFor(0, 16, [&](size_t) {
+        pool.ParallelFor(0, 64, [&](size_t) { count.fetch_add(1); });
+    });
+    EXPECT_EQ(count.load(), 16 * 64);
+}
+
+TEST(TestConcurrent, TestParallelForException) {
+    ThreadPool &pool = ThreadPool::Get();
+    std::atomic<int> count{0};
+    EXPECT_THROW(pool.ParallelFor(0, 1000,
+                                  [&count](size_t i) {
+                                      count.fetch_add(1);
+                                      if (i == 500) throw std::invalid_argument("bad index");
+                                  }),
+                 std::invalid_argument);
+    // other chunks still ran
+    EXPECT_GT(count.load(), 1);
+}
+
+TEST(TestConcurrent, TestPin) {
+    ThreadPoolOptions options;
+    options.threads = 2;
+    options.cpus = {0};
+    options.name = "pinned-pool-name";
+    ThreadPool pool(options);
+    EXPECT_EQ(pool.Submit([]() { return 42; }).get(), 42);
+    options.cpus.clear();
+    options.numa_node = 0;
+    ThreadPool numa(options);
+    EXPECT_EQ(numa.Submit([]() { return 7; }).get(), 7);
+}
+
+TEST(TestConcurrent, TestSpscQueue) {
+    SpscQueue<std::unique_ptr<int>> queue(5);
+    EXPECT_EQ(queue.Capacity(), 8u);
+    std::unique_ptr<int> value;
+    EXPECT_FALSE(queue.TryPop(&value));
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(queue.TryPush(std::make_unique<int>(i)));
+    }
+    EXPECT_FALSE(queue.TryPush(std::make_unique<int>(8)));
+    ASSERT_TRUE(queue.TryPop(&value));
+    EXPECT_EQ(*value, 0);
+    std::unique_ptr<int> batch[8];
+    EXPECT_EQ(queue.TryPopBatch(batch, 8), 7u);
+    EXPECT_EQ(*batch[6], 7);
+    // elements left inside are destroyed with the queue
+    EXPECT_EQ(queue.TryPushBatch(batch, 3), 3u);
+    EXPECT_EQ(queue.Size(), 3u);
+}
+
+// producers push 1..n each, consumers sum what they pop until the queue is closed
+template <typename Queue>
+void StressQueue(Queue *queue, int producers, int consumers, bool batch) {
+    const uint64_t kPerProducer = 200000;
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> count{0};
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&]() {
+            uint64_t local = 0, n = 0;
+            uint64_t values[32];
+            if (batch) {
+                size_t got;
+                while ((got = queue->PopBatch(values, 32)) > 0) {
+                    for (size_t i = 0; i < got; ++i) local += values[i];
+                    n += got;
+                }
+            } else {
+                uint64_t value;
+                while (queue->Pop(&value)) {
+                    local += value;
+                    ++n;
+                }
+            }
+            sum.fetch_add(local);
+            count.fetch_add(n);
+        });
+    }
+    std::vector<std::thread> pushers;
+    for (int p = 0; p < producers; ++p) {
+        pushers.emplace_back([&]() {
+            uint64_t values[16];
+            for (uint64_t i = 1; i <= kPerProducer;) {
+                if (batch) {
+                    size_t n = 0;
+                    for (; n < 16 && i <= kPerProducer; ++n, ++i) values[n] = i;
+                    ASSERT_EQ(queue->PushBatch(values, n), n);
+                } else {
+                    ASSERT_TRUE(queue->Push(i++));
+                }
+            }
+        });
+    }
+    for (auto &pusher : pushers) {
+        pusher.join();
+    }
+    queue->Close();
+    EXPECT_FALSE(queue->Push(1));
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(count.load(), producers * kPerProducer);
+    EXPECT_EQ(sum.load(), producers * kPerProducer * (kPerProducer + 1) / 2);
+}
+
+TEST(TestConcurrent, TestSpscStress) {
+    for (bool batch : {false, true}) {
+        SpscQueue<uint64_t> queue(64);
+        StressQueue(&queue, 1, 1, batch);
+    }
+}
+
+TEST(TestConcurrent, TestMpmcQueue) {
+    MpmcQueue<std::string> queue(3);
+    EXPECT_EQ(queue.Capacity(), 4u);
+    std::string values[6] = {"a", "b", "c", "d", "e", "f"};
+    EXPECT_EQ(queue.TryPushBatch(values, 6), 4u);
+    EXPECT_EQ(values[0], "");
+    EXPECT_EQ(values[4], "e");
+    std::string value;
+    ASSERT_TRUE(queue.TryPop(&value));
+    EXPECT_EQ(value, "a");
+    EXPECT_TRUE(queue.TryPush("e"));
+    std::string out[8];
+    EXPECT_EQ(queue.TryPopBatch(out, 8), 4u);
+    EXPECT_EQ(out[3], "e");
+    EXPECT_FALSE(queue.TryPop(&value));
+    queue.Close();
+    EXPECT_FALSE(queue.Pop(&value));
+    EXPECT_EQ(queue.PopBatch(out, 8), 0u);
+}
+
+TEST(TestConcurrent, TestMpmcStress) {
+    for (bool batch : {false, true}) {
+        MpmcQueue<uint64_t> queue(128);
+        StressQueue(&queue, 4, 3, batch);
+    }
+}
@@ -0,0 +1,263 @@
+#include <alpheratz/common/env.h>
+#include <alpheratz/conf/atomic_snapshot.h>
+#include <alpheratz/conf/ini_snapshot.h>
+#include <alpheratz/conf/layered_config.h>
+#include <alpheratz/conf/reloadable_config.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+namespace fs = std::filesystem;
+using namespace alpheratz::conf;
+
+static void WriteFile(const fs::path &path, const std::string &content) {
+    // write tmp and rename, as deploy tools do
+    fs::path tmp = path.string() + ".tmp";
+    std::ofstream(tmp) << content;
+    fs::rename(tmp, path);
+}
+
+TEST(TestConf, TestIniParse) {
+    std::string text =
+        "; head\nroot = 1\n\n# sect comment\n[Sec]\na = 2\r\nB=hello world \n"
+        "bad line\n[sec2]\nx=1.5\n\n; dup\n[SEC]\nc=3\n";
+    XiniFileT ini;
+    ini.Parse(text);
+    ASSERT_EQ(ini.SectCount(), 3);
+    ASSERT_STREQ(static_cast<const char *>(ini["sec"]["A"]), "2");
+    ASSERT_STREQ(static_cast<const char *>(ini["SEC"]["b"]), "hello world");
+    ASSERT_STREQ(static_cast<const char *>(ini["sec"]["c"]), "3");
+    ASSERT_STREQ(static_cast<const char *>(ini[""]["ROOT"]), "1");
+    ASSERT_FALSE(ini["sec"].key_included("bad line"));
+
+    std::ostringstream out;
+    ini >> out;
+    ASSERT_EQ(out.str(),
+              "; head\nroot=1\n\n# sect comment\n[Sec]\na=2\nB=hello world\n\n; dup\n\n"
+              "c=3\n\n[sec2]\nx=1.5\n\n");
+    ini.SetDirty(false);
+}
+
+TEST(TestConf, TestIniTypedValue) {
+    XiniFileT ini;
+    XiniKeyvalueT &kv = ini["sec"]["key"];
+    kv = "+42abc";
+    ASSERT_EQ(static_cast<int>(kv), 42);
+    ASSERT_EQ(static_cast<double>(kv), 42.0);
+    kv = "-1.5";
+    ASSERT_EQ(static_cast<int>(kv), -1);
+    ASSERT_EQ(static_cast<double>(kv), -1.5);
+    ASSERT_EQ(static_cast<unsigned short>(kv), 65535);
+    kv = "70000";
+    // out of range for short
+    ASSERT_EQ(kv(static_cast<short>(7)), 7);
+    ASSERT_EQ(kv(7), 70000);
+    kv = "TRUE";
+    ASSERT_TRUE(static_cast<bool>(kv));
+    ASSERT_EQ(static_cast<int>(kv), 0);
+    kv = 0.1;
+    ASSERT_EQ(kv.value(), "0.1");
+    ASSERT_EQ(static_cast<double>(kv), 0.1);
+    kv = "abc";
+    ASSERT_EQ(kv.TryValue(5), 5);
+    ASSERT_EQ(kv.value(), "5");
+    ini.SetDirty(false);
+}
+
+TEST(TestConf, TestIniSnapshot) {
+    fs::path path = fs::temp_directory_path() / "alpheratz_tests_conf.ini";
+    WriteFile(path, "; comment\nname=root\n[server]\nport = 8080\nratio=0.5\nenable=TRUE\n");
+    auto snapshot = LoadIniSnapshot(path.string(), 3);
+    ASSERT_TRUE(snapshot.ok());
+    ASSERT_EQ((*snapshot)->Version(), 3);
+    ASSERT_EQ((*snapshot)->GetString((*snapshot)->Find("name")), "root");
+    ASSERT_EQ((*snapshot)->Get<int>("server.port"), 8080);
+    ASSERT_EQ((*snapshot)->Get<double>("server.ratio"), 0.5);
+    ASSERT_EQ((*snapshot)->Get<bool>("server.enable"), true);
+    fs::remove(path);
+}
+
+TEST(TestConf, TestHotReload) {
+    fs::path path = fs::temp_directory_path() / "alpheratz_tests_reload.ini";
+    WriteFile(path, "[server]\nport=1\nname=a\n");
+
+    ReloadableConfig config(&LoadIniSnapshot);
+    ASSERT_TRUE(config.Load(path.string()).ok());
+    auto port = config.Snapshot()->Find("server.port");
+    ASSERT_EQ(config.Snapshot()->Get<int>(port), 1);
+
+    config.SetValidator([](const ConfigSnapshot &snapshot) {
+        if (snapshot.Get<int>("server.port") <= 0) {
+            return absl::InvalidArgumentError("bad port");
+        }
+        return absl::OkStatus();
+    });
+    std::atomic<int> server_changes{0};
+    std::atomic<int> other_changes{0};
+    config.Subscribe("server", [&](const ConfigSnapshot &) { ++server_changes; });
+    config.Subscribe("other", [&](const ConfigSnapshot &) { ++other_changes; });
+    ASSERT_TRUE(config.EnableHotReload().ok());
+
+    auto wait_version = [&](uint64_t version) {
+        for (int i = 0; i < 200 && config.Snapshot()->Version() < version; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return config.Snapshot()->Version() >= version;
+    };
+    WriteFile(path, "[server]\nport=2\nname=a\n");
+    ASSERT_TRUE(wait_version(2));
+    ASSERT_EQ(config.Snapshot()->Get<int>("server.port"), 2);
+    ASSERT_EQ(server_changes.load(), 1);
+    ASSERT_EQ(other_changes.load(), 0);
+
+    // rejected by validator, old snapshot stays
+    WriteFile(path, "[server]\nport=-1\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_EQ(config.Snapshot()->Get<int>("server.port"), 2);
+
+    WriteFile(path, "[server]\nport=3\n");
+    ASSERT_TRUE(wait_version(3));
+    ASSERT_EQ(config.Snapshot()->Get<int>("server.port"), 3);
+    config.DisableHotReload();
+    fs::remove(path);
+}
+
+TEST(TestConf, TestListenerCallsBack) {
+    fs::path path = fs::temp_directory_path() / "alpheratz_tests_listener.ini";
+    WriteFile(path, "[server]\nport=1\n");
+    ReloadableConfig config(&LoadIniSnapshot);
+    ASSERT_TRUE(config.Load(path.string()).ok());
+    ASSERT_TRUE(config.EnableHotReload().ok());
+    // the listener reconfigures the config it listens to, on the reloading thread
+    std::atomic<int> calls{0};
+    config.Subscribe("server", [&](const ConfigSnapshot &) {
+        config.SetValidator(nullptr);
+        config.Reload().IgnoreError();
+        config.DisableHotReload();
+        ++calls;
+    });
+    WriteFile(path, "[server]\nport=2\n");
+    for (int i = 0; i < 200 && calls.load() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_EQ(calls.load(), 1);
+    ASSERT_EQ(config.Snapshot()->Get<int>("server.port"), 2);
+
+    // and on the thread calling Reload
+    WriteFile(path, "[server]\nport=3\n");
+    ASSERT_TRUE(config.Reload().ok());
+    ASSERT_EQ(calls.load(), 2);
+    ASSERT_EQ(config.Snapshot()->Get<int>("server.port"), 3);
+    fs::remove(path);
+}
+
+TEST(TestConf, TestEnv) {
+    setenv("ALPHERATZ_TEST_ENV", "value", 1);
+    ASSERT_EQ(alpheratz::common::env::GetEnv("ALPHERATZ_TEST_ENV", "def"), "value");
+    ASSERT_EQ(alpheratz::common::env::GetEnv("ALPHERATZ_TEST_UNSET", "def"), "def");
+    ASSERT_FALSE(alpheratz::common::env::LookupEnv("ALPHERATZ_TEST_UNSET").has_value());
+}
+
+TEST(TestConf, TestLayeredConfig) {
+    XiniFileT ini;
+    ini.Parse("[server]\nport=8080\nname=file\nratio=0.5\n");
+    setenv("ALPHERATZ_T_SERVER_NAME", "env", 1);
+    setenv("ALPHERATZ_T_WORKERS", "16", 1);
+
+    LayeredConfig config;
+    config.SetDefault("server.port", int64_t(80));
+    config.SetDefault("server.timeout", 1.5);
+    config.AddFile(CompileIni(ini));
+    config.SetEnvPrefix("ALPHERATZ_T_");
+    config.BindEnv("workers", "ALPHERATZ_T_WORKERS");
+    auto port = config.Handle("server.port");
+    auto name = config.Handle("server.name");
+    auto late = config.Handle("server.late");
+    ASSERT_EQ(config.Get<int>(port, -1), -1);
+    ASSERT_TRUE(config.Build().ok());
+    ASSERT_EQ(config.Version(), 1);
+
+    ASSERT_EQ(config.Get<int>(port), 8080);
+    ASSERT_EQ(config.GetString(name), "env");
+    ASSERT_EQ(config.Get<double>(config.Handle("server.timeout")), 1.5);
+    ASSERT_EQ(config.Get<int>(config.Handle("workers")), 16);
+    ASSERT_EQ(config.Get<int>(late, 3), 3);
+
+    // handles stay valid after rebuild
+    setenv("ALPHERATZ_T_SERVER_LATE", "7", 1);
+    setenv("ALPHERATZ_T_SERVER_PORT", "9090", 1);
+    ASSERT_TRUE(config.Build().ok());
+    ASSERT_EQ(config.Version(), 2);
+    ASSERT_EQ(config.Get<int>(port), 9090);
+    ASSERT_EQ(config.Get<int>(late), 7);
+    ASSERT_EQ(config.Get<double>(config.Handle("server.ratio")), 0.5);
+
+    // a held snapshot outlives any number of rebuilds
+    auto held = config.Snapshot();
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(config.Build().ok());
+    }
+    ASSERT_EQ(held->Version(), 2);
+    ASSERT_EQ(held->GetString(name), "env");
+    ASSERT_EQ(config.Version(), 22);
+    ini.SetDirty(false);
+}
+
+TEST(TestConf, TestParseConfigText) {
+    ASSERT_EQ(std::get<int64_t>(ParseConfigText("-42")), -42);
+    ASSERT_EQ(std::get<double>(ParseConfigText("0.5")), 0.5);
+    ASSERT_EQ(std::get<double>(ParseConfigText("-.5e1")), -5.0);
+    ASSERT_EQ(std::get<double>(ParseConfigText("1E+3")), 1000.0);
+    ASSERT_EQ(std::get<bool>(ParseConfigText("TRUE")), true);
+    // strtod would take these as doubles
+    for (const char *text : {"nan", "inf", "-Infinity", "0x1p3", " 5", "+5", "1e", ".", "1e999"}) {
+        ASSERT_EQ(std::get<std::string>(ParseConfigText(text)), text);
+    }
+}
+
+TEST(TestConf, TestAtomicSnapshot) {
+    AtomicSnapshot<std::string> current;
+    ASSERT_EQ(current.Load(), nullptr);
+    ASSERT_EQ(current.Publish(std::make_shared<const std::string>("a")), nullptr);
+    std::atomic<bool> stop{false};
+    std::thread reader([&]() {
+        while (!stop.load()) {
+            auto value = current.Load();
+            ASSERT_FALSE(value->empty());
+            ASSERT_EQ(value->front(), (*value)[value->size() - 1]);
+        }
+    });
+    for (int i = 0; i < 10000; ++i) {
+        std::string value(1 + i % 64, static_cast<char>('a' + i % 26));
+        current.Publish(std::make_shared<const std::string>(std::move(value)));
+    }
+    stop = true;
+    reader.join();
+
+    // snapshots sharing a per thread cache slot each still read their own latest value
+    std::vector<std::unique_ptr<AtomicSnapshot<std::string>>> many;
+    for (int i = 0; i < 9; ++i) {
+        many.emplace_back(new AtomicSnapshot<std::string>());
+        many.back()->Publish(std::make_shared<const std::string>(std::to_string(i * 10)));
+    }
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 9; ++i) {
+            EXPECT_EQ(*many[i]->Load(), std::to_string(i * 10 + round));
+            EXPECT_EQ(*many[i]->Load(), std::to_string(i * 10 + round));
+            std::string next = std::to_string(i * 10 + round + 1);
+            many[i]->Publish(std::make_shared<const std::string>(std::move(next)));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
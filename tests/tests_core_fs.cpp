@@ -1,7 +1,12 @@
 #include <gtest/gtest.h>
+#include <alpheratz/common/resource_loader.h>
+#include <alpheratz/io/file_loader.h>
 #include <alpheratz/io/fs.h>
 
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <vector>
 using namespace alpheratz::io::fs;
 TEST(TestCoreCommonFs, TestHomeDirectory) {
     std::string home_dir = GetHomeDirectory();
@@ -14,6 +19,50 @@ TEST(TestCoreCommonFs, TestParsePath) {
     ASSERT_EQ(expected_path, path);
     std::cout << path << std::endl;
 }
+TEST(TestCoreCommonFs, TestLoadUtf8File) {
+    std::string path = testing::TempDir() + "/load_utf8.txt";
+    std::ofstream(path) << "# comment\n\xe4\xbd\xa0\n\nok\nab\xff\nlast\n";
+    std::vector<std::string> lines;
+    std::function<void(const std::string &, uint32_t)> callback =
+        [&lines](const std::string &line, uint32_t) { lines.push_back(line); };
+    absl::Status status = alpheratz::io::LoadUtf8File(path, callback, "#");
+    EXPECT_TRUE(absl::IsInvalidArgument(status)) << status;
+    EXPECT_EQ(lines, (std::vector<std::string>{"\xe4\xbd\xa0", "ok"}));
+
+    lines.clear();
+    alpheratz::io::LoadFile(path, callback, "#");
+    EXPECT_EQ(lines.size(), 4u);
+    EXPECT_TRUE(absl::IsNotFound(alpheratz::io::LoadUtf8File(path + ".missing", callback)));
+}
+
+TEST(TestCoreCommonFs, TestResourceLoader) {
+    std::string dir = testing::TempDir() + "/resources";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir + "/nested");
+    std::string big(3 << 20, '\0');
+    for (size_t i = 0; i < big.size(); ++i) big[i] = static_cast<char>(i * 7);
+    std::ofstream(dir + "/big.bin", std::ios::binary) << big;
+    std::ofstream(dir + "/empty.txt");
+    for (int i = 0; i < 20; ++i) {
+        std::ofstream(dir + "/nested/" + std::to_string(i) + ".txt") << "resource " << i;
+    }
+    auto &loader = alpheratz::common::ResourceLoader::Get();
+    absl::Status status = loader.Load(dir);
+    ASSERT_TRUE(status.ok()) << status;
+    auto loaded = loader.GetResource("/big.bin");
+    ASSERT_TRUE(loaded.ok()) << loaded.status();
+    EXPECT_EQ(std::string((*loaded)->begin(), (*loaded)->end()), big);
+    loaded = loader.GetResource("/empty.txt");
+    ASSERT_TRUE(loaded.ok()) << loaded.status();
+    EXPECT_TRUE((*loaded)->empty());
+    for (int i = 0; i < 20; ++i) {
+        loaded = loader.GetResource("/nested/" + std::to_string(i) + ".txt");
+        ASSERT_TRUE(loaded.ok()) << loaded.status();
+        EXPECT_EQ(std::string((*loaded)->begin(), (*loaded)->end()),
+                  "resource " + std::to_string(i));
+    }
+    EXPECT_TRUE(absl::IsNotFound(loader.GetResource("/missing").status()));
+}
 
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <alpheratz/common/gbk.h>
 #include <alpheratz/common/locale.h>
 
 #include <array>
@@ -25,6 +26,93 @@ TEST(TestCoreLocale, TestGbkToUtf8) {
     ASSERT_EQ(out_utf8, utf_expect_str);
 }
 
+TEST(TestCoreLocale, TestTranscoderStream) {
+    using alpheratz::common::locale::Transcoder;
+    // "a你好" in gb18030 plus U+1F600, which needs a 4 byte gb18030 sequence
+    std::string gb = "a\xc4\xe3\xba\xc3\x94\x39\xfc\x36";
+    std::string expect = "a\xe4\xbd\xa0\xe5\xa5\xbd\xf0\x9f\x98\x80";
+
+    auto transcoder = Transcoder::Create("UTF-8", "GB18030");
+    ASSERT_TRUE(transcoder.ok()) << transcoder.status();
+    std::string out;
+    ASSERT_TRUE(transcoder->Convert(gb, &out).ok());
+    ASSERT_EQ(out, expect);
+
+    // every split point, sequences cut between chunks are held back
+    for (size_t cut = 0; cut <= gb.size(); ++cut) {
+        out.clear();
+        ASSERT_TRUE(transcoder->Update(gb.substr(0, cut), &out).ok());
+        ASSERT_TRUE(transcoder->Update(gb.substr(cut), &out).ok());
+        ASSERT_TRUE(transcoder->Finish(&out).ok());
+        ASSERT_EQ(out, expect) << cut;
+    }
+
+    // byte by byte into a caller buffer of one utf-8 char at most
+    out.clear();
+    char buf[4];
+    for (size_t pos = 0; pos < gb.size();) {
+        size_t consumed, written;
+        ASSERT_TRUE(transcoder->Update(gb.substr(pos, 1), buf, sizeof(buf), &consumed, &written)
+                        .ok());
+        out.append(buf, written);
+        pos += consumed;
+    }
+    ASSERT_TRUE(transcoder->Finish(&out).ok());
+    ASSERT_EQ(out, expect);
+
+    // cut at the end of input and invalid bytes are errors
+    out.clear();
+    ASSERT_TRUE(transcoder->Update("a\xc4", &out).ok());
+    EXPECT_EQ(transcoder->Pending(), 1u);
+    EXPECT_FALSE(transcoder->Finish(&out).ok());
+    EXPECT_FALSE(transcoder->Convert("a\xff\xff", &out).ok());
+    EXPECT_EQ(out, "a");
+    ASSERT_TRUE(transcoder->Convert(gb, &out).ok());
+    ASSERT_EQ(out, expect);
+
+    EXPECT_FALSE(Transcoder::Create("UTF-8", "NO-SUCH-CHARSET").ok());
+}
+
+TEST(TestCoreLocale, TestGbkNative) {
+    using alpheratz::common::locale::GbkCharset;
+    using alpheratz::common::locale::GbkToUtf8;
+    using alpheratz::common::locale::Transcoder;
+    std::string out;
+    // long ascii runs around cjk, 4 byte codes and the euro sign each charset handles alone
+    std::string text = std::string(40, 'x') + "\xc4\xe3" + std::string(17, 'y') + "\xba\xc3z";
+    ASSERT_TRUE(GbkToUtf8(text, &out).ok());
+    EXPECT_EQ(out, std::string(40, 'x') + "\xe4\xbd\xa0" + std::string(17, 'y') + "\xe5\xa5\xbdz");
+    ASSERT_TRUE(GbkToUtf8("\x80", &out, GbkCharset::kGbk).ok());
+    EXPECT_EQ(out, "\xe2\x82\xac");
+    EXPECT_FALSE(GbkToUtf8("\x80", &out, GbkCharset::kGb18030).ok());
+    ASSERT_TRUE(GbkToUtf8("a\x94\x39\xfc\x36", &out, GbkCharset::kGb18030).ok());
+    EXPECT_EQ(out, "a\xf0\x9f\x98\x80");
+
+    // every two byte code agrees with iconv, on success and on error
+    for (GbkCharset charset : {GbkCharset::kGbk, GbkCharset::kGb18030}) {
+        auto transcoder =
+            Transcoder::Create("UTF-8", charset == GbkCharset::kGbk ? "GBK" : "GB18030");
+        ASSERT_TRUE(transcoder.ok());
+        std::string expect;
+        for (int lead = 0x80; lead <= 0xff; ++lead) {
+            for (int trail = 0; trail <= 0xff; ++trail) {
+                std::string code = {static_cast<char>(lead), static_cast<char>(trail)};
+                bool ok = transcoder->Convert(code, &expect).ok();
+                ASSERT_EQ(GbkToUtf8(code, &out, charset).ok(), ok) << lead << " " << trail;
+                if (ok) {
+                    ASSERT_EQ(out, expect) << lead << " " << trail;
+                }
+            }
+        }
+    }
+
+    // bad bytes keep what came before them
+    EXPECT_FALSE(GbkToUtf8("ab\xc4\xe3\xff", &out).ok());
+    EXPECT_EQ(out, "ab\xe4\xbd\xa0");
+    EXPECT_FALSE(GbkToUtf8("ab\xc4", &out).ok());
+    EXPECT_EQ(out, "ab");
+}
+
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
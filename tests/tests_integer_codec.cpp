@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <alpheratz/compress/integer_codec.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace alpheratz::compress;
+
+TEST(TestIntegerCodec, TestVarintZigZag) {
+    std::string data;
+    std::vector<uint64_t> values = {0, 1, 127, 128, 300, 1ull << 35, UINT64_MAX};
+    for (uint64_t value : values) {
+        size_t before = data.size();
+        PutVarint(&data, value);
+        EXPECT_EQ(data.size() - before, VarintLength(value));
+    }
+    EXPECT_EQ(VarintLength(UINT64_MAX), 10u);
+    const char *p = data.data(), *end = data.data() + data.size();
+    for (uint64_t value : values) {
+        uint64_t got;
+        ASSERT_TRUE(GetVarint(&p, end, &got));
+        EXPECT_EQ(got, value);
+    }
+    EXPECT_EQ(p, end);
+    uint64_t got;
+    std::string truncated = "\x80\x80";
+    p = truncated.data();
+    EXPECT_FALSE(GetVarint(&p, truncated.data() + truncated.size(), &got));
+
+    EXPECT_EQ(ZigZagEncode(0), 0u);
+    EXPECT_EQ(ZigZagEncode(-1), 1u);
+    EXPECT_EQ(ZigZagEncode(1), 2u);
+    EXPECT_EQ(ZigZagEncode(-2), 3u);
+    for (int64_t value : {int64_t{0}, int64_t{-7}, int64_t{1} << 40, INT64_MIN, INT64_MAX}) {
+        EXPECT_EQ(ZigZagDecode(ZigZagEncode(value)), value);
+    }
+
+    std::string fixed;
+    PutFixed32(&fixed, 0x01020304);
+    PutFixed64(&fixed, 0x0102030405060708ull);
+    EXPECT_EQ(fixed[0], 4);
+    EXPECT_EQ(GetFixed32(fixed.data()), 0x01020304u);
+    EXPECT_EQ(GetFixed64(fixed.data() + 4), 0x0102030405060708ull);
+}
+
+TEST(TestIntegerCodec, TestStreamVByte) {
+    std::mt19937 rng(7);
+    for (size_t count : {0, 1, 3, 4, 5, 17, 1000, 4099}) {
+        std::vector<uint32_t> values(count);
+        for (uint32_t &value : values) value = rng() >> (rng() % 32);
+        for (bool delta : {false, true}) {
+            std::string data = "head";
+            PutStreamVByte(&data, values.data(), values.size(), delta);
+            data += "tail";
+            const char *p = data.data() + 4;
+            std::vector<uint32_t> decoded = {42};
+            ASSERT_TRUE(GetStreamVByte(&p, data.data() + data.size(), &decoded, delta));
+            EXPECT_EQ(decoded, values);
+            EXPECT_STREQ(p, "tail");
+            // any cut is refused
+            std::string cut = data.substr(0, data.size() - 4);
+            for (size_t size = 4; size < cut.size(); size += 1 + size / 8) {
+                p = cut.data() + 4;
+                EXPECT_FALSE(GetStreamVByte(&p, cut.data() + size, &decoded, delta));
+            }
+        }
+    }
+
+    // sorted ids with small gaps take little more than a byte each
+    std::vector<uint32_t> ids(100000);
+    uint32_t id = 1u << 30;
+    for (uint32_t &value : ids) value = id += 1 + rng() % 200;
+    std::string data;
+    PutStreamVByte(&data, ids.data(), ids.size(), true);
+    EXPECT_LT(data.size(), ids.size() * 5 / 4 + 16);
+    const char *p = data.data();
+    std::vector<uint32_t> decoded;
+    ASSERT_TRUE(GetStreamVByte(&p, data.data() + data.size(), &decoded, true));
+    EXPECT_EQ(decoded, ids);
+}
+
+TEST(TestIntegerCodec, TestFrameOfReference) {
+    std::mt19937_64 rng(9);
+    for (size_t count : {0, 1, 127, 128, 129, 1000}) {
+        for (int bits : {0, 1, 13, 63, 64}) {
+            std::vector<int64_t> values(count);
+            int64_t base = static_cast<int64_t>(rng());
+            for (int64_t &value : values) {
+                uint64_t noise = bits == 0 ? 0 : rng() >> (64 - bits);
+                value = static_cast<int64_t>(static_cast<uint64_t>(base) + noise);
+            }
+            std::string data;
+            PutFrameOfReference(&data, values.data(), values.size());
+            const char *p = data.data();
+            std::vector<int64_t> decoded;
+            ASSERT_TRUE(GetFrameOfReference(&p, data.data() + data.size(), &decoded));
+            EXPECT_EQ(decoded, values);
+            EXPECT_EQ(p, data.data() + data.size());
+            if (count > 0) {
+                p = data.data();
+                EXPECT_FALSE(GetFrameOfReference(&p, data.data() + data.size() - 1, &decoded));
+            }
+        }
+    }
+}
+
+TEST(TestIntegerCodec, TestDeltaColumn) {
+    std::mt19937_64 rng(13);
+    // millisecond timestamps a second apart with jitter, and a clock step back
+    std::vector<int64_t> timestamps(10000);
+    int64_t now = 1760000000000;
+    for (int64_t &value : timestamps) value = now += 1000 + static_cast<int64_t>(rng() % 16) - 8;
+    timestamps[5000] -= 3600 * 1000;
+    std::string data;
+    PutDeltaColumn(&data, timestamps.data(), timestamps.size());
+    EXPECT_LT(data.size(), timestamps.size());
+    const char *p = data.data();
+    std::vector<int64_t> decoded;
+    ASSERT_TRUE(GetDeltaColumn(&p, data.data() + data.size(), &decoded));
+    EXPECT_EQ(decoded, timestamps);
+
+    // equal steps pack to nothing past the block headers
+    std::vector<int64_t> steady(12800);
+    for (size_t i = 0; i < steady.size(); ++i) steady[i] = -5 + 60 * static_cast<int64_t>(i);
+    data.clear();
+    PutDeltaColumn(&data, steady.data(), steady.size());
+    EXPECT_LT(data.size(), steady.size() / 128 * 3 + 8);
+    p = data.data();
+    ASSERT_TRUE(GetDeltaColumn(&p, data.data() + data.size(), &decoded));
+    EXPECT_EQ(decoded, steady);
+
+    std::vector<int64_t> extremes = {INT64_MAX, INT64_MIN, 0, INT64_MIN, INT64_MAX};
+    data.clear();
+    PutDeltaColumn(&data, extremes.data(), extremes.size());
+    p = data.data();
+    ASSERT_TRUE(GetDeltaColumn(&p, data.data() + data.size(), &decoded));
+    EXPECT_EQ(decoded, extremes);
+
+    data.clear();
+    PutDeltaColumn(&data, nullptr, 0);
+    p = data.data();
+    ASSERT_TRUE(GetDeltaColumn(&p, data.data() + data.size(), &decoded));
+    EXPECT_TRUE(decoded.empty());
+
+    // damaged input is refused or decodes to something, never out of bounds
+    data.clear();
+    PutDeltaColumn(&data, timestamps.data(), 300);
+    for (int i = 0; i < 500; ++i) {
+        std::string damaged = data;
+        damaged[rng() % damaged.size()] ^= static_cast<char>(1 + rng() % 255);
+        p = damaged.data();
+        GetDeltaColumn(&p, damaged.data() + damaged.size(), &decoded);
+        p = damaged.data();
+        std::vector<uint32_t> ids;
+        GetStreamVByte(&p, damaged.data() + damaged.size(), &ids, true);
+    }
+}
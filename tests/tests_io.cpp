@@ -0,0 +1,438 @@
+#include <gtest/gtest.h>
+#include <alpheratz/compress/zstd.h>
+#include <alpheratz/io/async_io.h>
+#include <alpheratz/io/line_pipeline.h>
+#include <alpheratz/io/sorted_table.h>
+#include <alpheratz/io/unique_handle.h>
+#include <alpheratz/io/writer.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using alpheratz::io::AsyncIo;
+using alpheratz::io::AsyncIoOptions;
+using alpheratz::io::IoKind;
+using alpheratz::io::IoOp;
+using alpheratz::io::LineBatch;
+using alpheratz::io::LinePipeline;
+using alpheratz::io::PipelineCompression;
+using alpheratz::io::PipelineOptions;
+using alpheratz::io::PipelineSource;
+using alpheratz::io::SortedTable;
+using alpheratz::io::SortedTableBuilder;
+using alpheratz::io::SortedTableOptions;
+using alpheratz::io::SyncPolicy;
+using alpheratz::io::UniqueFd;
+using alpheratz::io::UniqueMmap;
+using alpheratz::io::Writer;
+using alpheratz::io::WriterOptions;
+
+namespace {
+
+std::string ReadAll(const std::string &path) {
+    std::ifstream input(path, std::ios::binary);
+    std::stringstream content;
+    content << input.rdbuf();
+    return content.str();
+}
+
+std::string Decompress(const std::string &frame) {
+    alpheratz::compress::UniqueZstdDCtx dctx(ZSTD_createDCtx());
+    std::string out;
+    char buf[4096];
+    ZSTD_inBuffer in = {frame.data(), frame.size(), 0};
+    ZSTD_outBuffer dst = {buf, sizeof(buf), sizeof(buf)};
+    // a full output buffer may leave decoded bytes inside the context
+    while (in.pos < in.size || dst.pos == dst.size) {
+        dst.pos = 0;
+        size_t ret = ZSTD_decompressStream(dctx.Get(), &dst, &in);
+        EXPECT_FALSE(ZSTD_isError(ret));
+        if (ZSTD_isError(ret)) break;
+        out.append(buf, dst.pos);
+    }
+    return out;
+}
+
+// small and large pieces, so both the buffer and the writev path are taken
+std::string WriteSample(Writer *writer) {
+    std::string expect;
+    for (int i = 0; i < 200; ++i) {
+        std::string line = "line " + std::to_string(i) + "\n";
+        std::string big(i % 50 == 0 ? 10000 : 0, static_cast<char>('a' + i % 26));
+        absl::string_view parts[] = {line, big};
+        EXPECT_TRUE(writer->Append(parts, 2).ok());
+        expect += line + big;
+    }
+    return expect;
+}
+
+}  // namespace
+
+TEST(TestIo, TestWriterBuffered) {
+    std::string path = testing::TempDir() + "/writer_buffered.txt";
+    WriterOptions options;
+    options.buffer_size = 100;
+    options.sync = SyncPolicy::kOnClose;
+    auto writer = Writer::Open(path, options);
+    ASSERT_TRUE(writer.ok()) << writer.status();
+    std::string expect = WriteSample(writer->get());
+    ASSERT_TRUE((*writer)->Flush().ok());
+    EXPECT_EQ(ReadAll(path), expect);
+    ASSERT_TRUE((*writer)->Append("tail").ok());
+    ASSERT_TRUE((*writer)->Close().ok());
+    EXPECT_EQ(ReadAll(path), expect + "tail");
+    EXPECT_EQ((*writer)->BytesWritten(), expect.size() + 4);
+    EXPECT_FALSE((*writer)->Append("more").ok());
+
+    options.append = true;
+    writer = Writer::Open(path, options);
+    ASSERT_TRUE(writer.ok());
+    ASSERT_TRUE((*writer)->Append("!").ok());
+    writer->reset();
+    EXPECT_EQ(ReadAll(path), expect + "tail!");
+}
+
+TEST(TestIo, TestWriterDirect) {
+    std::string path = testing::TempDir() + "/writer_direct.txt";
+    WriterOptions options;
+    options.direct = true;
+    options.buffer_size = 3 * Writer::kAlignment;
+    options.sync = SyncPolicy::kOnFlush;
+    auto writer = Writer::Open(path, options);
+    ASSERT_TRUE(writer.ok()) << writer.status();
+    std::string expect = WriteSample(writer->get());
+    ASSERT_TRUE((*writer)->Sync().ok());
+    ASSERT_TRUE((*writer)->Close().ok());
+    EXPECT_EQ(ReadAll(path), expect);
+}
+
+TEST(TestIo, TestWriterZstd) {
+    std::string path = testing::TempDir() + "/writer.zst";
+    WriterOptions options;
+    options.zstd = true;
+    options.buffer_size = 1;
+    auto writer = Writer::Open(path, options);
+    ASSERT_TRUE(writer.ok()) << writer.status();
+    std::string expect = WriteSample(writer->get());
+    // a flushed stream decompresses up to the flush
+    ASSERT_TRUE((*writer)->Flush().ok());
+    EXPECT_EQ(Decompress(ReadAll(path)), expect);
+    ASSERT_TRUE((*writer)->Append("end").ok());
+    ASSERT_TRUE((*writer)->Close().ok());
+    EXPECT_EQ(Decompress(ReadAll(path)), expect + "end");
+    EXPECT_EQ((*writer)->BytesAppended(), expect.size() + 3);
+    EXPECT_LT((*writer)->BytesWritten(), expect.size());
+}
+
+TEST(TestIo, TestWriterOpenError) {
+    auto writer = Writer::Open(testing::TempDir() + "/no/such/dir/file");
+    EXPECT_TRUE(absl::IsNotFound(writer.status())) << writer.status();
+}
+
+void CheckAsyncIo(AsyncIo *engine) {
+    std::string path = testing::TempDir() + "/async_io.bin";
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    std::string data;
+    for (int i = 0; i < 100000; ++i) {
+        data += static_cast<char>('a' + i % 26);
+    }
+    auto written = engine->Write(fd, data.data(), data.size(), 0).get();
+    ASSERT_TRUE(written.ok()) << written.status();
+    EXPECT_EQ(*written, data.size());
+
+    // a batch of reads over the file, the last one runs past its end
+    constexpr size_t kPiece = 7000;
+    std::vector<std::string> pieces(data.size() / kPiece + 1, std::string(kPiece, '\0'));
+    std::vector<size_t> sizes(pieces.size());
+    std::promise<void> all_done;
+    std::atomic<size_t> left{pieces.size()};
+    std::vector<IoOp> ops;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        IoOp op;
+        op.kind = IoKind::kRead;
+        op.fd = fd;
+        op.buffer = &pieces[i][0];
+        op.size = kPiece;
+        op.offset = i * kPiece;
+        op.done = [&, i](absl::StatusOr<size_t> result) {
+            sizes[i] = result.ok() ? *result : 0;
+            if (left.fetch_sub(1) == 1) all_done.set_value();
+        };
+        ops.push_back(std::move(op));
+    }
+    engine->Submit(std::move(ops));
+    all_done.get_future().wait();
+    std::string read;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        read += pieces[i].substr(0, sizes[i]);
+    }
+    EXPECT_EQ(read, data);
+    EXPECT_EQ(sizes.back(), data.size() % kPiece);
+
+    char byte;
+    auto failed = engine->Read(-1, &byte, 1, 0).get();
+    EXPECT_FALSE(failed.ok());
+    ::close(fd);
+}
+
+TEST(TestIo, TestAsyncIo) {
+    CheckAsyncIo(&AsyncIo::Get());
+    std::cout << "backend: " << AsyncIo::Get().BackendName() << std::endl;
+    // batches many times the ring size wait for free entries
+    AsyncIoOptions small;
+    small.queue_depth = 4;
+    AsyncIo small_ring(small);
+    CheckAsyncIo(&small_ring);
+    AsyncIoOptions options;
+    options.force_threads = true;
+    options.threads = 2;
+    AsyncIo threads(options);
+    EXPECT_STREQ(threads.BackendName(), "threads");
+    CheckAsyncIo(&threads);
+}
+
+TEST(TestIo, TestUniqueHandle) {
+    std::string path = testing::TempDir() + "/unique_handle.txt";
+    UniqueFd fd(::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644));
+    ASSERT_TRUE(fd.Valid());
+    ASSERT_EQ(::write(fd.Get(), "handle", 6), 6);
+
+    // moves leave the source empty, containers hold handles directly
+    std::vector<UniqueFd> fds;
+    fds.push_back(std::move(fd));
+    EXPECT_FALSE(fd.Valid());
+    int raw = fds[0].Get();
+    fds.clear();
+    EXPECT_EQ(::fcntl(raw, F_GETFD), -1);
+
+    UniqueFd other(::open(path.c_str(), O_RDONLY));
+    raw = other.Release();
+    EXPECT_FALSE(other.Valid());
+    EXPECT_NE(::fcntl(raw, F_GETFD), -1);
+    other.Reset(raw);
+    other.Reset();
+    EXPECT_EQ(::fcntl(raw, F_GETFD), -1);
+
+    UniqueFd reader(::open(path.c_str(), O_RDONLY));
+    UniqueMmap mapped({::mmap(nullptr, 6, PROT_READ, MAP_PRIVATE, reader.Get(), 0), 6});
+    ASSERT_TRUE(mapped.Valid());
+    EXPECT_EQ(std::string(static_cast<const char *>(mapped.Get().data), 6), "handle");
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+// every line the pipeline produced, with its fields joined by '|'
+std::vector<std::string> RunPipeline(const std::string &path, const PipelineOptions &options,
+                                     absl::Status *status) {
+    std::vector<std::string> lines;
+    LinePipeline pipeline(options);
+    *status = pipeline.Run(path, [&lines](const LineBatch &batch) {
+        EXPECT_EQ(batch.first_line, lines.size());
+        for (size_t i = 0; i < batch.lines.size(); ++i) {
+            std::string line(batch.lines[i]);
+            for (absl::string_view field : batch.Fields(i)) {
+                line += "|" + std::string(field);
+            }
+            lines.push_back(line);
+        }
+    });
+    if (status->ok()) {
+        EXPECT_EQ(pipeline.Stats().back().name, "process");
+        EXPECT_EQ(pipeline.Stats().back().items, (lines.size() + 4) / 5);
+    }
+    return lines;
+}
+
+TEST(TestIo, TestLinePipeline) {
+    std::string text;
+    std::vector<std::string> expect;
+    std::vector<std::string> expect_fields;
+    for (int i = 0; i < 3000; ++i) {
+        std::string line = i % 7 == 0 ? "" : "k" + std::to_string(i) + "\t" +
+                                                  std::string(i % 300, 'v') + "\tend";
+        text += line + "\n";
+        expect.push_back(line);
+        std::string fields = line + "|" + (line.empty() ? "" : "k" + std::to_string(i));
+        if (!line.empty()) fields += "|" + std::string(i % 300, 'v') + "|end";
+        expect_fields.push_back(fields);
+    }
+    text += "last";
+    expect.push_back("last");
+    expect_fields.push_back("last|last");
+    std::string path = testing::TempDir() + "/pipeline.txt";
+    std::ofstream(path, std::ios::binary) << text;
+
+    WriterOptions writer_options;
+    writer_options.zstd = true;
+    std::string zst_path = testing::TempDir() + "/pipeline.txt.zst";
+    auto writer = Writer::Open(zst_path, writer_options);
+    ASSERT_TRUE(writer.ok());
+    ASSERT_TRUE((*writer)->Append(text).ok());
+    ASSERT_TRUE((*writer)->Close().ok());
+
+    // blocks much smaller than lines stitch lines across many blocks
+    for (size_t block_size : {size_t(7), size_t(4096), size_t(1) << 20}) {
+        for (auto source : {PipelineSource::kRead, PipelineSource::kMmap}) {
+            PipelineOptions options;
+            options.source = source;
+            options.block_size = block_size;
+            options.queue_depth = 2;
+            options.lines_per_batch = 5;
+            absl::Status status;
+            EXPECT_EQ(RunPipeline(path, options, &status), expect);
+            EXPECT_TRUE(status.ok()) << status;
+            EXPECT_EQ(RunPipeline(zst_path, options, &status), expect);
+            EXPECT_TRUE(status.ok()) << status;
+            options.delimiter = "\t";
+            EXPECT_EQ(RunPipeline(zst_path, options, &status), expect_fields);
+            EXPECT_TRUE(status.ok()) << status;
+        }
+    }
+
+    PipelineOptions options;
+    options.compression = PipelineCompression::kNone;
+    LinePipeline pipeline(options);
+    size_t bytes = 0;
+    ASSERT_TRUE(pipeline.Run(zst_path, [&bytes](const LineBatch &batch) {
+        for (absl::string_view line : batch.lines) bytes += line.size() + 1;
+    }).ok());
+    EXPECT_EQ(bytes, ReadAll(zst_path).size() + (ReadAll(zst_path).back() == '\n' ? 0 : 1));
+    ASSERT_EQ(pipeline.Stats().size(), 3u);
+    EXPECT_EQ(pipeline.Stats()[0].name, "read");
+    EXPECT_EQ(pipeline.Stats()[0].bytes, ReadAll(zst_path).size());
+}
+
+TEST(TestIo, TestLinePipelineError) {
+    absl::Status status;
+    RunPipeline(testing::TempDir() + "/no_such_pipeline_input", {}, &status);
+    EXPECT_TRUE(absl::IsNotFound(status)) << status;
+
+    // a zstd frame cut short
+    std::string zst_path = testing::TempDir() + "/pipeline_cut.zst";
+    auto writer = Writer::Open(zst_path, [] {
+        WriterOptions options;
+        options.zstd = true;
+        return options;
+    }());
+    ASSERT_TRUE(writer.ok());
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_TRUE((*writer)->Append("line " + std::to_string(i) + "\n").ok());
+    }
+    ASSERT_TRUE((*writer)->Close().ok());
+    std::string frame = ReadAll(zst_path);
+    std::ofstream(zst_path, std::ios::binary | std::ios::trunc)
+        << frame.substr(0, frame.size() / 2);
+    PipelineOptions options;
+    options.block_size = 64;
+    RunPipeline(zst_path, options, &status);
+    EXPECT_TRUE(absl::IsDataLoss(status)) << status;
+
+    // an exception from the callback stops the stages and reaches the caller
+    std::string path = testing::TempDir() + "/pipeline_throw.txt";
+    std::ofstream(path) << "a\nb\n";
+    LinePipeline pipeline(options);
+    EXPECT_THROW(pipeline.Run(path,
+                              [](const LineBatch &) { throw std::runtime_error("stop"); }),
+                 std::runtime_error);
+    // the stages of that run are done, the pipeline runs again on the same workers
+    size_t lines = 0;
+    EXPECT_TRUE(pipeline.Run(path, [&lines](const LineBatch &batch) {
+        lines += batch.lines.size();
+    }).ok());
+    EXPECT_EQ(lines, 2u);
+}
+
+TEST(TestIo, TestSortedTable) {
+    std::string path = testing::TempDir() + "/table.sst";
+    SortedTableOptions options;
+    options.block_size = 128;
+    auto builder = SortedTableBuilder::Create(path, options);
+    ASSERT_TRUE(builder.ok()) << builder.status();
+    std::vector<std::string> keys;
+    for (int i = 0; i < 5000; ++i) {
+        char key[32];
+        snprintf(key, sizeof(key), "user/%05d/name", i * 2);
+        keys.push_back(key);
+        ASSERT_TRUE((*builder)->Add(key, "value" + std::to_string(i)).ok());
+    }
+    EXPECT_TRUE(absl::IsInvalidArgument((*builder)->Add("user/00000/name", "x")));
+    ASSERT_TRUE((*builder)->Finish().ok());
+
+    auto table = SortedTable::Open(path);
+    ASSERT_TRUE(table.ok()) << table.status();
+    EXPECT_EQ((*table)->Entries(), 5000u);
+    absl::string_view value;
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_TRUE((*table)->Find(keys[i], &value)) << keys[i];
+        EXPECT_EQ(value, "value" + std::to_string(i));
+    }
+    EXPECT_FALSE((*table)->Find("a", &value));
+    EXPECT_FALSE((*table)->Find("user/00001/name", &value));
+    EXPECT_FALSE((*table)->Find("user/00002/nam", &value));
+    EXPECT_FALSE((*table)->Find("zzz", &value));
+
+    std::vector<std::string> scanned;
+    (*table)->ScanPrefix("user/001", [&scanned](absl::string_view key, absl::string_view) {
+        scanned.emplace_back(key);
+        return true;
+    });
+    ASSERT_EQ(scanned.size(), 50u);
+    EXPECT_EQ(scanned.front(), "user/00100/name");
+    EXPECT_EQ(scanned.back(), "user/00198/name");
+    int visited = 0;
+    (*table)->ScanPrefix("user/", [&visited](absl::string_view, absl::string_view) {
+        return ++visited < 3;
+    });
+    EXPECT_EQ(visited, 3);
+
+    SortedTable::Iterator it(table->get());
+    size_t count = 0;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) {
+        ASSERT_EQ(it.Key(), keys[count]);
+        ++count;
+    }
+    EXPECT_EQ(count, keys.size());
+}
+
+TEST(TestIo, TestBuildSortedTable) {
+    std::string text_path = testing::TempDir() + "/dict.txt";
+    std::ofstream(text_path) << "# comment\npear\t3\napple\t1\n\nfig\napple\t2\nkiwi\ta\tb\n";
+    std::string path = testing::TempDir() + "/dict.sst";
+    SortedTableOptions options;
+    options.exclude = "#";
+    ASSERT_TRUE(alpheratz::io::BuildSortedTable(text_path, path, options).ok());
+    auto table = SortedTable::Open(path);
+    ASSERT_TRUE(table.ok()) << table.status();
+    EXPECT_EQ((*table)->Entries(), 4u);
+    absl::string_view value;
+    ASSERT_TRUE((*table)->Find("apple", &value));
+    EXPECT_EQ(value, "2");
+    ASSERT_TRUE((*table)->Find("fig", &value));
+    EXPECT_EQ(value, "");
+    ASSERT_TRUE((*table)->Find("kiwi", &value));
+    EXPECT_EQ(value, "a\tb");
+    EXPECT_FALSE((*table)->Find("# comment", &value));
+
+    // empty tables and files that are not tables
+    std::string empty_path = testing::TempDir() + "/empty.sst";
+    auto builder = SortedTableBuilder::Create(empty_path);
+    ASSERT_TRUE(builder.ok());
+    ASSERT_TRUE((*builder)->Finish().ok());
+    auto empty = SortedTable::Open(empty_path);
+    ASSERT_TRUE(empty.ok()) << empty.status();
+    EXPECT_FALSE((*empty)->Find("", &value));
+    EXPECT_TRUE(absl::IsDataLoss(SortedTable::Open(text_path).status()));
+    EXPECT_TRUE(absl::IsNotFound(SortedTable::Open(path + ".missing").status()));
+}
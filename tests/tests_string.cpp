@@ -0,0 +1,322 @@
+#include <gtest/gtest.h>
+#include <alpheratz/string/double_array_trie.h>
+#include <alpheratz/string/string_arena.h>
+#include <alpheratz/string/string_interner.h>
+#include <alpheratz/string/string_map.h>
+#include <alpheratz/string/utf8.h>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <random>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace alpheratz::string;
+
+TEST(TestString, TestValidateUtf8) {
+    EXPECT_TRUE(IsValidUtf8(""));
+    EXPECT_TRUE(IsValidUtf8("abc \xe4\xbd\xa0\xe5\xa5\xbd \xc2\xa9 \xf0\x9f\x98\x80"));
+    // overlong, surrogate, past U+10FFFF, stray continuation, bad lead
+    EXPECT_EQ(FindInvalidUtf8("ab\xc0\xaf"), 2u);
+    EXPECT_EQ(FindInvalidUtf8("ab\xe0\x80\xaf"), 2u);
+    EXPECT_EQ(FindInvalidUtf8("a\xed\xa0\x80"), 1u);
+    EXPECT_EQ(FindInvalidUtf8("a\xf4\x90\x80\x80"), 1u);
+    EXPECT_EQ(FindInvalidUtf8("a\x80"), 1u);
+    EXPECT_EQ(FindInvalidUtf8("a\xff"), 1u);
+
+    // errors and cut sequences at every position around the 64 byte blocks
+    std::string ch = "\xe4\xbd\xa0";
+    for (size_t prefix = 0; prefix < 140; ++prefix) {
+        std::string text(prefix, 'a');
+        EXPECT_TRUE(IsValidUtf8(text + ch)) << prefix;
+        EXPECT_EQ(FindInvalidUtf8(text + ch.substr(0, 2)), prefix) << prefix;
+        EXPECT_EQ(FindInvalidUtf8(text + ch.substr(0, 2) + std::string(70, 'b')), prefix);
+        EXPECT_EQ(FindInvalidUtf8(text + "\xbd" + std::string(70, 'b')), prefix);
+    }
+}
+
+TEST(TestString, TestCountCodePoints) {
+    EXPECT_EQ(CountCodePoints(""), 0u);
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += i % 3 == 0 ? "\xe4\xbd\xa0" : (i % 3 == 1 ? "\xf0\x9f\x98\x80" : "a");
+    }
+    EXPECT_EQ(CountCodePoints(text), 5000u);
+}
+
+TEST(TestString, TestUtf8Convert) {
+    std::string utf8 = std::string(20, 'x') + "\xe4\xbd\xa0\xc2\xa9\xf0\x9f\x98\x80" +
+                       std::string(20, 'y');
+    std::u16string utf16;
+    ASSERT_TRUE(Utf8ToUtf16(utf8, &utf16).ok());
+    EXPECT_EQ(utf16, std::u16string(20, u'x') + u"你©\U0001f600" +
+                         std::u16string(20, u'y'));
+    std::u32string utf32;
+    ASSERT_TRUE(Utf8ToUtf32(utf8, &utf32).ok());
+    EXPECT_EQ(utf32, std::u32string(20, U'x') + U"你©\U0001f600" +
+                         std::u32string(20, U'y'));
+
+    std::string back;
+    ASSERT_TRUE(Utf16ToUtf8(utf16, &back).ok());
+    EXPECT_EQ(back, utf8);
+    ASSERT_TRUE(Utf32ToUtf8(utf32, &back).ok());
+    EXPECT_EQ(back, utf8);
+
+    EXPECT_FALSE(Utf8ToUtf16("a\xc3", &utf16).ok());
+    EXPECT_TRUE(utf16.empty());
+    EXPECT_FALSE(Utf16ToUtf8(std::u16string(1, 0xd800), &back).ok());
+    EXPECT_FALSE(Utf16ToUtf8(std::u16string(1, 0xdc00) + u"a", &back).ok());
+    EXPECT_FALSE(Utf32ToUtf8(std::u32string(1, 0x110000), &back).ok());
+    EXPECT_FALSE(Utf32ToUtf8(std::u32string(1, 0xdfff), &back).ok());
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
+
+TEST(TestString, TestStringArena) {
+    StringArena arena(256);
+    std::vector<absl::string_view> views;
+    for (int i = 0; i < 1000; ++i) {
+        views.push_back(arena.Copy("key-" + std::to_string(i)));
+    }
+    // large values get their own block
+    std::string big(1000, 'b');
+    absl::string_view big_view = arena.Copy(big);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(views[i], "key-" + std::to_string(i));
+    }
+    EXPECT_EQ(big_view, big);
+    EXPECT_TRUE(arena.Copy("").empty());
+    EXPECT_GE(arena.BytesReserved(), arena.BytesUsed());
+    arena.Clear();
+    EXPECT_EQ(arena.BytesUsed(), 0u);
+}
+
+TEST(TestString, TestStringMap) {
+    StringMap<int> map;
+    map["alpha"] = 1;
+    std::string beta = "beta";
+    map.emplace(beta, 2);
+    // lookups by view or literal do not build a std::string
+    absl::string_view key = absl::string_view("alphabet").substr(0, 5);
+    ASSERT_NE(map.find(key), map.end());
+    EXPECT_EQ(map.find(key)->second, 1);
+    EXPECT_TRUE(map.contains("beta"));
+    EXPECT_FALSE(map.contains("gamma"));
+
+    ArenaStringMap<std::unique_ptr<int>> arena_map(128);
+    for (int i = 0; i < 5000; ++i) {
+        std::string name = "word" + std::to_string(i);
+        auto inserted = arena_map.try_emplace(name, new int(i));
+        EXPECT_TRUE(inserted.second);
+    }
+    auto again = arena_map.try_emplace("word7", new int(-1));
+    EXPECT_FALSE(again.second);
+    EXPECT_EQ(*again.first->second, 7);
+    EXPECT_EQ(arena_map.size(), 5000u);
+    for (int i = 0; i < 5000; i += 97) {
+        auto it = arena_map.find("word" + std::to_string(i));
+        ASSERT_NE(it, arena_map.end());
+        EXPECT_EQ(*it->second, i);
+    }
+    EXPECT_EQ(arena_map.erase("word1"), 1u);
+    EXPECT_FALSE(arena_map.contains("word1"));
+    EXPECT_EQ(arena_map["fresh"], nullptr);
+    EXPECT_GT(arena_map.arena().BytesUsed(), 5000u * 5);
+    arena_map.clear();
+    EXPECT_TRUE(arena_map.empty());
+}
+
+TEST(TestString, TestStringInterner) {
+    StringInterner interner(4);
+    EXPECT_EQ(interner.Find("a"), StringInterner::kNotFound);
+    EXPECT_EQ(interner.Intern("a"), 0u);
+    EXPECT_EQ(interner.Intern("b"), 1u);
+    EXPECT_EQ(interner.Intern(""), 2u);
+    EXPECT_EQ(interner.Intern("a"), 0u);
+    EXPECT_EQ(interner.Find(""), 2u);
+    // ids and names survive many table and chunk growths
+    for (int i = 0; i < 100000; ++i) {
+        ASSERT_EQ(interner.Intern("term" + std::to_string(i)), static_cast<uint32_t>(i + 3));
+    }
+    EXPECT_EQ(interner.Size(), 100003u);
+    for (int i = 0; i < 100000; i += 777) {
+        EXPECT_EQ(interner.Name(i + 3), "term" + std::to_string(i));
+        EXPECT_EQ(interner.Find("term" + std::to_string(i)), static_cast<uint32_t>(i + 3));
+    }
+    EXPECT_EQ(interner.Name(0), "a");
+    EXPECT_EQ(interner.Name(2), "");
+    EXPECT_EQ(interner.Name(200000), "");
+    EXPECT_GT(interner.BytesUsed(), 100000u * 5);
+    uint32_t shared = StringInterner::Get().Intern("shared");
+    EXPECT_EQ(StringInterner::Get().Find("shared"), shared);
+}
+
+TEST(TestString, TestStringInternerConcurrent) {
+    StringInterner interner;
+    const int kThreads = 4;
+    const int kStrings = 20000;
+    std::vector<std::vector<uint32_t>> ids(kThreads, std::vector<uint32_t>(kStrings));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            // every thread interns the same strings in a different order, the steps
+            // are coprime with kStrings
+            const int kSteps[] = {1, 3, 7, 9};
+            for (int k = 0; k < kStrings; ++k) {
+                int i = (k * kSteps[t] * 7919) % kStrings;
+                uint32_t id = interner.Intern("s" + std::to_string(i));
+                ids[t][i] = id;
+                if (interner.Name(id) != "s" + std::to_string(i)) {
+                    ADD_FAILURE() << i;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(interner.Size(), static_cast<size_t>(kStrings));
+    for (int t = 1; t < kThreads; ++t) {
+        EXPECT_EQ(ids[t], ids[0]);
+    }
+}
+
+TEST(TestString, TestDoubleArrayTrie) {
+    // 中国, 中国人, 国人, 人民
+    std::string zhong = "\xe4\xb8\xad", guo = "\xe5\x9b\xbd", ren = "\xe4\xba\xba",
+                min = "\xe6\xb0\x91";
+    auto trie = DoubleArrayTrie::Build({{zhong + guo, 1},
+                                        {zhong + guo + ren, 2},
+                                        {guo + ren, 3},
+                                        {ren + min, 4},
+                                        {"a", 5},
+                                        {"ab", 6},
+                                        {"a", 7}});
+    ASSERT_TRUE(trie.ok()) << trie.status();
+    const DoubleArrayTrie &dict = **trie;
+    EXPECT_EQ(dict.Size(), 6u);
+    EXPECT_EQ(dict.Find(zhong + guo), 1u);
+    EXPECT_EQ(dict.Find("a"), 7u);
+    EXPECT_EQ(dict.Find(zhong), DoubleArrayTrie::kNotFound);
+    EXPECT_EQ(dict.Find("abc"), DoubleArrayTrie::kNotFound);
+    EXPECT_EQ(dict.Find(""), DoubleArrayTrie::kNotFound);
+
+    uint32_t value = 0;
+    EXPECT_EQ(dict.LongestPrefix(zhong + guo + ren + min, &value), 9u);
+    EXPECT_EQ(value, 2u);
+    EXPECT_EQ(dict.LongestPrefix(guo + zhong, &value), 0u);
+    std::vector<std::pair<size_t, uint32_t>> prefixes;
+    dict.CommonPrefixes("abc",
+                        [&](size_t length, uint32_t v) { prefixes.emplace_back(length, v); });
+    EXPECT_EQ(prefixes, (std::vector<std::pair<size_t, uint32_t>>{{1, 7}, {2, 6}}));
+
+    std::string text = "x" + zhong + guo + ren + min + "ab";
+    std::vector<std::tuple<size_t, size_t, uint32_t>> matches;
+    dict.Scan(text, [&](const TrieMatch &m) { matches.emplace_back(m.begin, m.length, m.value); });
+    EXPECT_EQ(matches, (std::vector<std::tuple<size_t, size_t, uint32_t>>{
+                           {1, 6, 1}, {1, 9, 2}, {4, 6, 3}, {7, 6, 4}, {13, 1, 7}, {13, 2, 6}}));
+    std::vector<TrieMatch> longest = dict.ScanLongest(text);
+    ASSERT_EQ(longest.size(), 2u);
+    EXPECT_EQ(longest[0].begin, 1u);
+    EXPECT_EQ(longest[0].value, 2u);
+    // 人民 overlaps 中国人, 民 alone is skipped as one code point
+    EXPECT_EQ(longest[1].begin, 13u);
+    EXPECT_EQ(longest[1].value, 6u);
+
+    EXPECT_FALSE(DoubleArrayTrie::Build({{"", 1}}).ok());
+    EXPECT_FALSE(DoubleArrayTrie::Build({{"a", DoubleArrayTrie::kNotFound}}).ok());
+    auto empty = DoubleArrayTrie::Build({});
+    ASSERT_TRUE(empty.ok());
+    EXPECT_EQ((*empty)->Find("a"), DoubleArrayTrie::kNotFound);
+    (*empty)->Scan("abc", [](const TrieMatch &) { ADD_FAILURE(); });
+}
+
+TEST(TestString, TestDoubleArrayTrieScan) {
+    // random keys over a small alphabet of ascii and cjk, so they share many prefixes
+    // and suffixes, checked against a brute force search
+    const char *kAlphabet[] = {"a", "b", "\xe4\xb8\xad", "\xe5\x9b\xbd", "\xf0\x9f\x98\x80"};
+    std::mt19937 rng(7);
+    std::map<std::string, uint32_t> keys;
+    std::vector<std::pair<std::string, uint32_t>> entries;
+    for (uint32_t i = 0; i < 3000; ++i) {
+        std::string key;
+        for (size_t n = 1 + rng() % 6; n > 0; --n) key += kAlphabet[rng() % 5];
+        keys[key] = i;
+        entries.emplace_back(key, i);
+    }
+    auto trie = DoubleArrayTrie::Build(entries);
+    ASSERT_TRUE(trie.ok());
+    EXPECT_EQ((*trie)->Size(), keys.size());
+    for (const auto &key : keys) {
+        ASSERT_EQ((*trie)->Find(key.first), key.second) << key.first;
+    }
+
+    std::string text;
+    for (int i = 0; i < 2000; ++i) text += kAlphabet[rng() % 5];
+    std::vector<std::tuple<size_t, size_t, uint32_t>> expected, actual;
+    auto collect = [&](const TrieMatch &m) { actual.emplace_back(m.begin, m.length, m.value); };
+    for (size_t end = 1; end <= text.size(); ++end) {
+        // keys have at most 6 code points of at most 4 bytes
+        for (size_t length = std::min<size_t>(end, 24); length > 0; --length) {
+            auto it = keys.find(text.substr(end - length, length));
+            if (it != keys.end()) expected.emplace_back(end - length, length, it->second);
+        }
+    }
+    (*trie)->Scan(text, collect);
+    EXPECT_EQ(actual, expected);
+
+    // serialized tries match the same, damaged ones are refused or stay safe to use
+    std::string data;
+    (*trie)->Serialize(&data);
+    auto copy = DoubleArrayTrie::Deserialize(data);
+    ASSERT_TRUE(copy.ok()) << copy.status();
+    actual.clear();
+    (*copy)->Scan(text, collect);
+    EXPECT_EQ(actual, expected);
+    EXPECT_FALSE(DoubleArrayTrie::Deserialize(data.substr(0, data.size() - 4)).ok());
+    for (int i = 0; i < 200; ++i) {
+        std::string damaged = data;
+        damaged[24 + rng() % (damaged.size() - 24)] ^= static_cast<char>(1 + rng() % 255);
+        auto loaded = DoubleArrayTrie::Deserialize(damaged);
+        if (loaded.ok()) {
+            (*loaded)->Scan(text, [](const TrieMatch &) {});
+            (*loaded)->ScanLongest(text);
+        }
+    }
+}
+
+TEST(TestString, TestDoubleArrayTrieFile) {
+    std::string text_path = testing::TempDir() + "/terms.txt";
+    std::ofstream(text_path) << "# terms\nhello\tgreeting\n\nworld\nhello world\n";
+    TrieFileOptions options;
+    options.exclude = "#";
+    auto trie = DoubleArrayTrie::BuildFromFile(text_path, options);
+    ASSERT_TRUE(trie.ok()) << trie.status();
+    // values are the indexes of the loaded lines
+    EXPECT_EQ((*trie)->Size(), 3u);
+    EXPECT_EQ((*trie)->Find("hello"), 0u);
+    EXPECT_EQ((*trie)->Find("world"), 1u);
+    EXPECT_EQ((*trie)->Find("hello world"), 2u);
+
+    std::string path = testing::TempDir() + "/terms.dat";
+    ASSERT_TRUE((*trie)->Save(path).ok());
+    auto loaded = DoubleArrayTrie::Load(path);
+    ASSERT_TRUE(loaded.ok()) << loaded.status();
+    std::vector<TrieMatch> matches = (*loaded)->ScanLongest("say hello world");
+    ASSERT_EQ(matches.size(), 1u);
+    EXPECT_EQ(matches[0].begin, 4u);
+    EXPECT_EQ(matches[0].value, 2u);
+
+    EXPECT_FALSE(DoubleArrayTrie::Load(testing::TempDir() + "/no_such_terms.dat").ok());
+    EXPECT_FALSE(DoubleArrayTrie::Load(text_path).ok());
+    std::ofstream(text_path) << "ok\n\xff\n";
+    EXPECT_FALSE(DoubleArrayTrie::BuildFromFile(text_path).ok());
+}
@@ -0,0 +1,258 @@
+#include <alpheratz/time/batch_parse.h>
+#include <alpheratz/time/civil.h>
+#include <alpheratz/time/coarse_clock.h>
+#include <alpheratz/time/datetime.h>
+#include <alpheratz/time/time_zone.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+using alpheratz::time::CivilTime;
+using alpheratz::time::CoarseClock;
+using alpheratz::time::DateTime;
+using alpheratz::time::DateTimeLayout;
+using alpheratz::time::TimeZoneCache;
+
+static void ExpectFields(const DateTime &dt, int year, int month, int day, int hour, int minute,
+                         int second) {
+    EXPECT_EQ(dt.GetYear(), year);
+    EXPECT_EQ(dt.GetMonth(), month);
+    EXPECT_EQ(dt.GetDay(), day);
+    EXPECT_EQ(dt.GetHour(), hour);
+    EXPECT_EQ(dt.GetMinute(), minute);
+    EXPECT_EQ(dt.GetSecond(), second);
+}
+
+TEST(TestDateTime, TestParseFixed) {
+    ExpectFields(DateTime::Parse("2023-06-15 12:34:56"), 2023, 6, 15, 12, 34, 56);
+    ExpectFields(DateTime::Parse("20230615123456", DATETIME_FORMAT2), 2023, 6, 15, 12, 34, 56);
+    ExpectFields(DateTime::Parse("2023-06-15", DATE_FORMAT), 2023, 6, 15, 0, 0, 0);
+    ExpectFields(DateTime::Parse<DateTimeLayout::kDateTime>("1999-12-31 23:59:60"), 1999, 12, 31,
+                 23, 59, 60);
+
+    DateTime dt(1, 1, 1, 1, 1, 1);
+    EXPECT_TRUE(DateTime::TryParse<DateTimeLayout::kDate>("2000-02-29", &dt));
+    ExpectFields(dt, 2000, 2, 29, 0, 0, 0);
+    EXPECT_FALSE(DateTime::TryParse<DateTimeLayout::kDate>("2000-13-01", &dt));
+    EXPECT_FALSE(DateTime::TryParse<DateTimeLayout::kDate>("2000-02-29 ", &dt));
+    EXPECT_FALSE(DateTime::TryParse<DateTimeLayout::kDateTime>("2000-02-29 24:00:00", &dt));
+    EXPECT_FALSE(DateTime::TryParse<DateTimeLayout::kDateTime2>("2000022912000a", &dt));
+    ExpectFields(dt, 2000, 2, 29, 0, 0, 0);
+}
+
+TEST(TestDateTime, TestParseLikeStrptime) {
+    // lenient input is still accepted through strptime
+    ExpectFields(DateTime::Parse("2023-1-5 1:2:3"), 2023, 1, 5, 1, 2, 3);
+    ExpectFields(DateTime::Parse("2023-01-05 12:30:45xyz"), 2023, 1, 5, 12, 30, 45);
+    ExpectFields(DateTime::Parse("15/06/2023 08h", "%d/%m/%Y %Hh"), 2023, 6, 15, 8, 0, 0);
+    ExpectFields(DateTime::Parse("10%", "%S%%"), 1900, 1, 0, 0, 0, 10);
+
+    const char *inputs[] = {"2023-06-15 12:34:56", "2023-6-15 12:34:56", " 2023-06-15 12:34:56",
+                            "2023-06-15 12:34:62", "2023-00-15 12:34:56", "99-06-15 00:00:00",
+                            "2023-06-15T12:34:56", "2023-06-15"};
+    const char *formats[] = {DATETIME_FORMAT, DATE_FORMAT, "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d %H"};
+    for (const char *format : formats) {
+        for (const char *input : inputs) {
+            struct tm t;
+            std::memset(&t, 0, sizeof(t));
+            if (strptime(input, format, &t) == nullptr) {
+                continue;
+            }
+            ExpectFields(DateTime::Parse(input, format), t.tm_year + 1900, t.tm_mon + 1,
+                         t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+        }
+    }
+}
+
+TEST(TestDateTime, TestToString) {
+    DateTime dt(2023, 6, 5, 7, 8, 9);
+    EXPECT_EQ(dt.ToString(), "2023-06-05 07:08:09");
+    EXPECT_EQ(dt.ToString(DATETIME_FORMAT2), "20230605070809");
+    EXPECT_EQ(dt.ToString(DATE_FORMAT), "2023-06-05");
+    EXPECT_EQ(dt.ToString<DateTimeLayout::kDate>(), "2023-06-05");
+    EXPECT_EQ(dt.ToString("%H:%M %% %Y"), "07:08 % 2023");
+    EXPECT_EQ(dt.ToString(""), "");
+
+    char buf[32];
+    EXPECT_EQ(dt.Format<DateTimeLayout::kDateTime>(buf, sizeof(buf)), 19u);
+    EXPECT_EQ(std::string(buf, 19), "2023-06-05 07:08:09");
+    EXPECT_EQ(dt.Format<DateTimeLayout::kDateTime>(buf, 10), 0u);
+
+    // formats and years the kernels skip come from strftime
+    DateTime old(999, 1, 2, 3, 4, 5);
+    EXPECT_EQ(old.ToString(DATE_FORMAT), "999-01-02");
+    EXPECT_EQ(old.Format<DateTimeLayout::kDate>(buf, sizeof(buf)), 0u);
+    EXPECT_EQ(dt.ToString("%b %d"), "Jun 05");
+
+    for (const char *format : {DATETIME_FORMAT, DATETIME_FORMAT2, DATE_FORMAT}) {
+        EXPECT_EQ(DateTime::Parse(dt.ToString(format), format).ToString(format),
+                  dt.ToString(format));
+    }
+}
+
+TEST(TestTimeZone, TestCivil) {
+    using alpheratz::time::CivilFromSeconds;
+    using alpheratz::time::SecondsFromCivil;
+    EXPECT_EQ(SecondsFromCivil(1970, 1, 1, 0, 0, 0), 0);
+    EXPECT_EQ(SecondsFromCivil(2023, 6, 15, 12, 34, 56), 1686832496);
+    EXPECT_EQ(SecondsFromCivil(1969, 12, 31, 23, 59, 59), -1);
+    // carry like mktime
+    EXPECT_EQ(SecondsFromCivil(2023, 13, 1, 0, 0, 0), SecondsFromCivil(2024, 1, 1, 0, 0, 0));
+    EXPECT_EQ(SecondsFromCivil(2024, 3, 0, 0, 0, 0), SecondsFromCivil(2024, 2, 29, 0, 0, 0));
+    EXPECT_EQ(SecondsFromCivil(2023, 1, 1, 0, 0, -1), SecondsFromCivil(2022, 12, 31, 23, 59, 59));
+
+    for (int64_t t = -5000000000LL; t < 5000000000LL; t += 86399 * 37) {
+        CivilTime c = CivilFromSeconds(t);
+        ASSERT_EQ(SecondsFromCivil(c.year, c.month, c.day, c.hour, c.minute, c.second), t);
+        time_t tt = t;
+        struct tm utc;
+        gmtime_r(&tt, &utc);
+        ASSERT_EQ(c.year, utc.tm_year + 1900);
+        ASSERT_EQ(c.month, utc.tm_mon + 1);
+        ASSERT_EQ(c.day, utc.tm_mday);
+        ASSERT_EQ(c.hour, utc.tm_hour);
+    }
+}
+
+TEST(TestTimeZone, TestTransitions) {
+    auto ny = TimeZoneCache::Load("America/New_York");
+    ASSERT_TRUE(ny.ok()) << ny.status();
+    EXPECT_EQ(*TimeZoneCache::Load("America/New_York"), *ny);
+    EXPECT_FALSE(TimeZoneCache::Load("No/Such_Zone").ok());
+    const TimeZoneCache &zone = **ny;
+
+    // 2023-03-12 02:00 EST -> 03:00 EDT at 07:00 UTC
+    EXPECT_EQ(zone.OffsetAt(1678604399), -5 * 3600);
+    EXPECT_EQ(zone.OffsetAt(1678604400), -4 * 3600);
+    CivilTime c = zone.ToCivil(1678604400);
+    EXPECT_EQ(c.hour, 3);
+    EXPECT_EQ(c.day, 12);
+    // skipped 02:30 is 03:30 EDT
+    EXPECT_EQ(zone.ToEpoch(CivilTime{2023, 3, 12, 2, 30, 0}), 1678606200);
+    // 2023-11-05 02:00 EDT -> 01:00 EST, repeated 01:30 is the EDT one
+    EXPECT_EQ(zone.ToEpoch(CivilTime{2023, 11, 5, 1, 30, 0}), 1699162200);
+    EXPECT_EQ(zone.ToEpoch(CivilTime{2023, 11, 5, 2, 0, 0}), 1699167600);
+    // past the table
+    EXPECT_EQ(zone.OffsetAt(alpheratz::time::SecondsFromCivil(2300, 1, 1, 0, 0, 0)), -5 * 3600);
+
+    EXPECT_EQ(TimeZoneCache::Utc().OffsetAt(1678604400), 0);
+    EXPECT_EQ(TimeZoneCache::Utc().ToEpoch(CivilTime{2023, 6, 15, 12, 34, 56}), 1686832496);
+}
+
+TEST(TestTimeZone, TestDateTimeTimestamp) {
+    auto shanghai = TimeZoneCache::Load("Asia/Shanghai");
+    ASSERT_TRUE(shanghai.ok());
+    DateTime dt(1686832496, **shanghai);
+    ExpectFields(dt, 2023, 6, 15, 20, 34, 56);
+    EXPECT_EQ(dt.GetTimestamp(**shanghai), 1686832496);
+    EXPECT_EQ(dt.GetTimestamp(TimeZoneCache::Utc()), 1686832496 + 8 * 3600);
+
+    DateTime now;
+    time_t t = std::time(nullptr);
+    EXPECT_LE(std::abs(now.GetTimestamp() - t), 2);
+}
+
+TEST(TestBatchParse, TestParseTimestamps) {
+    using alpheratz::time::ErrorBitmapWords;
+    using alpheratz::time::ParseTimestamps;
+    using alpheratz::time::TimeUnit;
+    std::vector<absl::string_view> rows = {"2023-06-15 12:34:56",     "2023-06-15 12:34:56.789",
+                                           "2023-06-15 12:34:56.7",   "2023-06-15 12:34:5x",
+                                           "2023-13-15 12:34:56",     "2023-06-15 12:34:56.",
+                                           "2023-06-15 12:34",        "1969-12-31 23:59:59"};
+    std::vector<int64_t> out(rows.size());
+    std::vector<uint64_t> errors(ErrorBitmapWords(rows.size()), ~uint64_t{0});
+    const TimeZoneCache &utc = TimeZoneCache::Utc();
+    EXPECT_EQ(ParseTimestamps(rows.data(), rows.size(), DateTimeLayout::kDateTime,
+                              TimeUnit::kMillis, out.data(), errors.data(), utc),
+              4u);
+    EXPECT_EQ(errors[0], 0b01111000u);
+    EXPECT_EQ(out[0], 1686832496000);
+    EXPECT_EQ(out[1], 1686832496789);
+    EXPECT_EQ(out[2], 1686832496700);
+    EXPECT_EQ(out[3], 0);
+    EXPECT_EQ(out[7], -1000);
+
+    EXPECT_EQ(ParseTimestamps(rows.data(), 2, DateTimeLayout::kDateTime, TimeUnit::kSeconds,
+                              out.data(), nullptr, utc),
+              0u);
+    EXPECT_EQ(out[1], 1686832496);
+
+    auto shanghai = TimeZoneCache::Load("Asia/Shanghai");
+    ASSERT_TRUE(shanghai.ok());
+    std::vector<absl::string_view> compact = {"20230615203456", "2023061520345", "20230615"};
+    EXPECT_EQ(ParseTimestamps(compact.data(), compact.size(), DateTimeLayout::kDateTime2,
+                              TimeUnit::kSeconds, out.data(), errors.data(), **shanghai),
+              2u);
+    EXPECT_EQ(out[0], 1686832496);
+    EXPECT_EQ(errors[0], 0b110u);
+
+    // agrees with the single row parser on a long column spanning transitions
+    auto ny = TimeZoneCache::Load("America/New_York");
+    ASSERT_TRUE(ny.ok());
+    std::vector<std::string> text;
+    for (int64_t t = 1678500000; t < 1678500000 + 300 * 86400; t += 7919) {
+        text.push_back(DateTime(t, **ny).ToString(DATE_FORMAT));
+    }
+    std::vector<absl::string_view> dates(text.begin(), text.end());
+    out.resize(dates.size());
+    errors.resize(ErrorBitmapWords(dates.size()));
+    EXPECT_EQ(ParseTimestamps(dates.data(), dates.size(), DateTimeLayout::kDate,
+                              TimeUnit::kSeconds, out.data(), errors.data(), **ny),
+              0u);
+    for (size_t i = 0; i < dates.size(); ++i) {
+        ASSERT_EQ(out[i], DateTime::Parse(text[i], DATE_FORMAT).GetTimestamp(**ny)) << text[i];
+    }
+}
+
+TEST(TestCoarseClock, TestNow) {
+    CoarseClock &clock = CoarseClock::Get();
+    for (int round = 0; round < 2; ++round) {
+        if (round == 1) {
+            ASSERT_TRUE(clock.Start(std::chrono::milliseconds(1)).ok());
+            EXPECT_TRUE(clock.Running());
+        }
+        int64_t now = std::time(nullptr);
+        EXPECT_LE(std::abs(clock.NowSeconds() - now), 1);
+        int64_t monotonic = clock.MonotonicMillis();
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        EXPECT_GE(clock.MonotonicMillis() - monotonic, 10);
+
+        std::string text = clock.NowText();
+        ASSERT_EQ(text.size(), CoarseClock::kTextSize);
+        DateTime parsed(0, 0, 0, 0, 0, 0);
+        ASSERT_TRUE(DateTime::TryParse<DateTimeLayout::kDateTime>(text, &parsed)) << text;
+        EXPECT_LE(std::abs(parsed.GetTimestamp() - clock.NowSeconds()), 1);
+    }
+
+    // readers on other threads see whole texts while the ticker rewrites them
+    std::vector<std::thread> readers;
+    std::atomic<int> bad{0};
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&clock, &bad]() {
+            char buf[CoarseClock::kTextSize];
+            DateTime parsed(0, 0, 0, 0, 0, 0);
+            for (int k = 0; k < 20000; ++k) {
+                clock.NowText(buf);
+                absl::string_view text(buf, sizeof(buf));
+                if (!DateTime::TryParse<DateTimeLayout::kDateTime>(text, &parsed)) ++bad;
+            }
+        });
+    }
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(bad.load(), 0);
+
+    clock.Stop();
+    EXPECT_FALSE(clock.Running());
+    EXPECT_LE(std::abs(clock.NowSeconds() - std::time(nullptr)), 1);
+}
+
+int main(int argc, char **argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
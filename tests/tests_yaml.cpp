@@ -40,6 +40,35 @@ TEST(TestYaml, TestConfLoad) {
 
     ASSERT_EQ(status.ok(), true);
 }
+
+TEST(TestYaml, TestConfSnapshot) {
+    fs::path config_yaml = fs::absolute(fs::path("tests/test_data") / "config.yaml");
+    YAML::Node root = YAML::LoadFile(config_yaml.string());
+    auto snapshot = alpheratz::conf::YamlConfig::Compile(root, 1);
+    ASSERT_EQ(snapshot->Version(), 1);
+
+    auto port = snapshot->Find("group.port");
+    ASSERT_TRUE(port.IsValid());
+    ASSERT_EQ(snapshot->Get<int>(port), 8080);
+    ASSERT_EQ(snapshot->Get<double>(port), 8080.0);
+    ASSERT_EQ(snapshot->Get<double>("group.ratio"), 0.75);
+    ASSERT_EQ(snapshot->Get<bool>("group.enable"), true);
+    ASSERT_EQ(snapshot->GetString(snapshot->Find("username")), "asdf");
+    // quoted scalar keeps string type
+    ASSERT_EQ(snapshot->GetString(snapshot->Find("group.code")), "123");
+    ASSERT_EQ(snapshot->Get<int>("group.code", -1), -1);
+    ASSERT_EQ(snapshot->GetString(snapshot->Find("group.servers.0.name")), "s1");
+    ASSERT_EQ(snapshot->Get<int>("group.servers.0.weight"), 2);
+
+    auto hosts = snapshot->GetIf<alpheratz::conf::ConfigArray>(snapshot->Find("group.hosts"));
+    ASSERT_NE(hosts, nullptr);
+    ASSERT_EQ(hosts->size(), 3);
+    ASSERT_EQ(std::get<std::string>((*hosts)[1]), "b");
+
+    auto missing = snapshot->Find("group.missing");
+    ASSERT_FALSE(missing.IsValid());
+    ASSERT_EQ(snapshot->Get<int>(missing, 7), 7);
+}
 int main(int argc, char **argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();